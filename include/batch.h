@@ -0,0 +1,65 @@
+#ifndef BATCH_HEADER
+#define BATCH_HEADER
+
+#include "standard.h"
+#include "parser.h"
+#include "lexer.h"
+
+/*
+ * "bat" stands for "batch".
+ * Lexes, parses and synthesizes many strings with the same lexer and parser.
+ * If BAT_THREADS is defined (and the program is linked with -pthread),
+ * the strings are shared out among worker threads; otherwise they are
+ * processed one after the other in the calling thread. The allocations
+ * tracked by ma (MA_TRACK) are not thread-safe, so BAT_THREADS excludes it.
+ */
+
+/*-------------------------*/
+/* macros                  */
+/*-------------------------*/
+
+/* how many strings a worker takes at a time */
+#define BAT_CHUNK_LENGTH 16
+
+/*-------------------------*/
+/* types                   */
+/*-------------------------*/
+
+/* what to do with each string; nothing in it is written to */
+typedef struct batPipeline {
+    const lexLexer* lexer;
+    const prSLRParser* parser;
+    /* may be NULL, and then the vals are all 0 */
+    lexStrToValFn str_to_val_fn;
+    prTerminalSynthFn terminal_synth_fn;
+    prProductionSynthFn production_synth_fn;
+    /* the size of an attribute */
+    unsigned element_size;
+}                           batPipeline;
+
+/*-------------------------*/
+/* functions               */
+/*-------------------------*/
+
+/* batPipeline */
+
+/*
+  lexes, parses and synthesizes each of the num_of_inputs strings, writing
+  the attribute of inputs[i] to results + i * element_size and whether it
+  was lexed to its end and parsed to out_successes[i] (the attribute is
+  left untouched otherwise); num_of_workers is the number of threads
+  (only 1 is used without BAT_THREADS), worker w of which passes
+  extras + w * extra_size as the extra of the callbacks of self (so they
+  may write to it), or NULL if extras is NULL;
+  returns the number of successes
+*/
+extern  unsigned    batPipeline_run(const batPipeline* self,
+                                    unsigned num_of_inputs,
+                                    const char* const* inputs,
+                                    unsigned num_of_workers,
+                                    void* extras,
+                                    unsigned extra_size,
+                                    void* results,
+                                    boolean* out_successes);
+
+#endif /* BATCH_HEADER */
@@ -2,6 +2,7 @@
 #define LEXER_HEADER
 
 #include "standard.h"
+#include "gs.h"
 #include "regex.h"
 
 /*
@@ -18,6 +19,33 @@
 
 typedef struct lexLexer lexLexer;
 
+/* where a token lies in the lexed string, as offsets */
+typedef struct lexTokenSpan {
+    unsigned start;
+    unsigned end;
+    /* lexing the token and the ignored tokens right after it looked
+       at the characters before this (past the 0 ending the string,
+       if it got there), so only they matter for them; it is at least
+       the examined end of the token before, so that it never decreases,
+       and after a re-lex it may be more than the examined end of
+       a fresh lexing */
+    unsigned examined_end;
+} lexTokenSpan;
+
+/* the outcome of lexing a string, kept so that the string
+   can be re-lexed after it is edited */
+typedef struct lexLexing {
+    /* not counting the 0 ending tokens */
+    unsigned num_of_tokens;
+    unsigned* tokens;
+    /* NULL if lexed without a lexStrToValFn */
+    unsigned* vals;
+    lexTokenSpan* spans;
+    /* the offset where lexing stopped, which is the length of the string
+       unless lexing failed there */
+    unsigned end_pos;
+} lexLexing;
+
 typedef unsigned        (*lexStrToValFn)(unsigned token,
                                          const char* str_start,
                                          const char* str_end,
@@ -32,6 +60,17 @@ typedef unsigned        (*lexStrToValFn)(unsigned token,
 extern  void        lexLexer_destroy(lexLexer* self);
 extern  lexLexer*   lexLexer_create_from_spec(const char *spec,
                                               const rexRegexSLRParser* regex_slr_parser);
+/*
+  like the above, also returning the compile stats of the patterns,
+  in *out_stats (to be freed by the caller), the i-th being of token i
+  (the 0-th, of <empty>, is all zeros), and their number in *out_num_of_stats;
+  on failure, the stats of the patterns up to the failed one
+  (including it) are returned
+*/
+extern  lexLexer*   lexLexer_create_from_spec_with_stats(const char *spec,
+                                                         const rexRegexSLRParser* regex_slr_parser,
+                                                         rexCompileStats** out_stats,
+                                                         unsigned* out_num_of_stats);
 
 extern  unsigned*   lexLexer_process(const lexLexer* self,
                                      const char* str,
@@ -39,6 +78,56 @@ extern  unsigned*   lexLexer_process(const lexLexer* self,
                                      void* extra,
                                      unsigned** out_vals,
                                      const char** out_end_pos);
+/* lexing never writes to the lexer, so that it can lex in several threads
+   at once; each lexing takes a rexRaceState for the lexer's regexes */
+extern  rexRaceState* lexLexer_create_race_state(const lexLexer* self);
+/* like lexLexer_process, but appends the tokens (with the 0 ending them)
+   and their vals (unless str_to_val_fn is NULL) to the given stacks of
+   unsigned, so that their memory can be reused from string to string,
+   as can race_state (if NULL, one is made for the call);
+   returns where lexing stopped */
+extern  const char* lexLexer_process_onto(const lexLexer* self,
+                                          const char* str,
+                                          lexStrToValFn str_to_val_fn,
+                                          void* extra,
+                                          gsStack* tokens,
+                                          gsStack* vals,
+                                          rexRaceState* race_state);
+
+/* lexLexing */
+
+extern  void        lexLexing_destroy_(lexLexing* self);
+/* lexes str as lexLexer_process does, also keeping the spans of the tokens;
+   str_to_val_fn may be NULL, and then there are no vals */
+extern  void        lexLexing_create_(lexLexing* self,
+                                      const lexLexer* lexer,
+                                      const char* str,
+                                      lexStrToValFn str_to_val_fn,
+                                      void* extra);
+/*
+  brings self up to date with str, which is the previously lexed string
+  with [edit_start, edit_old_end) replaced by edit_new_length characters
+  (the lexer and str_to_val_fn should be the same as before);
+  re-lexes only from the first token which looked at the edited characters
+  until the tokens fall in line with the old ones, and tells that
+  the tokens in [*out_first, *out_old_end) were replaced by
+  the *out_new_length ones from self->tokens + *out_first on
+  (which is what prSLRIncrementalParser_edit takes);
+  so the lexing an edit takes is in proportion to it, though the tokens,
+  vals and spans after it are still moved, and the spans after it
+  shifted, in time linear in their number
+*/
+extern  void        lexLexing_relex_(lexLexing* self,
+                                     const lexLexer* lexer,
+                                     const char* str,
+                                     unsigned edit_start,
+                                     unsigned edit_old_end,
+                                     unsigned edit_new_length,
+                                     lexStrToValFn str_to_val_fn,
+                                     void* extra,
+                                     unsigned* out_first,
+                                     unsigned* out_old_end,
+                                     unsigned* out_new_length);
 
 #ifdef TESTING_PRINTS
 extern  void        lexLexer_print(const lexLexer* self);
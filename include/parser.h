@@ -1,6 +1,8 @@
 #ifndef PARSER_HEADER
 #define PARSER_HEADER
 
+#include <stddef.h>
+
 #include "standard.h"
 
 /*
@@ -11,12 +13,110 @@
 /* macros                  */
 /*-------------------------*/
 
+/* the first child of a leaf of a prCst, and the next sibling of a last child */
+#define PR_CST_NONE ((unsigned) -1)
+
+/* the other_production of a prConflict between shifting and reducing */
+#define PR_CONFLICT_SHIFT ((unsigned) -1)
+
 /*-------------------------*/
 /* types                   */
 /*-------------------------*/
 
 typedef struct prGrammar    prGrammar;
 typedef struct prSLRParser  prSLRParser;
+typedef struct prSLRPushParser prSLRPushParser;
+typedef struct prSLRIncrementalParser prSLRIncrementalParser;
+
+typedef enum prParseStatus {
+    /* more tokens are expected */
+    PR_PARSE_CONTINUE,
+    PR_PARSE_ACCEPT,
+    PR_PARSE_REJECT
+}                           prParseStatus;
+
+/*
+  the tables of a parser, in a form which can be written out as C arrays
+  (as tools/prgen does) and wrapped by prSLRParser_create_from_tables;
+  the states and tokens are as in prSLRParser_parse
+*/
+typedef struct prSLRParserTables {
+    unsigned num_of_states;
+    unsigned num_of_tokens;
+    unsigned cosink;
+    unsigned reject;
+    unsigned num_of_productions;
+    /* of length num_of_states */
+    const boolean* sinks;
+    /* of length num_of_states * num_of_tokens,
+       indexed by state * num_of_tokens + token */
+    const unsigned* transition_table;
+    /* likewise, 1 + the production to reduce by, or 0 */
+    const unsigned* bt_table;
+    /* the body length and the head of each production, one after the other */
+    const unsigned* bt_list;
+}                           prSLRParserTables;
+
+/* a conflict of the parse tables: in state, on the terminal lookahead,
+   both production and other_production could be reduced by (or the
+   lookahead shifted, if other_production is PR_CONFLICT_SHIFT) */
+typedef struct prConflict {
+    unsigned state;
+    unsigned lookahead;
+    unsigned production;
+    unsigned other_production;
+}                           prConflict;
+
+/*
+  what prSLRParser_create_with_report found out building the tables,
+  to tune grammars for the table size and the parse speed; the states
+  are those of the LR(0) automaton, the reject state included
+*/
+typedef struct prSLRParserReport {
+    unsigned num_of_states;
+    /* the number of LR(0) items in each state */
+    unsigned* num_of_items;
+    unsigned num_of_conflicts;
+    prConflict* conflicts;
+    /* the entries on terminals and on nonterminals, and how many of them
+       shift, reduce or go to a state rather than reject */
+    unsigned num_of_action_entries;
+    unsigned num_of_filled_action_entries;
+    unsigned num_of_goto_entries;
+    unsigned num_of_filled_goto_entries;
+    /* the sizes in bytes of the tables, as in prSLRParserTables */
+    size_t sinks_size;
+    size_t transition_table_size;
+    size_t bt_table_size;
+    size_t bt_list_size;
+    /* the processor time taken by each step, in seconds;
+       lookahead_seconds is 0 unless the LALR(1) lookaheads are computed */
+    double first_follow_seconds;
+    double item_nfa_seconds;
+    double subset_construction_seconds;
+    double lookahead_seconds;
+    double action_filling_seconds;
+}                           prSLRParserReport;
+
+/*
+  a concrete syntax tree, as a struct of arrays (each of num_of_nodes
+  elements) in the same block of memory as the struct itself, so that
+  prCst_destroy frees it at once; the nodes are in the order of the
+  items of the parse, so that the children of a node come before it
+  and its subtree takes the subtree_size nodes up to it, the root last
+*/
+typedef struct prCst {
+    unsigned num_of_nodes;
+    /* the item: a token for a leaf, num_of_tokens + the production
+       for an inner node */
+    unsigned* kinds;
+    unsigned* first_children;
+    unsigned* next_siblings;
+    /* the span of the tokens below the node, [start, end) */
+    unsigned* starts;
+    unsigned* ends;
+    unsigned* subtree_sizes;
+}                           prCst;
 
 typedef void                (*prTerminalSynthFn)(unsigned token,
                                                  unsigned val,
@@ -25,6 +125,12 @@ typedef void                (*prTerminalSynthFn)(unsigned token,
 typedef void                (*prProductionSynthFn)(unsigned production,
                                                    void* attributes,
                                                    void* extra);
+/* count attributes, element_size bytes apart, starting at elements */
+typedef void                (*prListSynthFn)(unsigned list,
+                                             unsigned count,
+                                             const void* elements,
+                                             void* attribute,
+                                             void* extra);
 
 /*-------------------------*/
 /* functions               */
@@ -32,13 +138,49 @@ typedef void                (*prProductionSynthFn)(unsigned production,
 
 /* prGrammar */
 
+extern  unsigned        prGrammar_num_of_tokens(const prGrammar* self);
+
+extern  unsigned        prGrammar_num_of_productions(const prGrammar* self);
+
+/* the names are looked up in a perfect hash built with the grammar;
+   returns the number of tokens if there is no such token */
 extern  unsigned        prGrammar_token_by_name(const prGrammar* self,
                                                 const char *name);
 
+/* returns the number of productions if there is no such production */
 extern  unsigned        prGrammar_production_by_name(const prGrammar* self,
                                                      const char *name);
 
+/*
+  looks up each of the names once, so that the synthesis functions may
+  switch on the ids instead of comparing names; out_tokens[i] is as
+  prGrammar_token_by_name(self, names[i]);
+  returns whether all of the names were found
+*/
+extern  boolean         prGrammar_tokens_by_names(const prGrammar* self,
+                                                  unsigned num_of_names,
+                                                  const char* const* names,
+                                                  unsigned* out_tokens);
+
+/* as prGrammar_tokens_by_names, but for production names */
+extern  boolean         prGrammar_productions_by_names(
+                            const prGrammar* self,
+                            unsigned num_of_names,
+                            const char* const* names,
+                            unsigned* out_productions);
+
 extern  void            prGrammar_destroy(prGrammar* self);
+/*
+  the optional "@@precedence" section of the spec, between the
+  non-terminals and the productions, has lines of "@left", "@right" or
+  "@nonassoc" followed by terminals (or other names, only for "@prec"),
+  each line binding tighter than the ones above it; a production takes
+  the precedence of the last terminal of its body having one, or of NAME
+  if it ends with "@prec NAME"; the parsers built from the grammar then
+  resolve the conflicts between shifting a terminal and reducing by a
+  production which both have a precedence as yacc does
+  (see ./test/example_prec.grm)
+*/
 extern  prGrammar*      prGrammar_create_from_spec(const char* spec,
 						   char* out_diagnostic);
 extern  prGrammar*      prGrammar_create_from_spec_given_terminal_names(
@@ -47,16 +189,105 @@ extern  prGrammar*      prGrammar_create_from_spec_given_terminal_names(
     const char* const* terminal_names_list,
     char* out_diagnostic);
 
+/* the binary form of the grammar (its tokens, productions and names),
+   which prGrammar_create_from_binary reads back;
+   writes it to buffer unless it is NULL, and returns its size */
+extern  size_t          prGrammar_serialize(const prGrammar* self, void* buffer);
+/* NULL if buffer does not hold the binary form of a grammar
+   of this version, written on a platform with the same sizeof(unsigned) */
+extern  prGrammar*      prGrammar_create_from_binary(const void* buffer,
+                                                     size_t size,
+                                                     char* out_diagnostic);
+
 /* prSLRParser */
 
 extern  void            prSLRParser_destroy(prSLRParser* self);
 extern  prSLRParser*    prSLRParser_create_from_grammar(const prGrammar* grammar,
 							char* out_diagnostic);
+/* like the above, but with the (more precise) LALR(1) lookaheads,
+   so that it accepts every LALR(1) grammar rather than only the SLR ones;
+   the parser runs exactly as an SLR one */
+extern  prSLRParser*    prSLRParser_create_lalr_from_grammar(const prGrammar* grammar,
+                                                             char* out_diagnostic);
+
+/*
+  as prSLRParser_create_from_grammar, or prSLRParser_create_lalr_from_grammar
+  if is_lalr is true, but also fills out_report, whether or not a parser
+  is returned (what a failed building did not get to is left 0);
+  the building goes on past conflicts, so that all of them
+  are listed (out_diagnostic describing the first); out_report is freed
+  by prSLRParserReport_destroy_
+*/
+extern  prSLRParser*    prSLRParser_create_with_report(const prGrammar* grammar,
+                                                       boolean is_lalr,
+                                                       prSLRParserReport* out_report,
+                                                       char* out_diagnostic);
+
+/* prSLRParserReport */
+
+extern  void            prSLRParserReport_destroy_(prSLRParserReport* self);
+
+/* prSLRParser */
+
+/* views the tables of self (owned by self) */
+extern  void            prSLRParser_get_tables(const prSLRParser* self,
+                                               prSLRParserTables* out_tables);
+/* a parser using the tables, without copying them, so that they
+   may be static const arrays (as written out by tools/prgen),
+   and otherwise they should outlive the parser */
+extern  prSLRParser*    prSLRParser_create_from_tables(const prSLRParserTables* tables);
+
+/*
+  makes self skip the reductions by the unit productions (those whose body
+  is a single token) flagged in is_pass_through (indexed by production,
+  or NULL for all of them), so that for instance "S -> E", "E -> F",
+  "F -> G" no longer take three reductions after each G; the items then
+  lack most of these productions, so the synthesis function should just
+  pass the attribute through for them (it may still get some, as the
+  reductions right before accepting, or where skipping them would change
+  the states after, are kept); grammar should be the one self was created
+  from; the parse states which do these reductions are merged with the
+  ones after them, so self may grow a few states; the productions of the
+  lists (see prSLRParser_parse_and_synthesize_lists) and those having
+  lists in their bodies are never bypassed
+*/
+extern  void            prSLRParser_bypass_unit_productions(prSLRParser* self,
+                                                            const prGrammar* grammar,
+                                                            const boolean* is_pass_through);
+
+/* the binary form of the parse tables, which are stored as they are
+   in memory, so that prSLRParser_create_from_binary can use them in place;
+   writes it to buffer unless it is NULL, and returns its size */
+extern  size_t          prSLRParser_serialize(const prSLRParser* self,
+                                              void* buffer);
+/* a parser using the tables in buffer without copying or rebuilding
+   anything, so buffer (say, an mmap'd file) should be aligned for unsigned
+   and outlive the parser; NULL if buffer does not hold parse tables in
+   the binary form of this version, written on a platform with the same
+   type sizes, or if they have entries out of range */
+extern  prSLRParser*    prSLRParser_create_from_binary(const void* buffer,
+                                                       size_t size,
+                                                       char* out_diagnostic);
 
 extern  unsigned*       prSLRParser_parse(const prSLRParser* self,
                                           const unsigned* tokens,
                                           const unsigned** out_end_pos);
 
+/*
+  parses tokens without stopping at the first syntax error: after one,
+  the tokens up to the next synchronizing one (as listed in the optional
+  "@@synchronizing" section of the grammar spec, between the non-terminals
+  and the productions) are skipped, and the parser backs up until it can
+  go on with that token as if some non-terminal was just parsed;
+  returns the number of errors, and sets *out_error_positions to their
+  indices in tokens (to be freed by the caller);
+  grammar should be the one self was created from
+*/
+extern  unsigned        prSLRParser_parse_with_recovery(const prSLRParser* self,
+                                                        const prGrammar* grammar,
+                                                        const unsigned* tokens,
+                                                        unsigned** out_error_positions);
+
 /* an "item" here, item, encodes a token
    with serial number item if
    item < num_of_tokens of the grammar,
@@ -71,8 +302,123 @@ extern  void            prSLRParser_synthesize(const prSLRParser* self,
                                                void* extra,
                                                void* result);
 
+/* like prSLRParser_parse followed by prSLRParser_synthesize,
+   but in one pass, calling the synthesis functions as the parse goes;
+   returns false if the parse failed, in which case the attributes
+   synthesized so far are just dropped (so this suits attributes which
+   own no resources) and result is left untouched */
+extern  boolean         prSLRParser_parse_and_synthesize(const prSLRParser* self,
+                                                         const unsigned* tokens,
+                                                         const unsigned* vals,
+                                                         unsigned element_size,
+                                                         prTerminalSynthFn terminal_synth_fn,
+                                                         prProductionSynthFn production_synth_fn,
+                                                         void* extra,
+                                                         void* result,
+                                                         const unsigned** out_end_pos);
+
+/*
+  like prSLRParser_parse_and_synthesize, but the lists written with @*, @+
+  or @? in the grammar spec (such as <Arg*>, named in prGrammar_print)
+  are synthesized at once: their elements are gathered as they are
+  reduced, and once a list is complete, list_synth_fn is called with
+  the list token, the number of elements and their attributes, to write
+  the attribute of the list, instead of production_synth_fn being called
+  for each of its productions; production_synth_fn is still called for
+  the other productions, including that of a group @( ... @) followed
+  by one of those, which is unnamed; grammar should be the one self was
+  created from
+*/
+extern  boolean         prSLRParser_parse_and_synthesize_lists(const prSLRParser* self,
+                                                               const prGrammar* grammar,
+                                                               const unsigned* tokens,
+                                                               const unsigned* vals,
+                                                               unsigned element_size,
+                                                               prTerminalSynthFn terminal_synth_fn,
+                                                               prProductionSynthFn production_synth_fn,
+                                                               prListSynthFn list_synth_fn,
+                                                               void* extra,
+                                                               void* result,
+                                                               const unsigned** out_end_pos);
+
+/*
+  parses tokens into a concrete syntax tree of the items (so it lacks the
+  bypassed unit productions, if any), or NULL if the parse fails;
+  token_spans holds a span per token, span_size bytes apart, each starting
+  with the start and end offsets of the token (as the lexTokenSpan of
+  a lexLexing do), or is NULL, and then the token indices are the spans;
+  an empty production spans nothing, at the end of the tokens before it
+*/
+extern  prCst*          prSLRParser_parse_to_cst(const prSLRParser* self,
+                                                 const unsigned* tokens,
+                                                 const void* token_spans,
+                                                 unsigned span_size,
+                                                 const unsigned** out_end_pos);
+
+/* prCst */
+
+extern  void            prCst_destroy(prCst* self);
+
+/* prSLRPushParser */
+
+/*
+  a parse with an SLR parser which is fed the tokens one at a time,
+  rather than all of them upfront; the parser should outlive it
+*/
+
+extern  void            prSLRPushParser_destroy(prSLRPushParser* self);
+extern  prSLRPushParser* prSLRPushParser_create(const prSLRParser* parser);
+
+/* token should not be 0 (use finish instead);
+   once accepted or rejected, feeding does nothing */
+extern  prParseStatus   prSLRPushParser_feed(prSLRPushParser* self,
+                                             unsigned token);
+/* ends the input */
+extern  prParseStatus   prSLRPushParser_finish(prSLRPushParser* self);
+/* the number of fed tokens which were shifted (the parse may accept or
+   reject before shifting the last ones) */
+extern  unsigned        prSLRPushParser_num_of_consumed_tokens(const prSLRPushParser* self);
+/* if accepted, the items as returned by prSLRParser_parse
+   (to be freed by the caller), and NULL otherwise */
+extern  unsigned*       prSLRPushParser_release_items(prSLRPushParser* self);
+
+/* prSLRIncrementalParser */
+
+/*
+  a parse with an SLR parser of a token sequence which keeps being edited;
+  an edit is reparsed from the last checkpoint (taken every so many
+  tokens) before it, only up to where the parse stack is the same as
+  the old parse's was at the same token, after which the old items are
+  reused; the parser should outlive it; so the parsing an edit takes is
+  in proportion to it (and to the checkpoint interval), though the tokens
+  and items after it are still moved, and the checkpoints after it
+  renumbered, in time linear in their number
+*/
+
+extern  void            prSLRIncrementalParser_destroy(prSLRIncrementalParser* self);
+/* parses tokens (0-terminated) */
+extern  prSLRIncrementalParser* prSLRIncrementalParser_create(const prSLRParser* parser,
+                                                              const unsigned* tokens);
+/* replaces the tokens in [start, old_end) by the new_length tokens
+   at new_tokens, and reparses */
+extern  prParseStatus   prSLRIncrementalParser_edit(prSLRIncrementalParser* self,
+                                                    unsigned start,
+                                                    unsigned old_end,
+                                                    const unsigned* new_tokens,
+                                                    unsigned new_length);
+/* never PR_PARSE_CONTINUE, as the parse is always run to the end */
+extern  prParseStatus   prSLRIncrementalParser_status(const prSLRIncrementalParser* self);
+extern  unsigned        prSLRIncrementalParser_num_of_consumed_tokens(const prSLRIncrementalParser* self);
+/* if accepted, the items as returned by prSLRParser_parse
+   (owned by self, until the next edit), and NULL otherwise */
+extern  const unsigned* prSLRIncrementalParser_items(const prSLRIncrementalParser* self);
+/* how many tokens the last edit (or the creation) fed to the parser */
+extern  unsigned        prSLRIncrementalParser_num_of_reparsed_tokens(const prSLRIncrementalParser* self);
+
 #ifdef TESTING_PRINTS
 extern  void            prGrammar_print(const prGrammar* self);
+extern  void            prSLRParserReport_print(const prSLRParserReport* self,
+                                                const prGrammar* grammar);
 #endif /* TESTING_PRINTS */
 
 #endif /* PARSER_HEADER */
@@ -1,6 +1,8 @@
 #ifndef REGEX_HEADER
 #define REGEX_HEADER
 
+#include <stddef.h>
+
 #include "standard.h"
 
 /*
@@ -11,6 +13,18 @@
 /* macros                  */
 /*-------------------------*/
 
+/* regexes with counted repetitions {m}, {m,} or {m,n} whose bounds
+   exceed REX_MAX_REPEAT_BOUND, or which would unroll into more than
+   REX_MAX_REPEAT_NFA_LENGTH NFA states (the bounds of nested repetitions
+   multiplying), are rejected, as the DFA necessarily has a number of
+   states growing with the bounds */
+#define REX_MAX_REPEAT_BOUND 1024
+#define REX_MAX_REPEAT_NFA_LENGTH 65536
+
+/* the size of the out_diagnostic buffers, which the diagnostics
+   (with the 0 ending them) never exceed */
+#define REX_MAX_DIAGNOSTIC_LENGTH 128
+
 /*-------------------------*/
 /* types                   */
 /*-------------------------*/
@@ -18,6 +32,30 @@
 typedef struct rexRegexSLRParser    rexRegexSLRParser;
 typedef struct rexCompiledRegex     rexCompiledRegex;
 typedef struct rexCompiledRegexList rexCompiledRegexList;
+typedef struct rexRaceState         rexRaceState;
+typedef struct rexCompiledRegexSet  rexCompiledRegexSet;
+typedef struct rexCompiledRegexCache rexCompiledRegexCache;
+
+typedef void                        (*rexLockFn)(void* lock);
+
+/* what compiling a regex took; times are in seconds of processor time */
+typedef struct rexCompileStats {
+    /* the length of the parse of the regex */
+    unsigned num_of_parse_items;
+    unsigned num_of_nfa_states;
+    /* including the epsilon edges */
+    unsigned num_of_nfa_edges;
+    unsigned num_of_nfa_epsilon_edges;
+    unsigned num_of_dfa_states;
+    /* the number of classes of characters the DFA tells apart */
+    unsigned alphabet_size;
+    size_t table_bytes;
+    double preprocess_time;
+    double parse_time;
+    double synthesize_time;
+    double determinize_time;
+    double total_time;
+}                                   rexCompileStats;
 
 /*-------------------------*/
 /* functions               */
@@ -26,7 +64,18 @@ typedef struct rexCompiledRegexList rexCompiledRegexList;
 /* rexRegexSLRParser */
 
 extern  void                    rexRegexSLRParser_destroy(rexRegexSLRParser* self);
+/* wraps the parse tables baked into the library, so it costs nothing */
 extern  rexRegexSLRParser*      rexRegexSLRParser_create(void);
+/* builds the parser from the regex grammar, as tools/prgen does
+   to bake the tables in the first place, bypassing the unit productions
+   (see prSLRParser_bypass_unit_productions) */
+extern  rexRegexSLRParser*      rexRegexSLRParser_create_from_spec(void);
+/* as prSLRParser_serialize and prSLRParser_create_from_binary do,
+   so that the meta-parser can be loaded instead of built */
+extern  size_t                  rexRegexSLRParser_serialize(const rexRegexSLRParser* self,
+                                                            void* buffer);
+extern  rexRegexSLRParser*      rexRegexSLRParser_create_from_binary(const void* buffer,
+                                                                     size_t size);
 
 /* rexCompiledRegex */
 
@@ -40,18 +89,115 @@ extern  rexCompiledRegex*       rexCompiledRegex_create_from_raw_str(
     const char* str_start,
     const char* str_end);
 
+/* like the above, also filling out_stats (if not NULL), and writing
+   what failed to out_diagnostic (if not NULL, of REX_MAX_DIAGNOSTIC_LENGTH
+   chars) on failure;
+   on failure the times of the phases done are still filled */
+extern  rexCompiledRegex*       rexCompiledRegex_create_from_regex_with_stats(
+    const rexRegexSLRParser* regex_slr_parser,
+    const char* regex,
+    const char* regex_end,
+    rexCompileStats* out_stats,
+    char* out_diagnostic);
+extern  rexCompiledRegex*       rexCompiledRegex_create_from_raw_str_with_stats(
+    const rexRegexSLRParser* regex_slr_parser,
+    const char* str_start,
+    const char* str_end,
+    rexCompileStats* out_stats,
+    char* out_diagnostic);
+
+/* roughly the number of bytes the compiled regex occupies */
+extern  size_t                  rexCompiledRegex_memory_size(const rexCompiledRegex* self);
+
 extern  boolean                 rexCompiledRegex_accepts(const rexCompiledRegex* self,
                                                          const char* str);
 
 /* rexCompiledRegexList */
 
+/*
+  a list is never written to once created, so that it can race in several
+  threads at once: where a race is at is kept in a rexRaceState of the
+  caller's, one for each thread
+*/
+
 extern  void                    rexCompiledRegexList_destroy(rexCompiledRegexList* self);
 extern  rexCompiledRegexList*   rexCompiledRegexList_create_from_compiled_regex_list__(
     unsigned length,
     rexCompiledRegex** copmiled_regexes);
 
+extern  unsigned                rexCompiledRegexList_length(const rexCompiledRegexList* self);
+/* returns the regex winning the race on str, or the length of self if
+   none accepts a prefix of it, or if state has room for fewer regexes
+   than self holds (see rexCompiledRegexList_length) */
 extern  unsigned                rexCompiledRegexList_race(const rexCompiledRegexList* self,
+                                                          rexRaceState* state,
                                                           const char* str,
                                                           const char** out_end_pos);
+/* like the above, also setting *out_examined_end past the last character
+   the race looked at (past the 0 ending str, if it got there),
+   as the characters after it could not change the outcome */
+extern  unsigned                rexCompiledRegexList_race_examining(const rexCompiledRegexList* self,
+                                                                    rexRaceState* state,
+                                                                    const char* str,
+                                                                    const char** out_end_pos,
+                                                                    const char** out_examined_end);
+
+/* rexRaceState */
+
+extern  void                    rexRaceState_destroy(rexRaceState* self);
+/* a state for the races of lists of up to length regexes */
+extern  rexRaceState*           rexRaceState_create(unsigned length);
+
+/* rexCompiledRegexSet */
+
+/*
+  all the regexes are compiled into a single DFA, whose states know
+  which of the regexes accept, so that one scan finds all the regexes
+  accepting a string
+*/
+
+extern  void                    rexCompiledRegexSet_destroy(rexCompiledRegexSet* self);
+extern  rexCompiledRegexSet*    rexCompiledRegexSet_create_from_regexes(
+    const rexRegexSLRParser* regex_slr_parser,
+    unsigned length,
+    const char* const* regexes);
+
+extern  unsigned                rexCompiledRegexSet_length(const rexCompiledRegexSet* self);
+/* returns the number of regexes accepting str, and sets *out_patterns to
+   their serial numbers in increasing order (owned by self) */
+extern  unsigned                rexCompiledRegexSet_matches(const rexCompiledRegexSet* self,
+                                                            const char* str,
+                                                            const unsigned** out_patterns);
+
+/* rexCompiledRegexCache */
+
+/*
+  maps regexes to shared compiled regexes, so that acquiring an already
+  compiled regex costs a hash lookup.
+  compiled regexes which are no longer acquired by anyone are kept
+  until their total memory size (together with the acquired ones) exceeds
+  max_memory_size, and are then destroyed, least recently released first.
+  the cache may be used from several threads if lock_fn and unlock_fn are
+  given, which lock and unlock the given lock (say, a mutex); they are
+  not called while compiling.
+*/
+
+extern  void                    rexCompiledRegexCache_destroy(rexCompiledRegexCache* self);
+extern  rexCompiledRegexCache*  rexCompiledRegexCache_create(
+    const rexRegexSLRParser* regex_slr_parser,
+    size_t max_memory_size,
+    rexLockFn lock_fn,
+    rexLockFn unlock_fn,
+    void* lock);
+
+/* returns NULL if the regex could not be compiled;
+   otherwise the result should be released when no longer used */
+extern  const rexCompiledRegex* rexCompiledRegexCache_acquire(rexCompiledRegexCache* self,
+                                                              const char* regex,
+                                                              const char* regex_end);
+extern  void                    rexCompiledRegexCache_release(rexCompiledRegexCache* self,
+                                                              const rexCompiledRegex* compiled_regex);
+
+extern  size_t                  rexCompiledRegexCache_memory_size(const rexCompiledRegexCache* self);
 
 #endif /* REGEX_HEADER */
@@ -0,0 +1,181 @@
+#include "batch.h"
+
+#include <string.h>
+#ifdef BAT_THREADS
+#include <pthread.h>
+#endif /* BAT_THREADS */
+
+#include "standard.h"
+#include "ma.h"
+#include "gs.h"
+#include "parser.h"
+#include "regex.h"
+#include "lexer.h"
+
+#if defined(BAT_THREADS) && defined(MA_TRACK)
+#error "the allocations tracked by ma are not thread-safe, so \
+BAT_THREADS cannot be used with MA_TRACK"
+#endif
+
+/*-------------------------*/
+/* structs                 */
+/*-------------------------*/
+
+/* what the workers share */
+typedef struct _batShared {
+    const batPipeline* pipeline;
+    unsigned num_of_inputs;
+    const char* const* inputs;
+    unsigned char* results;
+    boolean* successes;
+    /* the first input no worker has taken yet */
+    unsigned next_input;
+#ifdef BAT_THREADS
+    pthread_mutex_t next_input_mutex;
+#endif /* BAT_THREADS */
+}                               _batShared;
+
+typedef struct _batWorker {
+    _batShared* shared;
+    void* extra;
+    unsigned num_of_successes;
+    /* reused from input to input */
+    gsStack tokens;
+    gsStack vals;
+    rexRaceState* race_state;
+}                               _batWorker;
+
+/*-------------------------*/
+
+/* takes the next chunk of inputs, [*out_first, *out_end),
+   unless there are none left */
+static boolean _batShared_take_(_batShared* self, unsigned* out_first,
+                                unsigned* out_end) {
+#ifdef BAT_THREADS
+    pthread_mutex_lock(&self->next_input_mutex);
+#endif /* BAT_THREADS */
+    *out_first = self->next_input;
+    *out_end = self->num_of_inputs - self->next_input > BAT_CHUNK_LENGTH ?
+        self->next_input + BAT_CHUNK_LENGTH : self->num_of_inputs;
+    self->next_input = *out_end;
+#ifdef BAT_THREADS
+    pthread_mutex_unlock(&self->next_input_mutex);
+#endif /* BAT_THREADS */
+    return *out_first < *out_end;
+}
+
+static boolean _batWorker_process_(_batWorker* self, unsigned input) {
+    const batPipeline* const pipeline = self->shared->pipeline;
+    gsStack_make_empty_(&self->tokens);
+    gsStack_make_empty_(&self->vals);
+    const char* const lex_end_pos =
+        lexLexer_process_onto(pipeline->lexer, self->shared->inputs[input],
+                              pipeline->str_to_val_fn, self->extra,
+                              &self->tokens, &self->vals, self->race_state);
+    if (*lex_end_pos != 0) {
+        return false;
+    }
+    if (pipeline->str_to_val_fn == NULL) {
+        gsStack_pre_append_several_(&self->vals,
+                                    gsStack_length(&self->tokens));
+        memset(gsStack_0(&self->vals), 0,
+               gsStack_length(&self->vals) * sizeof(unsigned));
+    }
+    const unsigned* parse_end_pos;
+    const boolean is_parsed =
+        prSLRParser_parse_and_synthesize(pipeline->parser,
+                                         gsStack_0(&self->tokens),
+                                         gsStack_0(&self->vals),
+                                         pipeline->element_size,
+                                         pipeline->terminal_synth_fn,
+                                         pipeline->production_synth_fn,
+                                         self->extra,
+                                         self->shared->results
+                                         + (size_t) input
+                                         * pipeline->element_size,
+                                         &parse_end_pos);
+    return is_parsed == true && *parse_end_pos == 0;
+}
+
+static void _batWorker_run_(_batWorker* self) {
+    unsigned first, end;
+    while (_batShared_take_(self->shared, &first, &end) == true) {
+        for (unsigned input = first; input < end; ++input) {
+            const boolean is_successful = _batWorker_process_(self, input);
+            self->shared->successes[input] = is_successful;
+            if (is_successful == true) {
+                ++self->num_of_successes;
+            }
+        }
+    }
+    return;
+}
+
+#ifdef BAT_THREADS
+static void* _batWorker_thread(void* worker) {
+    _batWorker_run_(worker);
+    return NULL;
+}
+#endif /* BAT_THREADS */
+
+unsigned batPipeline_run(const batPipeline* self, unsigned num_of_inputs,
+                         const char* const* inputs, unsigned num_of_workers,
+                         void* extras, unsigned extra_size, void* results,
+                         boolean* out_successes) {
+#ifndef BAT_THREADS
+    num_of_workers = 1;
+#endif /* BAT_THREADS */
+    if (num_of_workers == 0) {
+        num_of_workers = 1;
+    }
+    _batShared shared;
+    shared.pipeline = self;
+    shared.num_of_inputs = num_of_inputs;
+    shared.inputs = inputs;
+    shared.results = results;
+    shared.successes = out_successes;
+    shared.next_input = 0;
+    _batWorker* const workers = MALLOC(num_of_workers * sizeof(_batWorker));
+    for (unsigned w = 0; w < num_of_workers; ++w) {
+        workers[w].shared = &shared;
+        workers[w].extra =
+            extras == NULL ? NULL : (char*) extras + (size_t) w * extra_size;
+        workers[w].num_of_successes = 0;
+        gsStack_create_(&workers[w].tokens, sizeof(unsigned));
+        gsStack_create_(&workers[w].vals, sizeof(unsigned));
+        workers[w].race_state = lexLexer_create_race_state(self->lexer);
+    }
+
+#ifdef BAT_THREADS
+    pthread_mutex_init(&shared.next_input_mutex, NULL);
+    pthread_t* const threads = MALLOC(num_of_workers * sizeof(pthread_t));
+    boolean* const is_started = CALLOC(num_of_workers, sizeof(boolean));
+    /* worker 0 is this thread; if a thread fails to start,
+       the others take its share, as the inputs are taken by chunks */
+    for (unsigned w = 1; w < num_of_workers; ++w) {
+        is_started[w] = pthread_create(threads + w, NULL, _batWorker_thread,
+                                       workers + w) == 0;
+    }
+    _batWorker_run_(workers);
+    for (unsigned w = 1; w < num_of_workers; ++w) {
+        if (is_started[w] == true) {
+            pthread_join(threads[w], NULL);
+        }
+    }
+    FREE(is_started);
+    FREE(threads);
+    pthread_mutex_destroy(&shared.next_input_mutex);
+#else
+    _batWorker_run_(workers);
+#endif /* BAT_THREADS */
+
+    unsigned num_of_successes = 0;
+    for (unsigned w = 0; w < num_of_workers; ++w) {
+        num_of_successes += workers[w].num_of_successes;
+        gsStack_destroy_(&workers[w].tokens);
+        gsStack_destroy_(&workers[w].vals);
+        rexRaceState_destroy(workers[w].race_state);
+    }
+    FREE(workers);
+    return num_of_successes;
+}
@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h> /* for UINT_MAX */
 
 #include "standard.h"
 #include "ma.h"
@@ -131,7 +132,15 @@ void faNfa_add_edge_(faNfa* self, unsigned source, unsigned target,
     return;
 }
 
+/* prefixes nfa by a new cosink, which (unlike the old one)
+   is never the target of an edge, and so can be given an
+   epsilon edge to the sink without accepting anything else */
+static faNfa* _faNfa_with_fresh_cosink__(faNfa* nfa) {
+    return faNfa_prod__(faNfa_create_empty(), nfa);
+}
+
 faNfa* faNfa_question__(faNfa* nfa) {
+    nfa = _faNfa_with_fresh_cosink__(nfa);
     faNfa_add_edge_(nfa, nfa->cosink, nfa->sink, 0);
     return nfa;
 }
@@ -142,9 +151,7 @@ faNfa* faNfa_plus__(faNfa* nfa) {
 }
 
 faNfa* faNfa_star__(faNfa* nfa) {
-    faNfa_add_edge_(nfa, nfa->cosink, nfa->sink, 0);
-    faNfa_add_edge_(nfa, nfa->sink, nfa->cosink, 0);
-    return nfa;
+    return faNfa_question__(faNfa_plus__(nfa));
 }
 
 faNfa* faNfa_concat__(faNfa* nfa1, faNfa* nfa2) {
@@ -195,6 +202,72 @@ faNfa* faNfa_prod__(faNfa *nfa1, faNfa *nfa2) {
     return nfa;
 }
 
+faNfa* faNfa_repeat__(faNfa* nfa, unsigned min, unsignedMaybe max,
+                      unsigned max_length) {
+    const unsigned num_of_copies =
+        (unsignedMaybe_is(max) == true ? unsignedMaybe_value(max)
+         : (min == 0 ? 1 : min));
+    if ((uint64_t) num_of_copies * faNfa_length(nfa) > max_length) {
+        faNfa_destroy(nfa);
+        return NULL;
+    }
+    if (unsignedMaybe_is(max) == false) {
+        if (min == 0) {
+            return faNfa_star__(nfa);
+        }
+        /* nfa{m,} is nfa{m-1} followed by nfa+ */
+        return faNfa_prod__(faNfa_repeat__(faNfa_copy(nfa), min - 1,
+                                           unsignedMaybe_from_unsigned(min - 1),
+                                           max_length),
+                            faNfa_plus__(nfa));
+    }
+    const unsigned num_of_optional = unsignedMaybe_value(max) - min;
+    if (min + num_of_optional == 0) {
+        faNfa_destroy(nfa);
+        return faNfa_create_empty();
+    }
+
+    faNfa* result = NULL;
+    for (unsigned i = 0; i < min; ++i) {
+        faNfa* const part =
+            (i + 1 == min && num_of_optional == 0 ? nfa : faNfa_copy(nfa));
+        result = (result == NULL ? part : faNfa_prod__(result, part));
+    }
+    if (num_of_optional == 0) {
+        return result;
+    }
+
+    /*
+      the optional copies are chained, each entered only from the previous
+      one, and each may jump directly to a common exit state;
+      unlike chaining nfa? copies, the epsilon closures stay small,
+      so the subset construction does not blow up with the bound
+    */
+    faNfa* optional = NULL;
+    gsStack entries;
+    gsStack_create_(&entries, sizeof(unsigned));
+    for (unsigned i = 0; i < num_of_optional; ++i) {
+        faNfa* const part = _faNfa_with_fresh_cosink__(
+            i + 1 == num_of_optional ? nfa : faNfa_copy(nfa));
+        const unsigned offset =
+            (optional == NULL ? 0 : faNfa_length(optional));
+        GS_APPEND(&entries, offset + part->cosink, unsigned);
+        optional = (optional == NULL ? part : faNfa_prod__(optional, part));
+    }
+    faNfa_add_state_(optional);
+    const unsigned exit = faNfa_length(optional) - 1;
+    faNfa_add_edge_(optional, optional->sink, exit, 0);
+    const unsigned* const entries_end = gsStack_end(&entries);
+    for (const unsigned* entry = gsStack_0(&entries); entry < entries_end;
+         ++entry) {
+        faNfa_add_edge_(optional, *entry, exit, 0);
+    }
+    optional->sink = exit;
+    gsStack_destroy_(&entries);
+
+    return (result == NULL ? optional : faNfa_prod__(result, optional));
+}
+
 inline unsigned faDfa_length(const faDfa* self) {
     return self->num_of_states;
 }
@@ -239,16 +312,93 @@ boolean faDfa_accepts(const faDfa* self, const unsigned* tokens) {
     return false;
 }
 
-/* used in functions _fa_aux_produce_subset_edge_candidates
-   and faDfa_create_nfaec_with_subsets_ */
-typedef struct _faAuxSubsetEdge {
-    ssSubset target_subset;
-    unsigned token;
-} _faAuxSubsetEdge;
+/* used in the function faDfa_create_nfaec_with_subsets_:
+   the edges leaving a subset, by their tokens, in the order in which
+   the tokens first come up */
+typedef struct _faAuxSubsetEdges {
+    gsStack tokens;
+    /* the targets of the edges on tokens[i] are
+       targets[starts[i]], ..., targets[starts[i+1]-1] */
+    gsStack starts;
+    gsStack targets;
+} _faAuxSubsetEdges;
+
+static void _faAuxSubsetEdges_destroy_(_faAuxSubsetEdges* self) {
+    gsStack_destroy_(&self->tokens);
+    gsStack_destroy_(&self->starts);
+    gsStack_destroy_(&self->targets);
+    return;
+}
 
-/* used in the function faDfa_create_nfaec_with_subsets_ */
-static boolean _fa_aux_equal_subsets(const void* x, const void* y) {
-    return ssSubset_are_equal((ssSubset*) x, (ssSubset*) y);
+static void _faAuxSubsetEdges_create_(_faAuxSubsetEdges* self) {
+    gsStack_create_(&self->tokens, sizeof(unsigned));
+    gsStack_create_(&self->starts, sizeof(unsigned));
+    gsStack_create_(&self->targets, sizeof(unsigned));
+    return;
+}
+
+/* used in the function faDfa_create_nfaec_with_subsets_:
+   a hash table of the subsets found so far, by their indexes */
+typedef struct _faAuxSubsetIndex {
+    unsigned num_of_buckets;
+    /* index + 1 of the first subset in the bucket, or 0 */
+    unsigned* buckets;
+    /* next_in_bucket[index] is index + 1 of the next subset, or 0 */
+    gsStack next_in_bucket;
+} _faAuxSubsetIndex;
+
+static void _faAuxSubsetIndex_destroy_(_faAuxSubsetIndex* self) {
+    FREE(self->buckets);
+    gsStack_destroy_(&self->next_in_bucket);
+    return;
+}
+
+static void _faAuxSubsetIndex_create_(_faAuxSubsetIndex* self) {
+    self->num_of_buckets = 64;
+    self->buckets = CALLOC(self->num_of_buckets, sizeof(*self->buckets));
+    gsStack_create_(&self->next_in_bucket, sizeof(unsigned));
+    return;
+}
+
+static void _faAuxSubsetIndex_link_(_faAuxSubsetIndex* self,
+				    const ssSubset* subset, unsigned index) {
+    unsigned* const bucket =
+	self->buckets + ssSubset_hash(subset) % self->num_of_buckets;
+    ((unsigned*) gsStack_0(&self->next_in_bucket))[index] = *bucket;
+    *bucket = index + 1;
+    return;
+}
+
+/* the index of the subset among subsets, or the length of subsets */
+static unsigned _faAuxSubsetIndex_find(const _faAuxSubsetIndex* self,
+				       const gsStack* subsets,
+				       const ssSubset* subset) {
+    const unsigned* const next_in_bucket = gsStack_0(&self->next_in_bucket);
+    unsigned i = self->buckets[ssSubset_hash(subset) % self->num_of_buckets];
+    for (; i != 0; i = next_in_bucket[i-1]) {
+	if (ssSubset_are_equal(gsStack_element(subsets, i-1), subset) == true) {
+	    return i-1;
+	}
+    }
+    return gsStack_length(subsets);
+}
+
+/* the last of subsets should be the one added */
+static void _faAuxSubsetIndex_add_(_faAuxSubsetIndex* self,
+				   const gsStack* subsets) {
+    const unsigned length = gsStack_length(subsets);
+    gsStack_pre_append_(&self->next_in_bucket);
+    if (length > 2 * self->num_of_buckets) {
+	FREE(self->buckets);
+	self->num_of_buckets *= 4;
+	self->buckets = CALLOC(self->num_of_buckets, sizeof(*self->buckets));
+	for (unsigned i = 0; i < length; ++i) {
+	    _faAuxSubsetIndex_link_(self, gsStack_element(subsets, i), i);
+	}
+    } else {
+	_faAuxSubsetIndex_link_(self, gsStack_last(subsets), length - 1);
+    }
+    return;
 }
 
 /* used in the function faDfa_create_nfaec_with_subsets_ */
@@ -285,12 +435,21 @@ static void _faNfa_do_epsilon_closure_(const faNfa* nfa, ssSubset* states) {
     return;
 }
 
-/* used in the function faDfa_create_nfaec_with_subsets_ */
-static gsStack _fa_aux_produce_subset_edge_candidates(const faNfa* nfa,
-                                                      const ssSubset* source_subset) {
-    gsStack candidate_subset_edges;
-    gsStack_create_(&candidate_subset_edges, sizeof(_faAuxSubsetEdge));
+/* used in the function faDfa_create_nfaec_with_subsets_:
+   gathers the edges leaving source_subset into self (by a counting sort
+   on the tokens, so the targets of a token keep the order of the edges);
+   token_to_candidate should have all zeros, and is left so */
+static void _faAuxSubsetEdges_gather_(_faAuxSubsetEdges* self,
+                                      const faNfa* nfa,
+                                      const ssSubset* source_subset,
+                                      unsigned* token_to_candidate) {
+    gsStack_make_empty_(&self->tokens);
+    gsStack_make_empty_(&self->starts);
+    gsStack_make_empty_(&self->targets);
     const unsigned source_subset_length = ssSubset_length(source_subset);
+
+    /* first counting the edges on tokens[m-1] into starts[m] */
+    GS_APPEND(&self->starts, 0, unsigned);
     for (unsigned j = 0; j < source_subset_length; ++j) {
         const unsigned source = ssSubset_element(source_subset, j);
         const faNfaEdgeList* const edge_list = faNfa_edge_list(nfa, source);
@@ -300,32 +459,49 @@ static gsStack _fa_aux_produce_subset_edge_candidates(const faNfa* nfa,
             if (edge->token == 0) {
                 continue;
             }
-            boolean token_already_appeared = false;
-            _faAuxSubsetEdge* subset_edge;
-            const unsigned candidate_subset_edges_length =
-                gsStack_length(&candidate_subset_edges);
-            for (unsigned m = 0; m < candidate_subset_edges_length; ++m) {
-                subset_edge = (_faAuxSubsetEdge*) gsStack_element(
-                    &candidate_subset_edges, m);
-                if (edge->token == subset_edge->token) {
-                    token_already_appeared = true;
-                    break;
-                }
+            if (token_to_candidate[edge->token] == 0) {
+                GS_APPEND(&self->tokens, edge->token, unsigned);
+                GS_APPEND(&self->starts, 0, unsigned);
+                token_to_candidate[edge->token] =
+                    gsStack_length(&self->tokens);
             }
-            if (token_already_appeared == true) {
-                ssSubset_add_(&subset_edge->target_subset, edge->target);
-            } else {
-                gsStack_pre_append_(&candidate_subset_edges);
-                _faAuxSubsetEdge* const new_subset_edge =
-                    (_faAuxSubsetEdge*) gsStack_last(&candidate_subset_edges);
-                ssSubset_create_(&new_subset_edge->target_subset,
-				 faNfa_length(nfa));
-                ssSubset_add_(&new_subset_edge->target_subset, edge->target);
-                new_subset_edge->token = edge->token;
+            ++((unsigned*) gsStack_0(&self->starts))
+                [token_to_candidate[edge->token]];
+        }
+    }
+    const unsigned num_of_candidates = gsStack_length(&self->tokens);
+    unsigned* const starts = gsStack_0(&self->starts);
+    unsigned num_of_targets = 0;
+    for (unsigned m = 1; m <= num_of_candidates; ++m) {
+        const unsigned count = starts[m];
+        starts[m] = num_of_targets;
+        num_of_targets += count;
+    }
+
+    /* then placing them, starts[m] standing for the end of the targets
+       on tokens[m-1] placed so far, which ends up at the start of those
+       on tokens[m] */
+    if (num_of_targets != 0) {
+        gsStack_pre_append_several_(&self->targets, num_of_targets);
+    }
+    unsigned* const targets = gsStack_0(&self->targets);
+    for (unsigned j = 0; j < source_subset_length; ++j) {
+        const unsigned source = ssSubset_element(source_subset, j);
+        const faNfaEdgeList* const edge_list = faNfa_edge_list(nfa, source);
+        const unsigned edge_list_length = faNfaEdgeList_length(edge_list);
+        for (unsigned k = 0; k < edge_list_length; ++k) {
+            const faNfaEdge* const edge = faNfaEdgeList_edge(edge_list, k);
+            if (edge->token == 0) {
+                continue;
             }
+            targets[starts[token_to_candidate[edge->token]]++] = edge->target;
         }
     }
-    return candidate_subset_edges;
+
+    for (unsigned m = 0; m < num_of_candidates; ++m) {
+        token_to_candidate[((unsigned*) gsStack_0(&self->tokens))[m]] = 0;
+    }
+    return;
 }
 
 void faDfa_create_nfaec_with_subsets_(faDfa* self, gsStack* subsets,
@@ -358,12 +534,17 @@ void faDfa_create_nfaec_with_subsets_(faDfa* self, gsStack* subsets,
     gsStack transition_table, sinks;
     gsStack_create_(&transition_table, self->num_of_tokens * sizeof(unsigned));
     gsStack_create_(&sinks, sizeof(boolean));
+    _faAuxSubsetIndex subset_index;
+    _faAuxSubsetIndex_create_(&subset_index);
+    unsigned* const token_to_candidate =
+        CALLOC(self->num_of_tokens, sizeof(*token_to_candidate));
 
     /* add the empty set, which will serve as a reject state */
     gsStack_pre_append_(subsets);
     ssSubset_create_((ssSubset*) gsStack_last(subsets), faNfa_length(nfa));
     is_in = ssSubset_is_in((ssSubset*) gsStack_last(subsets), nfa->sink);
     GS_APPEND(&sinks, is_in, boolean);
+    _faAuxSubsetIndex_add_(&subset_index, subsets);
     self->reject = self->num_of_states++;
     gsStack_pre_append_(&transition_table);
     for (unsigned i = 0; i < self->num_of_tokens; ++i) {
@@ -378,63 +559,74 @@ void faDfa_create_nfaec_with_subsets_(faDfa* self, gsStack* subsets,
     GS_APPEND(&sinks,
 	      ssSubset_is_in((ssSubset*) gsStack_last(subsets), nfa->sink),
 	      boolean);
+    _faAuxSubsetIndex_add_(&subset_index, subsets);
     self->cosink = self->num_of_states++;
     gsStack_pre_append_(&transition_table);
     for (unsigned i = 0; i < self->num_of_tokens; ++i) {
         ((unsigned*) gsStack_last(&transition_table))[i] = self->reject;
     }
     
+    /* the targets of the edges on a token, and their epsilon closure,
+       are gathered in one scratch subset (emptied by clearing just the
+       words of its elements), copied only if it is a new state */
+    _faAuxSubsetEdges subset_edges;
+    _faAuxSubsetEdges_create_(&subset_edges);
+    ssSubset target_subset;
+    ssSubset_create_(&target_subset, faNfa_length(nfa));
     unsigned previous_length = 0;
     unsigned current_length = gsStack_length(subsets);
     while (previous_length < current_length) {
         for (unsigned i = previous_length; i < current_length; ++i) {
-            const ssSubset* const source_subset =
-                (ssSubset*) gsStack_element(subsets, i);
-            gsStack candidate_subset_edges =
-                _fa_aux_produce_subset_edge_candidates(nfa, source_subset);
-            const unsigned candidate_subset_edges_length =
-                gsStack_length(&candidate_subset_edges);
-            for (unsigned j = 0; j < candidate_subset_edges_length; ++j) {
-                _faAuxSubsetEdge* const candidate_subset_edge =
-                    (_faAuxSubsetEdge *) gsStack_element(&candidate_subset_edges, j);
-                unsigned source, target, token;
-                _faNfa_do_epsilon_closure_(nfa, &candidate_subset_edge->target_subset);
-                unsigned index =
-                    gsStack_element_index(subsets,
-                                          &candidate_subset_edge->target_subset,
-                                          _fa_aux_equal_subsets);
-                if (index != gsStack_length(subsets)) {
-                    source = i;
-                    target = index;
-                    token = candidate_subset_edge->token;
-                    ((unsigned*) gsStack_0(&transition_table))
-			[source * self->num_of_tokens + token] = target;
-                    ssSubset_destroy_(&candidate_subset_edge->target_subset);
-                } else {
-                    GS_APPEND(subsets, candidate_subset_edge->target_subset,
-                              ssSubset);
+            _faAuxSubsetEdges_gather_(&subset_edges, nfa,
+                                      gsStack_element(subsets, i),
+                                      token_to_candidate);
+            const unsigned* const tokens = gsStack_0(&subset_edges.tokens);
+            const unsigned* const starts = gsStack_0(&subset_edges.starts);
+            const unsigned* const targets = gsStack_0(&subset_edges.targets);
+            const unsigned num_of_candidates =
+                gsStack_length(&subset_edges.tokens);
+            for (unsigned j = 0; j < num_of_candidates; ++j) {
+                ssSubset_make_empty_(&target_subset);
+                for (unsigned k = starts[j]; k < starts[j+1]; ++k) {
+                    ssSubset_add_(&target_subset, targets[k]);
+                }
+                _faNfa_do_epsilon_closure_(nfa, &target_subset);
+                unsigned target =
+                    _faAuxSubsetIndex_find(&subset_index, subsets,
+                                           &target_subset);
+                if (target == gsStack_length(subsets)) {
+                    gsStack_pre_append_(subsets);
+                    ssSubset_create_((ssSubset*) gsStack_last(subsets),
+                                     faNfa_length(nfa));
+                    /* element by element, to keep their order */
+                    const unsigned length = ssSubset_length(&target_subset);
+                    for (unsigned k = 0; k < length; ++k) {
+                        ssSubset_add_((ssSubset*) gsStack_last(subsets),
+                                      ssSubset_element(&target_subset, k));
+                    }
+                    _faAuxSubsetIndex_add_(&subset_index, subsets);
                     GS_APPEND(&sinks,
-			      ssSubset_is_in((ssSubset*) gsStack_last(subsets),
-					     nfa->sink), boolean);
+			      ssSubset_is_in(&target_subset, nfa->sink),
+			      boolean);
                     ++self->num_of_states;
                     gsStack_pre_append_(&transition_table);
-                    for (unsigned i = 0; i < self->num_of_tokens; ++i) {
-                        ((unsigned*) gsStack_last(&transition_table))[i] =
+                    for (unsigned t = 0; t < self->num_of_tokens; ++t) {
+                        ((unsigned*) gsStack_last(&transition_table))[t] =
                             self->reject;
                     }
-                    source = i;
-                    target = gsStack_length(subsets) - 1;
-                    token = candidate_subset_edge->token;
-                    ((unsigned*) gsStack_0(&transition_table))
-			[source * self->num_of_tokens + token] = target;
                 }
+                ((unsigned*) gsStack_0(&transition_table))
+                    [i * self->num_of_tokens + tokens[j]] = target;
             }
-            gsStack_destroy_(&candidate_subset_edges);
         }
         previous_length = current_length;
         current_length = gsStack_length(subsets);
     }
 
+    ssSubset_destroy_(&target_subset);
+    _faAuxSubsetEdges_destroy_(&subset_edges);
+    FREE(token_to_candidate);
+    _faAuxSubsetIndex_destroy_(&subset_index);
     self->transition_table = gsStack_0(&transition_table);
     self->sinks = gsStack_0(&sinks);
     return;
@@ -478,17 +670,22 @@ void faDfaOfChars_destroy(faDfaOfChars* self) {
     return;
 }
 
-boolean faDfaOfChars_accepts(const faDfaOfChars* self,
-                             const char* str) {
+unsigned faDfaOfChars_state_after(const faDfaOfChars* self, const char* str) {
     unsigned state = self->dfa.cosink;
     for (const char* token = str; *token != 0; ++token) {
         state =
             faDfa_goto(&self->dfa, state,
 		       self->char_to_token_table[(unsigned char) *token]);
         if (state == self->dfa.reject) {
-            return false;
+            return state;
         }
     }
+    return state;
+}
+
+boolean faDfaOfChars_accepts(const faDfaOfChars* self,
+                             const char* str) {
+    const unsigned state = faDfaOfChars_state_after(self, str);
     if (self->dfa.sinks[state] == true) {
         return true;
     }
@@ -498,7 +695,8 @@ boolean faDfaOfChars_accepts(const faDfaOfChars* self,
 unsigned faDfaOfChars_race(unsigned length, const faDfaOfChars* const* selves,
                            const char* str,
                            faDfaOfCharsRaceAux* aux,
-                           const char** out_end_pos) {
+                           const char** out_end_pos,
+                           const char** out_examined_end) {
     unsigned num_of_rejected = 0;
     boolean found_someone = false;
     unsigned winner;
@@ -508,10 +706,17 @@ unsigned faDfaOfChars_race(unsigned length, const faDfaOfChars* const* selves,
             aux[i].rejected = false;
         } else {
             aux[i].rejected = true;
+            ++num_of_rejected;
         }
     }
     const char* cursor = str;
+    /* the characters looked at are those before examined_end */
+    const char* examined_end = cursor;
+    if (num_of_rejected == length) {
+        goto exit_all_fors;
+    }
     for(;;) {
+        examined_end = cursor;
         for (unsigned i = 0; i < length; ++i) {
             if (aux[i].rejected == false) {
                 if (aux[i].state == selves[i]->dfa.reject) {
@@ -528,6 +733,7 @@ unsigned faDfaOfChars_race(unsigned length, const faDfaOfChars* const* selves,
             }
         }
         if (*cursor == 0) {
+            examined_end = cursor + 1;
             break;
         }
         for (unsigned i = 0; i < length; ++i) {
@@ -542,6 +748,9 @@ unsigned faDfaOfChars_race(unsigned length, const faDfaOfChars* const* selves,
     }
 
     exit_all_fors:;
+    if (out_examined_end != NULL) {
+        *out_examined_end = examined_end;
+    }
     if (found_someone == true) {
         *out_end_pos = aux[winner].accept;
         return winner;
@@ -551,7 +760,7 @@ unsigned faDfaOfChars_race(unsigned length, const faDfaOfChars* const* selves,
 }
 
 void faDfaBt_destroy_(faDfaBt* self) {
-    if (self == NULL) {
+    if (self == NULL || self->are_tables_borrowed == true) {
         return;
     }
     faDfa_destroy_(&self->dfa);
@@ -569,39 +778,484 @@ void faDfaBt_destroy(faDfaBt* self) {
     return;
 }
 
-unsigned* faDfaBt_parse(const faDfaBt* self, const unsigned* tokens,
-                        const unsigned** out_end_pos) {
-    boolean successful;
-    gsStack path, parse_items;
-    gsStack_create_(&path, sizeof(unsigned));
-    gsStack_create_(&parse_items, sizeof(unsigned));
-    GS_APPEND(&path, self->dfa.cosink, unsigned);
+/* the header of the binary form of a faDfaBt, all unsigned */
+enum {
+    _FA_BINARY_MAGIC,
+    _FA_BINARY_VERSION,
+    _FA_BINARY_SIZEOF_UNSIGNED,
+    _FA_BINARY_SIZEOF_BOOLEAN,
+    _FA_BINARY_SIZEOF_BT_ITEM,
+    _FA_BINARY_NUM_OF_STATES,
+    _FA_BINARY_NUM_OF_TOKENS,
+    _FA_BINARY_COSINK,
+    _FA_BINARY_REJECT,
+    _FA_BINARY_BT_LIST_LENGTH,
+    _FA_BINARY_HEADER_LENGTH
+};
 
-    const unsigned* cursor = tokens;
-    for (;;) {
+/* sizes in the binary form are rounded up to whole unsigneds,
+   to keep the tables after them aligned */
+static size_t _fa_binary_round_up(size_t size) {
+    return (size + sizeof(unsigned) - 1) / sizeof(unsigned) * sizeof(unsigned);
+}
+
+/* appends size bytes to the buffer at *cursor, unless it is NULL */
+static void _fa_binary_write(unsigned char** cursor, const void* data,
+                             size_t size) {
+    if (*cursor != NULL) {
+        memcpy(*cursor, data, size);
+        memset(*cursor + size, 0, _fa_binary_round_up(size) - size);
+        *cursor += _fa_binary_round_up(size);
+    }
+    return;
+}
+
+size_t faDfaBt_serialize(const faDfaBt* self, void* buffer) {
+    const size_t table_size = (size_t) self->dfa.num_of_states
+        * self->dfa.num_of_tokens * sizeof(unsigned);
+    const size_t sinks_size = self->dfa.num_of_states * sizeof(boolean);
+    const size_t bt_list_size = self->bt_list_length * sizeof(faBtItem);
+    unsigned header[_FA_BINARY_HEADER_LENGTH];
+    header[_FA_BINARY_MAGIC] = FA_DFA_BT_BINARY_MAGIC;
+    header[_FA_BINARY_VERSION] = FA_DFA_BT_BINARY_VERSION;
+    header[_FA_BINARY_SIZEOF_UNSIGNED] = sizeof(unsigned);
+    header[_FA_BINARY_SIZEOF_BOOLEAN] = sizeof(boolean);
+    header[_FA_BINARY_SIZEOF_BT_ITEM] = sizeof(faBtItem);
+    header[_FA_BINARY_NUM_OF_STATES] = self->dfa.num_of_states;
+    header[_FA_BINARY_NUM_OF_TOKENS] = self->dfa.num_of_tokens;
+    header[_FA_BINARY_COSINK] = self->dfa.cosink;
+    header[_FA_BINARY_REJECT] = self->dfa.reject;
+    header[_FA_BINARY_BT_LIST_LENGTH] = self->bt_list_length;
+    unsigned char* cursor = buffer;
+    _fa_binary_write(&cursor, header, sizeof(header));
+    _fa_binary_write(&cursor, self->dfa.sinks, sinks_size);
+    _fa_binary_write(&cursor, self->dfa.transition_table, table_size);
+    _fa_binary_write(&cursor, self->bt_table, table_size);
+    _fa_binary_write(&cursor, self->bt_list, bt_list_size);
+    return sizeof(header) + _fa_binary_round_up(sinks_size) + 2 * table_size
+        + _fa_binary_round_up(bt_list_size);
+}
+
+/*
+  whether parsing with the tables of self, read from a binary form, stays
+  inside them: every transition and bt_id is in range, and no backtrack
+  pops more states than the path to its state holds, which is at least
+  the distance of that state from the cosink (the parse stack always
+  being a path of the dfa from the cosink)
+*/
+static boolean _faDfaBt_are_tables_valid(const faDfaBt* self) {
+    const unsigned num_of_states = self->dfa.num_of_states;
+    const unsigned num_of_tokens = self->dfa.num_of_tokens;
+    const size_t table_length = (size_t) num_of_states * num_of_tokens;
+    for (size_t i = 0; i < table_length; ++i) {
+        if (self->dfa.transition_table[i] >= num_of_states
+            || self->bt_table[i] > self->bt_list_length) {
+            return false;
+        }
+    }
+    /* the distances are less than the number of states, which so bounds
+       the steps of every item, even of those no state uses (as the ones
+       bypassed) */
+    for (unsigned i = 0; i < self->bt_list_length; ++i) {
+        if (self->bt_list[i].replacing_token >= num_of_tokens
+            || self->bt_list[i].num_of_steps >= num_of_states) {
+            return false;
+        }
+    }
+
+    /* breadth first, so that each state is reached by a shortest path */
+    boolean is_valid = true;
+    unsigned* const distances = MALLOC(num_of_states * sizeof(unsigned));
+    unsigned* const queue = MALLOC(num_of_states * sizeof(unsigned));
+    for (unsigned state = 0; state < num_of_states; ++state) {
+        distances[state] = UINT_MAX;
+    }
+    distances[self->dfa.cosink] = 0;
+    queue[0] = self->dfa.cosink;
+    unsigned queue_end = 1;
+    for (unsigned i = 0; i < queue_end && is_valid == true; ++i) {
+        const unsigned state = queue[i];
+        for (unsigned token = 0; token < num_of_tokens; ++token) {
+            const unsigned bt_id =
+                self->bt_table[state * num_of_tokens + token];
+            if (bt_id != 0
+                && self->bt_list[bt_id - 1].num_of_steps > distances[state]) {
+                is_valid = false;
+                break;
+            }
+            const unsigned target = faDfa_goto(&self->dfa, state, token);
+            if (distances[target] == UINT_MAX) {
+                distances[target] = distances[state] + 1;
+                queue[queue_end] = target;
+                ++queue_end;
+            }
+        }
+    }
+    FREE(queue);
+    FREE(distances);
+    return is_valid;
+}
+
+boolean faDfaBt_create_from_binary_(faDfaBt* self, const void* buffer,
+                                    size_t size) {
+    const unsigned* const header = buffer;
+    if (size < _FA_BINARY_HEADER_LENGTH * sizeof(unsigned)
+        || header[_FA_BINARY_MAGIC] != FA_DFA_BT_BINARY_MAGIC
+        || header[_FA_BINARY_VERSION] != FA_DFA_BT_BINARY_VERSION
+        || header[_FA_BINARY_SIZEOF_UNSIGNED] != sizeof(unsigned)
+        || header[_FA_BINARY_SIZEOF_BOOLEAN] != sizeof(boolean)
+        || header[_FA_BINARY_SIZEOF_BT_ITEM] != sizeof(faBtItem)
+        || header[_FA_BINARY_COSINK] >= header[_FA_BINARY_NUM_OF_STATES]
+        || header[_FA_BINARY_REJECT] >= header[_FA_BINARY_NUM_OF_STATES]) {
+        return false;
+    }
+    self->dfa.num_of_states = header[_FA_BINARY_NUM_OF_STATES];
+    self->dfa.num_of_tokens = header[_FA_BINARY_NUM_OF_TOKENS];
+    self->dfa.cosink = header[_FA_BINARY_COSINK];
+    self->dfa.reject = header[_FA_BINARY_REJECT];
+    self->bt_list_length = header[_FA_BINARY_BT_LIST_LENGTH];
+    self->are_tables_borrowed = true;
+    /* each table is checked against what is left of the buffer, by
+       division, so that no size overflows */
+    size_t left = size - _FA_BINARY_HEADER_LENGTH * sizeof(unsigned);
+    if (self->dfa.num_of_tokens == 0
+        || self->dfa.num_of_states > left / sizeof(boolean)) {
+        return false;
+    }
+    const size_t sinks_size = self->dfa.num_of_states * sizeof(boolean);
+    if (_fa_binary_round_up(sinks_size) > left) {
+        return false;
+    }
+    left -= _fa_binary_round_up(sinks_size);
+    if (self->dfa.num_of_states
+        > left / 2 / sizeof(unsigned) / self->dfa.num_of_tokens) {
+        return false;
+    }
+    const size_t table_size = (size_t) self->dfa.num_of_states
+        * self->dfa.num_of_tokens * sizeof(unsigned);
+    left -= 2 * table_size;
+    if (self->bt_list_length > left / sizeof(faBtItem)) {
+        return false;
+    }
+    /* the tables are never written to, so casting the const away is fine */
+    unsigned char* cursor =
+        (unsigned char*) (header + _FA_BINARY_HEADER_LENGTH);
+    self->dfa.sinks = (boolean*) cursor;
+    cursor += _fa_binary_round_up(sinks_size);
+    self->dfa.transition_table = (unsigned*) cursor;
+    cursor += table_size;
+    self->bt_table = (unsigned*) cursor;
+    cursor += table_size;
+    self->bt_list = (faBtItem*) cursor;
+    return _faDfaBt_are_tables_valid(self);
+}
+
+/* the state of faDfaBt_bypass_unit_reductions_ */
+typedef struct _faBypass {
+    const faDfaBt* dfa_bt;
+    const boolean* is_bypassable;
+    unsigned first_nonterminal;
+    /* for each old state, the head of the bypassable reductions it does,
+       or 0 if it does none (or they have several heads) */
+    unsigned* heads;
+    /* the tables of the old states and then of the merged ones, with the
+       transitions still leading to old states */
+    gsStack sinks;
+    gsStack transitions;
+    gsStack bt_table;
+    /* triples: an old state, the state merged into it, the merged state */
+    gsStack merged;
+}                                _faBypass;
+
+static boolean _faBypass_is_bypassed(const _faBypass* self, unsigned bt_id,
+                                     unsigned head) {
+    if (bt_id == 0 || self->is_bypassable[bt_id-1] == false) {
+        return false;
+    }
+    const faBtItem* const bt = self->dfa_bt->bt_list + bt_id - 1;
+    return bt->num_of_steps == 1 && bt->replacing_token == head;
+}
+
+static void _faBypass_create_(_faBypass* self, const faDfaBt* dfa_bt,
+                              const boolean* is_bypassable,
+                              unsigned first_nonterminal) {
+    const unsigned num_of_states = dfa_bt->dfa.num_of_states;
+    const unsigned num_of_tokens = dfa_bt->dfa.num_of_tokens;
+    const size_t table_length = (size_t) num_of_states * num_of_tokens;
+    self->dfa_bt = dfa_bt;
+    self->is_bypassable = is_bypassable;
+    self->first_nonterminal = first_nonterminal;
+    self->heads = CALLOC(num_of_states, sizeof(unsigned));
+    for (unsigned state = 0; state < num_of_states; ++state) {
+        if (dfa_bt->dfa.sinks[state] == true || state == dfa_bt->dfa.reject) {
+            continue;
+        }
+        for (unsigned token = 0; token < first_nonterminal; ++token) {
+            const unsigned bt_id =
+                dfa_bt->bt_table[state * num_of_tokens + token];
+            if (bt_id == 0 || is_bypassable[bt_id-1] == false
+                || dfa_bt->bt_list[bt_id-1].num_of_steps != 1) {
+                continue;
+            }
+            const unsigned head = dfa_bt->bt_list[bt_id-1].replacing_token;
+            if (self->heads[state] == 0) {
+                self->heads[state] = head;
+            } else if (self->heads[state] != head) {
+                self->heads[state] = 0;
+                break;
+            }
+        }
+    }
+    gsStack_create_with_length_(&self->sinks, sizeof(boolean), num_of_states);
+    memcpy(gsStack_0(&self->sinks), dfa_bt->dfa.sinks,
+           num_of_states * sizeof(boolean));
+    gsStack_create_with_length_(&self->transitions, sizeof(unsigned),
+                                table_length);
+    memcpy(gsStack_0(&self->transitions), dfa_bt->dfa.transition_table,
+           table_length * sizeof(unsigned));
+    gsStack_create_with_length_(&self->bt_table, sizeof(unsigned),
+                                table_length);
+    memcpy(gsStack_0(&self->bt_table), dfa_bt->bt_table,
+           table_length * sizeof(unsigned));
+    gsStack_create_(&self->merged, 3 * sizeof(unsigned));
+    return;
+}
+
+static void _faBypass_destroy_(_faBypass* self) {
+    FREE(self->heads);
+    gsStack_destroy_(&self->sinks);
+    gsStack_destroy_(&self->transitions);
+    gsStack_destroy_(&self->bt_table);
+    gsStack_destroy_(&self->merged);
+    return;
+}
+
+/*
+  the state to go to from state on token, after which the parse would do
+  the bypassable reductions of the old state it goes to: that state merged
+  with the one the parse would then go to from state on the head of those
+  reductions (so that the parse stack stays as deep), unless some goto
+  of the two differs, or the head's state accepts
+*/
+static unsigned _faBypass_target(_faBypass* self, unsigned state,
+                                 unsigned token, unsigned depth) {
+    const faDfaBt* const dfa_bt = self->dfa_bt;
+    const unsigned num_of_tokens = dfa_bt->dfa.num_of_tokens;
+    const unsigned old = ((unsigned*) gsStack_0(&self->transitions))
+        [state * num_of_tokens + token];
+    const unsigned head = self->heads[old];
+    /* a cycle of unit productions makes the grammar ambiguous anyway */
+    if (head == 0 || depth > dfa_bt->dfa.num_of_states) {
+        return old;
+    }
+    const unsigned other = _faBypass_target(self, state, head, depth + 1);
+    if (other == dfa_bt->dfa.reject
+        || ((boolean*) gsStack_0(&self->sinks))[other] == true) {
+        return old;
+    }
+    const unsigned* const merged_end = gsStack_end(&self->merged);
+    for (const unsigned* merged = gsStack_0(&self->merged);
+         merged < merged_end; merged += 3) {
+        if (merged[0] == old && merged[1] == other) {
+            return merged[2];
+        }
+    }
+
+    unsigned merged_state = gsStack_length(&self->sinks);
+    gsStack_pre_append_several_(&self->transitions, num_of_tokens);
+    gsStack_pre_append_several_(&self->bt_table, num_of_tokens);
+    const unsigned* const transitions = gsStack_0(&self->transitions);
+    const unsigned* const bt_table = gsStack_0(&self->bt_table);
+    unsigned* const merged_transitions =
+        (unsigned*) gsStack_end(&self->transitions) - num_of_tokens;
+    unsigned* const merged_bt_table =
+        (unsigned*) gsStack_end(&self->bt_table) - num_of_tokens;
+    for (unsigned t = 0; t < num_of_tokens; ++t) {
+        const unsigned old_transition = transitions[old * num_of_tokens + t];
+        const unsigned other_transition =
+            transitions[other * num_of_tokens + t];
+        const unsigned old_bt_id = bt_table[old * num_of_tokens + t];
+        if (t < self->first_nonterminal) {
+            const boolean is_bypassed =
+                _faBypass_is_bypassed(self, old_bt_id, head);
+            merged_transitions[t] =
+                is_bypassed ? other_transition : old_transition;
+            merged_bt_table[t] =
+                is_bypassed ? bt_table[other * num_of_tokens + t] : old_bt_id;
+        } else if (old_transition == dfa_bt->dfa.reject
+                   || other_transition == dfa_bt->dfa.reject
+                   || old_transition == other_transition) {
+            merged_transitions[t] =
+                old_transition == dfa_bt->dfa.reject ?
+                other_transition : old_transition;
+            merged_bt_table[t] = 0;
+        } else {
+            merged_state = old;
+            break;
+        }
+    }
+    if (merged_state == old) {
+        gsStack_post_pop_several_(&self->transitions, num_of_tokens);
+        gsStack_post_pop_several_(&self->bt_table, num_of_tokens);
+    } else {
+        GS_APPEND(&self->sinks, false, boolean);
+    }
+    gsStack_pre_append_(&self->merged);
+    unsigned* const merged = gsStack_last(&self->merged);
+    merged[0] = old;
+    merged[1] = other;
+    merged[2] = merged_state;
+    return merged_state;
+}
+
+void faDfaBt_bypass_unit_reductions_(faDfaBt* self,
+                                     const boolean* is_bypassable,
+                                     unsigned first_nonterminal) {
+    const unsigned num_of_tokens = self->dfa.num_of_tokens;
+    _faBypass bypass;
+    _faBypass_create_(&bypass, self, is_bypassable, first_nonterminal);
+    /* the merged states get appended as they are first gone to */
+    gsStack transitions;
+    gsStack_create_(&transitions, sizeof(unsigned));
+    for (unsigned state = 0; state < gsStack_length(&bypass.sinks); ++state) {
+        for (unsigned token = 0; token < num_of_tokens; ++token) {
+            const unsigned target = state == self->dfa.reject ?
+                self->dfa.reject : _faBypass_target(&bypass, state, token, 0);
+            GS_APPEND(&transitions, target, unsigned);
+        }
+    }
+
+    faBtItem* const bt_list = MALLOC(self->bt_list_length * sizeof(faBtItem));
+    memcpy(bt_list, self->bt_list, self->bt_list_length * sizeof(faBtItem));
+    faDfaBt_destroy_(self);
+    self->bt_list = bt_list;
+    self->are_tables_borrowed = false;
+    self->dfa.num_of_states = gsStack_length(&bypass.sinks);
+    self->dfa.sinks = gsStack_0(&bypass.sinks);
+    self->dfa.transition_table = gsStack_0(&transitions);
+    self->bt_table = gsStack_0(&bypass.bt_table);
+    gsStack_create_(&bypass.sinks, sizeof(boolean));
+    gsStack_create_(&bypass.bt_table, sizeof(unsigned));
+    _faBypass_destroy_(&bypass);
+    return;
+}
+
+/* the state of a synthesis, which goes an item at a time */
+typedef struct _faSynthesis {
+    const faDfaBt* dfa_bt;
+    /* the val of the next token */
+    const unsigned* current_val;
+    unsigned element_size;
+    faTokenSynthFn token_synth_fn;
+    faBtSynthFn bt_synth_fn;
+    void* extra;
+    gsStack attributes;
+} _faSynthesis;
+
+static void _faSynthesis_destroy_(_faSynthesis* self) {
+    gsStack_destroy_(&self->attributes);
+    return;
+}
+
+static void _faSynthesis_create_(_faSynthesis* self, const faDfaBt* dfa_bt,
+                                 const unsigned* vals, unsigned element_size,
+                                 faTokenSynthFn token_synth_fn,
+                                 faBtSynthFn bt_synth_fn, void* extra) {
+    self->dfa_bt = dfa_bt;
+    self->current_val = vals;
+    self->element_size = element_size;
+    self->token_synth_fn = token_synth_fn;
+    self->bt_synth_fn = bt_synth_fn;
+    self->extra = extra;
+    gsStack_create_(&self->attributes, element_size);
+    return;
+}
+
+/* synthesizes the attribute of item on top of the attributes (replacing
+   those of the body, if item is a bt); a faItemFn, extra being self */
+static void _faSynthesis_item_fn(unsigned item, void* extra) {
+    _faSynthesis* const self = extra;
+    gsStack* const attributes = &self->attributes;
+    if (item < self->dfa_bt->dfa.num_of_tokens) {
+        gsStack_pre_append_(attributes);
+        self->token_synth_fn(item, *self->current_val,
+                             gsStack_last(attributes), self->extra);
+        ++self->current_val;
+    } else {
+        const unsigned bt = item - self->dfa_bt->dfa.num_of_tokens;
+        const unsigned num_of_steps = self->dfa_bt->bt_list[bt].num_of_steps;
+        gsStack_pre_append_(attributes);
+        self->bt_synth_fn(bt, gsStack_last(attributes), self->extra);
+        memcpy((char*) gsStack_last(attributes)
+               - num_of_steps * self->element_size,
+               gsStack_last(attributes), self->element_size);
+        gsStack_post_pop_several_(attributes, num_of_steps);
+    }
+    return;
+}
+
+void faDfaBtPushParse_destroy_(faDfaBtPushParse* self) {
+    if (self == NULL) {
+        return;
+    }
+    gsStack_destroy_(&self->path);
+    gsStack_destroy_(&self->parse_items);
+    return;
+}
+
+void faDfaBtPushParse_create_(faDfaBtPushParse* self, const faDfaBt* dfa_bt) {
+    self->dfa_bt = dfa_bt;
+    self->status = FA_PARSE_CONTINUE;
+    self->num_of_consumed_tokens = 0;
+    gsStack_create_(&self->path, sizeof(unsigned));
+    gsStack_create_(&self->parse_items, sizeof(unsigned));
+    GS_APPEND(&self->path, dfa_bt->dfa.cosink, unsigned);
+    return;
+}
+
+/* the items go to item_fn, if it is not NULL, rather than to the
+   parse items */
+static void _faDfaBtPushParse_add_item_(faDfaBtPushParse* self,
+                                        unsigned item, faItemFn item_fn,
+                                        void* extra) {
+    if (item_fn != NULL) {
+        item_fn(item, extra);
+    } else {
+        GS_APPEND(&self->parse_items, item, unsigned);
+    }
+    return;
+}
+
+/* token 0 means the end of the input; the items go as
+   _faDfaBtPushParse_add_item_ has it */
+static faParseStatus _faDfaBtPushParse_step_(faDfaBtPushParse* self,
+                                             unsigned token,
+                                             faItemFn item_fn, void* extra) {
+    const faDfaBt* const dfa_bt = self->dfa_bt;
+    while (self->status == FA_PARSE_CONTINUE) {
         unsigned next_state;
-        if (self->dfa.sinks[* (unsigned*) gsStack_last(&path)] == true) {
-            successful = true;
+        const unsigned state = * (unsigned*) gsStack_last(&self->path);
+        if (dfa_bt->dfa.sinks[state] == true) {
+            self->status = FA_PARSE_ACCEPT;
             break;
         }
-        if (* (unsigned*) gsStack_last(&path) == self->dfa.reject) {
-            successful = false;
+        if (state == dfa_bt->dfa.reject) {
+            self->status = FA_PARSE_REJECT;
             break;
         }
-        if (*cursor != 0) {
-            next_state = faDfa_goto(&self->dfa,
-                                    * (unsigned*) gsStack_last(&path), *cursor);
-            if (next_state != self->dfa.reject) {
-                GS_APPEND(&parse_items, *cursor, unsigned);
-                GS_APPEND(&path, next_state, unsigned);
-                ++cursor;
-                continue;
+        if (token != 0) {
+            next_state = faDfa_goto(&dfa_bt->dfa, state, token);
+            if (next_state != dfa_bt->dfa.reject) {
+                _faDfaBtPushParse_add_item_(self, token, item_fn, extra);
+                GS_APPEND(&self->path, next_state, unsigned);
+                ++self->num_of_consumed_tokens;
+                break;
             }
         }
-        unsigned bt_id = self->bt_table[(* (unsigned*) gsStack_last(&path)) *
-                                        self->dfa.num_of_tokens + *cursor];
+        unsigned bt_id =
+            dfa_bt->bt_table[state * dfa_bt->dfa.num_of_tokens + token];
         if (bt_id == 0) {
-            successful = false;
+            self->status = FA_PARSE_REJECT;
             break;
         }
         /*
@@ -610,52 +1264,413 @@ unsigned* faDfaBt_parse(const faDfaBt* self, const unsigned* tokens,
           which the bt_list does not contain
         */
         --bt_id;
-        const faBtItem* const bt = self->bt_list + bt_id;
-        GS_APPEND(&parse_items, self->dfa.num_of_tokens + bt_id, unsigned);
-        gsStack_post_pop_several_(&path, bt->num_of_steps);
-        next_state = faDfa_goto(&self->dfa, * (unsigned*) gsStack_last(&path),
+        const faBtItem* const bt = dfa_bt->bt_list + bt_id;
+        _faDfaBtPushParse_add_item_(self, dfa_bt->dfa.num_of_tokens + bt_id,
+                                    item_fn, extra);
+        gsStack_post_pop_several_(&self->path, bt->num_of_steps);
+        next_state = faDfa_goto(&dfa_bt->dfa,
+                                * (unsigned*) gsStack_last(&self->path),
                                 bt->replacing_token);
-        GS_APPEND(&path, next_state, unsigned);
+        GS_APPEND(&self->path, next_state, unsigned);
     }
+    return self->status;
+}
 
-    gsStack_destroy_(&path);
-    *out_end_pos = cursor;
-    if (successful == true) {
-        GS_APPEND(&parse_items, 0, unsigned);
-        return gsStack_0(&parse_items);
-    } else {
-        gsStack_destroy_(&parse_items);
+faParseStatus faDfaBtPushParse_feed_(faDfaBtPushParse* self, unsigned token) {
+    return _faDfaBtPushParse_step_(self, token, NULL, NULL);
+}
+
+faParseStatus faDfaBtPushParse_finish_(faDfaBtPushParse* self) {
+    return _faDfaBtPushParse_step_(self, 0, NULL, NULL);
+}
+
+unsigned* faDfaBtPushParse_release_items_(faDfaBtPushParse* self) {
+    if (self->status != FA_PARSE_ACCEPT) {
         return NULL;
     }
+    GS_APPEND(&self->parse_items, 0, unsigned);
+    unsigned* const items = gsStack_0(&self->parse_items);
+    gsStack_create_(&self->parse_items, sizeof(unsigned));
+    return items;
+}
+
+unsigned* faDfaBt_parse(const faDfaBt* self, const unsigned* tokens,
+                        const unsigned** out_end_pos) {
+    faDfaBtPushParse push_parse;
+    faDfaBtPushParse_create_(&push_parse, self);
+    const unsigned* cursor = tokens;
+    while (*cursor != 0
+           && faDfaBtPushParse_feed_(&push_parse, *cursor) == FA_PARSE_CONTINUE) {
+        ++cursor;
+    }
+    faDfaBtPushParse_finish_(&push_parse);
+    *out_end_pos = tokens + push_parse.num_of_consumed_tokens;
+    unsigned* const items = faDfaBtPushParse_release_items_(&push_parse);
+    faDfaBtPushParse_destroy_(&push_parse);
+    return items;
+}
+
+/* whether the parse can go on from state with token next */
+static boolean _faDfaBt_can_continue(const faDfaBt* self, unsigned state,
+                                     unsigned token) {
+    if (self->dfa.sinks[state] == true) {
+        return token == 0;
+    }
+    return (token != 0
+            && faDfa_goto(&self->dfa, state, token) != self->dfa.reject)
+        || self->bt_table[state * self->dfa.num_of_tokens + token] != 0;
+}
+
+/* skips to the next synchronizing token and pops the parse stack
+   as explained at faDfaBt_parse_with_recovery; returns false if
+   it gets to the end of the input with nowhere to go */
+static boolean _faDfaBtPushParse_recover_(faDfaBtPushParse* self,
+                                          const unsigned** cursor,
+                                          const boolean* is_synchronizing,
+                                          unsigned first_nonterminal) {
+    const faDfaBt* const dfa_bt = self->dfa_bt;
+    for (;;) {
+        while (**cursor != 0 && is_synchronizing[**cursor] == false) {
+            ++*cursor;
+        }
+        const unsigned token = **cursor;
+        const unsigned* const path = gsStack_0(&self->path);
+        for (unsigned depth = gsStack_length(&self->path); depth > 0;
+             --depth) {
+            for (unsigned nonterminal = first_nonterminal;
+                 nonterminal < dfa_bt->dfa.num_of_tokens; ++nonterminal) {
+                const unsigned state =
+                    faDfa_goto(&dfa_bt->dfa, path[depth - 1], nonterminal);
+                if (state != dfa_bt->dfa.reject
+                    && _faDfaBt_can_continue(dfa_bt, state, token) == true) {
+                    gsStack_post_pop_several_(&self->path,
+                                              gsStack_length(&self->path)
+                                              - depth);
+                    GS_APPEND(&self->path, state, unsigned);
+                    self->status = FA_PARSE_CONTINUE;
+                    return true;
+                }
+            }
+        }
+        if (token == 0) {
+            return false;
+        }
+        ++*cursor;
+    }
+}
+
+unsigned faDfaBt_parse_with_recovery(const faDfaBt* self,
+                                     const unsigned* tokens,
+                                     const boolean* is_synchronizing,
+                                     unsigned first_nonterminal,
+                                     unsigned** out_error_positions) {
+    gsStack error_positions;
+    gsStack_create_(&error_positions, sizeof(unsigned));
+    faDfaBtPushParse push_parse;
+    faDfaBtPushParse_create_(&push_parse, self);
+    const unsigned* cursor = tokens;
+    /* where the parse last resumed after an error */
+    const unsigned* resumed = NULL;
+    for (;;) {
+        const faParseStatus status = *cursor != 0
+            ? faDfaBtPushParse_feed_(&push_parse, *cursor)
+            : faDfaBtPushParse_finish_(&push_parse);
+        if (status == FA_PARSE_CONTINUE) {
+            ++cursor;
+            continue;
+        }
+        if (status == FA_PARSE_ACCEPT && *cursor == 0) {
+            break;
+        }
+        if (cursor != resumed) {
+            GS_APPEND(&error_positions, cursor - tokens, unsigned);
+        } else if (*cursor != 0) {
+            /* resuming did not get past the synchronizing token,
+               so it is skipped too (and no new error is reported) */
+            ++cursor;
+        } else {
+            break;
+        }
+        if (status == FA_PARSE_ACCEPT) {
+            /* the tokens left over after the sink can only be skipped */
+            break;
+        }
+        if (_faDfaBtPushParse_recover_(&push_parse, &cursor,
+                                       is_synchronizing,
+                                       first_nonterminal) == false) {
+            break;
+        }
+        resumed = cursor;
+    }
+    faDfaBtPushParse_destroy_(&push_parse);
+    *out_error_positions = gsStack_0(&error_positions);
+    return gsStack_length(&error_positions);
 }
 
 void faDfaBt_synthesize(const faDfaBt* self, const unsigned* items,
                         const unsigned* vals, unsigned element_size,
                         faTokenSynthFn token_synth_fn,
                         faBtSynthFn bt_synth_fn, void* extra, void* result) {
-    gsStack attributes;
-    gsStack_create_(&attributes, element_size);
-    const unsigned* current_val = vals;
+    _faSynthesis synthesis;
+    _faSynthesis_create_(&synthesis, self, vals, element_size,
+                         token_synth_fn, bt_synth_fn, extra);
     for (const unsigned* item = items; *item != 0; ++item) {
-        if (*item < self->dfa.num_of_tokens) {
-            gsStack_pre_append_(&attributes);
-            token_synth_fn(*item, *current_val, gsStack_last(&attributes),
-			   extra);
-            ++current_val;
+        _faSynthesis_item_fn(*item, &synthesis);
+    }
+    memcpy(result, gsStack_last(&synthesis.attributes), element_size);
+    _faSynthesis_destroy_(&synthesis);
+    return;
+}
+
+boolean faDfaBt_parse_with_item_fn(const faDfaBt* self,
+                                   const unsigned* tokens,
+                                   faItemFn item_fn, void* extra,
+                                   const unsigned** out_end_pos) {
+    faDfaBtPushParse push_parse;
+    faDfaBtPushParse_create_(&push_parse, self);
+    const unsigned* cursor = tokens;
+    while (*cursor != 0
+           && _faDfaBtPushParse_step_(&push_parse, *cursor, item_fn, extra)
+           == FA_PARSE_CONTINUE) {
+        ++cursor;
+    }
+    _faDfaBtPushParse_step_(&push_parse, 0, item_fn, extra);
+    *out_end_pos = tokens + push_parse.num_of_consumed_tokens;
+    const boolean successful =
+        push_parse.status == FA_PARSE_ACCEPT ? true : false;
+    faDfaBtPushParse_destroy_(&push_parse);
+    return successful;
+}
+
+boolean faDfaBt_parse_and_synthesize(const faDfaBt* self,
+                                     const unsigned* tokens,
+                                     const unsigned* vals,
+                                     unsigned element_size,
+                                     faTokenSynthFn token_synth_fn,
+                                     faBtSynthFn bt_synth_fn,
+                                     void* extra, void* result,
+                                     const unsigned** out_end_pos) {
+    _faSynthesis synthesis;
+    _faSynthesis_create_(&synthesis, self, vals, element_size,
+                         token_synth_fn, bt_synth_fn, extra);
+    const boolean successful =
+        faDfaBt_parse_with_item_fn(self, tokens, _faSynthesis_item_fn,
+                                   &synthesis, out_end_pos);
+    if (successful == true) {
+        memcpy(result, gsStack_last(&synthesis.attributes), element_size);
+    }
+    _faSynthesis_destroy_(&synthesis);
+    return successful;
+}
+
+static void _faParseCheckpoint_create_(faParseCheckpoint* self,
+                                       unsigned token_index,
+                                       unsigned num_of_items,
+                                       const gsStack* path) {
+    self->token_index = token_index;
+    self->num_of_items = num_of_items;
+    self->path_length = gsStack_length(path);
+    self->path = MALLOC(self->path_length * sizeof(unsigned));
+    if (self->path_length != 0) {
+        memcpy(self->path, gsStack_0(path),
+               self->path_length * sizeof(unsigned));
+    }
+    return;
+}
+
+static boolean _faParseCheckpoint_has_path(const faParseCheckpoint* self,
+                                           const gsStack* path) {
+    return self->path_length == gsStack_length(path)
+        && memcmp(self->path, gsStack_0(path),
+                  self->path_length * sizeof(unsigned)) == 0;
+}
+
+/* replaces [start, old_end) of self by the new_length elements */
+static void _fa_splice_unsigneds_(gsStack* self, unsigned start,
+                                  unsigned old_end,
+                                  const unsigned* new_elements,
+                                  unsigned new_length) {
+    const unsigned length = gsStack_length(self);
+    const unsigned old_length = old_end - start;
+    if (new_length > old_length) {
+        gsStack_pre_append_several_(self, new_length - old_length);
+    }
+    unsigned* const elements = gsStack_0(self);
+    /* the pointers may be NULL when there is nothing to copy */
+    if (length != old_end) {
+        memmove(elements + start + new_length, elements + old_end,
+                (length - old_end) * sizeof(unsigned));
+    }
+    if (new_length != 0) {
+        memcpy(elements + start, new_elements, new_length * sizeof(unsigned));
+    }
+    if (new_length < old_length) {
+        gsStack_post_pop_several_(self, old_length - new_length);
+    }
+    return;
+}
+
+void faDfaBtIncrementalParse_destroy_(faDfaBtIncrementalParse* self) {
+    if (self == NULL) {
+        return;
+    }
+    faDfaBtPushParse_destroy_(&self->push_parse);
+    gsStack_destroy_(&self->tokens);
+    for (faParseCheckpoint* checkpoint = gsStack_0(&self->checkpoints);
+         checkpoint != gsStack_end(&self->checkpoints); ++checkpoint) {
+        FREE(checkpoint->path);
+    }
+    gsStack_destroy_(&self->checkpoints);
+    return;
+}
+
+void faDfaBtIncrementalParse_create_(faDfaBtIncrementalParse* self,
+                                     const faDfaBt* dfa_bt,
+                                     const unsigned* tokens) {
+    faDfaBtPushParse_create_(&self->push_parse, dfa_bt);
+    gsStack_create_(&self->tokens, sizeof(unsigned));
+    gsStack_create_(&self->checkpoints, sizeof(faParseCheckpoint));
+    gsStack_pre_append_(&self->checkpoints);
+    _faParseCheckpoint_create_(gsStack_last(&self->checkpoints), 0, 0,
+                               &self->push_parse.path);
+    unsigned length = 0;
+    while (tokens[length] != 0) {
+        ++length;
+    }
+    faDfaBtIncrementalParse_edit_(self, 0, 0, tokens, length);
+    return;
+}
+
+/* the last checkpoint at or before token_index */
+static unsigned _faDfaBtIncrementalParse_checkpoint_before(const faDfaBtIncrementalParse* self,
+                                                           unsigned token_index) {
+    const faParseCheckpoint* const checkpoints = gsStack_0(&self->checkpoints);
+    unsigned low = 0;
+    unsigned high = gsStack_length(&self->checkpoints);
+    while (high - low > 1) {
+        const unsigned middle = low + (high - low) / 2;
+        if (checkpoints[middle].token_index <= token_index) {
+            low = middle;
         } else {
-            const unsigned bt = *item - self->dfa.num_of_tokens;
-            const unsigned num_of_steps = self->bt_list[bt].num_of_steps;
-            gsStack_pre_append_(&attributes);
-            bt_synth_fn(bt, gsStack_last(&attributes), extra);
-            memcpy((char*) gsStack_last(&attributes)
-		   - num_of_steps * element_size,
-                   gsStack_last(&attributes), element_size);
-            gsStack_post_pop_several_(&attributes, num_of_steps);
+            high = middle;
         }
     }
-    memcpy(result, gsStack_last(&attributes), element_size);
-    gsStack_destroy_(&attributes);
-    return;
+    return low;
+}
+
+faParseStatus faDfaBtIncrementalParse_edit_(faDfaBtIncrementalParse* self,
+                                            unsigned start, unsigned old_end,
+                                            const unsigned* new_tokens,
+                                            unsigned new_length) {
+    faDfaBtPushParse* const push_parse = &self->push_parse;
+    /* a token at old index i >= old_end is now at i - removed + new_length */
+    const unsigned removed = old_end - start;
+    _fa_splice_unsigneds_(&self->tokens, start, old_end, new_tokens,
+                          new_length);
+    const unsigned* const tokens = gsStack_0(&self->tokens);
+    const unsigned num_of_tokens = gsStack_length(&self->tokens);
+
+    /* the old parse, kept to splice its tail back in */
+    gsStack old_checkpoints = self->checkpoints;
+    gsStack items = push_parse->parse_items;
+    const faParseStatus old_status = push_parse->status;
+    const unsigned old_num_of_consumed_tokens =
+        push_parse->num_of_consumed_tokens;
+    faParseCheckpoint* const old = gsStack_0(&old_checkpoints);
+    const unsigned old_length = gsStack_length(&old_checkpoints);
+
+    /* resume from the last checkpoint before the edit */
+    const unsigned resume =
+        _faDfaBtIncrementalParse_checkpoint_before(self, start);
+    /* the parse can fall in line with the old one
+       only at an old checkpoint after the edit */
+    unsigned next_old = resume + 1;
+    if (old_end != 0) {
+        const unsigned last_in_edit =
+            _faDfaBtIncrementalParse_checkpoint_before(self, old_end - 1);
+        if (last_in_edit >= next_old) {
+            next_old = last_in_edit + 1;
+        }
+    }
+    const unsigned num_of_kept_items = old[resume].num_of_items;
+    gsStack_create_with_length_(&self->checkpoints, sizeof(faParseCheckpoint),
+                                resume + 1);
+    memcpy(gsStack_0(&self->checkpoints), old,
+           (resume + 1) * sizeof(faParseCheckpoint));
+    gsStack_create_(&push_parse->parse_items, sizeof(unsigned));
+    gsStack_make_empty_(&push_parse->path);
+    gsStack_pre_append_several_(&push_parse->path, old[resume].path_length);
+    memcpy(gsStack_0(&push_parse->path), old[resume].path,
+           old[resume].path_length * sizeof(unsigned));
+    push_parse->status = FA_PARSE_CONTINUE;
+    push_parse->num_of_consumed_tokens = old[resume].token_index;
+
+    unsigned converged = old_length;
+    unsigned last_checkpoint_index = old[resume].token_index;
+    self->num_of_reparsed_tokens = 0;
+    while (push_parse->status == FA_PARSE_CONTINUE) {
+        const unsigned index = push_parse->num_of_consumed_tokens;
+        while (next_old < old_length
+               && (old[next_old].token_index < old_end
+                   || old[next_old].token_index + new_length
+                   < index + removed)) {
+            ++next_old;
+        }
+        if (next_old < old_length
+            && old[next_old].token_index + new_length == index + removed
+            && _faParseCheckpoint_has_path(old + next_old, &push_parse->path)) {
+            converged = next_old;
+            break;
+        }
+        if (index - last_checkpoint_index >= FA_CHECKPOINT_INTERVAL) {
+            gsStack_pre_append_(&self->checkpoints);
+            _faParseCheckpoint_create_(
+                gsStack_last(&self->checkpoints), index,
+                num_of_kept_items + gsStack_length(&push_parse->parse_items),
+                &push_parse->path);
+            last_checkpoint_index = index;
+        }
+        if (index == num_of_tokens) {
+            faDfaBtPushParse_finish_(push_parse);
+        } else {
+            ++self->num_of_reparsed_tokens;
+            faDfaBtPushParse_feed_(push_parse, tokens[index]);
+        }
+    }
+
+    /* the reparsed items replace the old ones up to where the parses
+       fell in line */
+    gsStack reparsed_items = push_parse->parse_items;
+    const unsigned num_of_reparsed_items = gsStack_length(&reparsed_items);
+    _fa_splice_unsigneds_(&items, num_of_kept_items,
+                          converged < old_length
+                          ? old[converged].num_of_items
+                          : gsStack_length(&items),
+                          gsStack_0(&reparsed_items), num_of_reparsed_items);
+    gsStack_destroy_(&reparsed_items);
+    push_parse->parse_items = items;
+    for (unsigned i = resume + 1; i < converged; ++i) {
+        FREE(old[i].path);
+    }
+    if (converged < old_length) {
+        /* from there on the old parse is the new one, shifted */
+        const unsigned old_num_of_items = old[converged].num_of_items;
+        const unsigned new_num_of_items =
+            num_of_kept_items + num_of_reparsed_items;
+        for (unsigned i = converged; i < old_length; ++i) {
+            old[i].token_index = old[i].token_index - removed + new_length;
+            old[i].num_of_items =
+                old[i].num_of_items - old_num_of_items + new_num_of_items;
+            GS_APPEND(&self->checkpoints, old[i], faParseCheckpoint);
+        }
+        push_parse->status = old_status;
+        push_parse->num_of_consumed_tokens =
+            old_num_of_consumed_tokens - removed + new_length;
+    } else if (push_parse->status == FA_PARSE_ACCEPT) {
+        GS_APPEND(&push_parse->parse_items, 0, unsigned);
+    }
+    gsStack_destroy_(&old_checkpoints);
+    return push_parse->status;
 }
 
 /*-------------------------*//*-------------------------*/
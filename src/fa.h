@@ -12,6 +12,13 @@
 /* macros                  */
 /*-------------------------*/
 
+/* the binary form of a faDfaBt starts with these */
+#define FA_DFA_BT_BINARY_MAGIC 0x54424146u
+#define FA_DFA_BT_BINARY_VERSION 1
+
+/* an incremental parse takes a checkpoint every this many shifted tokens */
+#define FA_CHECKPOINT_INTERVAL 64
+
 /*-------------------------*/
 /* types                   */
 /*-------------------------*/
@@ -51,12 +58,60 @@ typedef struct faDfaBt {
     faBtItem* bt_list;
     /* bt_table[source_state * num_of_tokens + token] = bt_id */
     unsigned* bt_table;
+    /* if true, the tables (of dfa too) belong to someone else,
+       such as a binary form wrapped by faDfaBt_create_from_binary_ */
+    boolean are_tables_borrowed;
 }                               faDfaBt;
 
+typedef enum faParseStatus {
+    /* more tokens are expected */
+    FA_PARSE_CONTINUE,
+    /* the sink was reached */
+    FA_PARSE_ACCEPT,
+    FA_PARSE_REJECT
+}                               faParseStatus;
+
+/* a parse with faDfaBt, fed a token at a time */
+typedef struct faDfaBtPushParse {
+    const faDfaBt* dfa_bt;
+    faParseStatus status;
+    unsigned num_of_consumed_tokens;
+    gsStack path;
+    gsStack parse_items;
+}                               faDfaBtPushParse;
+
+/* the parse stack, taken before processing the token at token_index,
+   when the parse had produced num_of_items items */
+typedef struct faParseCheckpoint {
+    unsigned token_index;
+    unsigned num_of_items;
+    unsigned path_length;
+    unsigned* path;
+}                               faParseCheckpoint;
+
+/*
+  a parse of a token sequence which is redone after each edit of the
+  sequence, resuming from the last checkpoint before the edit and
+  stopping as soon as the parse stack after the edit is the same as it
+  was at a checkpoint of the old parse, as from there on it would do
+  the very same thing; the items of push_parse (0-terminated if it
+  accepted) are the items of the whole sequence
+*/
+typedef struct faDfaBtIncrementalParse {
+    faDfaBtPushParse push_parse;
+    /* not 0-terminated */
+    gsStack tokens;
+    /* of faParseCheckpoint, by increasing token_index, the first at 0 */
+    gsStack checkpoints;
+    /* how many tokens the last (re)parse went through */
+    unsigned num_of_reparsed_tokens;
+}                               faDfaBtIncrementalParse;
+
 typedef void                    (*faTokenSynthFn)(unsigned token, unsigned val,
                                                   void* attribute, void* extra);
 typedef void                    (*faBtSynthFn)(unsigned bt, void* attributes,
                                                void* extra);
+typedef void                    (*faItemFn)(unsigned item, void* extra);
 
 typedef struct faDfaOfCharsRaceAux {
     unsigned state;
@@ -123,6 +178,13 @@ extern  faNfa*          faNfa_concat__(faNfa* nfa1, faNfa* nfa2);
 extern  faNfa*          faNfa_sum__(faNfa* nfa1, faNfa* nfa2);
 /* returns nfa with L(nfa) = L(nfa1)L(nfa2) */
 extern  faNfa*          faNfa_prod__(faNfa* nfa1, faNfa* nfa2);
+/* returns nfa with L(nfa) = L(nfa1){min,max},
+   (that is, L(nfa1){min,} if max is not given), unrolled into copies
+   of nfa1; returns NULL (destroying nfa1) if the copies would take more
+   than max_length states in all */
+extern  faNfa*          faNfa_repeat__(faNfa* nfa, unsigned min,
+                                       unsignedMaybe max,
+                                       unsigned max_length);
 
 /* faDfa */
 
@@ -159,19 +221,59 @@ extern  faDfa*          faDfa_create_nfaec(const faNfa* nfa,
 extern  void            faDfaOfChars_destroy_(faDfaOfChars* self);
 extern  void            faDfaOfChars_destroy(faDfaOfChars* self);
 
+/* the state reached after reading str,
+   or the reject state if it was reached on the way */
+extern  unsigned        faDfaOfChars_state_after(const faDfaOfChars* self,
+						 const char* str);
 extern  boolean         faDfaOfChars_accepts(const faDfaOfChars* self,
 					     const char* str);
+/* runs the dfas on str together until all of them reject, and returns
+   the one with the longest accepted prefix (ending at *out_end_pos),
+   or length if none accepts; if out_examined_end is not NULL, it is set
+   past the last character looked at (which is past the 0 ending str,
+   if the race got there), as anything after it did not matter */
 extern  unsigned        faDfaOfChars_race(unsigned length,
 					  const faDfaOfChars* const* selves,
 					  const char* str,
 					  faDfaOfCharsRaceAux* aux,
-					  const char** out_end_pos);
+					  const char** out_end_pos,
+					  const char** out_examined_end);
 
 /* faDfaBt */
 
 extern  void            faDfaBt_destroy_(faDfaBt* self);
 extern  void            faDfaBt_destroy(faDfaBt* self);
 
+/*
+  the binary form of self is a header (magic, version, the sizes of the
+  types involved, and the dimensions) followed by the tables as they are
+  in memory; writes it to buffer unless it is NULL, and returns its size
+*/
+extern  size_t          faDfaBt_serialize(const faDfaBt* self, void* buffer);
+/* makes self use the tables inside buffer, without copying them, so it
+   should be aligned for unsigned (as mmap'd or malloc'd memory is) and
+   outlive self; returns false if buffer does not hold a binary form of
+   this version, written on a platform with the same type sizes, or if
+   a parse could read out of its tables (which are all checked, so a
+   corrupted buffer is either rejected or read within its bounds, though
+   its parses may then not end) */
+extern  boolean         faDfaBt_create_from_binary_(faDfaBt* self,
+						    const void* buffer,
+						    size_t size);
+
+/*
+  makes the parse skip the reductions by unit productions (of a single
+  step) flagged in is_bypassable (indexed by bt): a state which does such
+  reductions, with a single head, is merged (as a new state) with each
+  state the parse would go to on that head, and is gone to instead of it;
+  the tokens from first_nonterminal on are the gotos; the items then lack
+  these productions, which suits synthesis which passes their attribute
+  through; the tables are rebuilt, so they are owned by self afterwards
+*/
+extern  void            faDfaBt_bypass_unit_reductions_(faDfaBt* self,
+							const boolean* is_bypassable,
+							unsigned first_nonterminal);
+
 extern  unsigned*       faDfaBt_parse(const faDfaBt* self,
 				      const unsigned* tokens,
 				      const unsigned** out_end_pos);
@@ -182,6 +284,71 @@ extern  void            faDfaBt_synthesize(const faDfaBt* self,
 					   faTokenSynthFn token_synth_fn,
 					   faBtSynthFn bt_synth_fn,
 					   void* extra, void* result);
+/* parses and synthesizes in one pass, never building the items;
+   returns whether the parse succeeded, and if not, the attributes
+   synthesized so far are just dropped */
+extern  boolean         faDfaBt_parse_and_synthesize(const faDfaBt* self,
+						     const unsigned* tokens,
+						     const unsigned* vals,
+						     unsigned element_size,
+						     faTokenSynthFn token_synth_fn,
+						     faBtSynthFn bt_synth_fn,
+						     void* extra, void* result,
+						     const unsigned** out_end_pos);
+/* parses, calling item_fn with each item as the parse produces it
+   (rather than keeping the items); returns whether the parse succeeded */
+extern  boolean         faDfaBt_parse_with_item_fn(const faDfaBt* self,
+						   const unsigned* tokens,
+						   faItemFn item_fn,
+						   void* extra,
+						   const unsigned** out_end_pos);
+
+/*
+  parses tokens, recovering from syntax errors in panic mode: the tokens
+  up to the next synchronizing one (is_synchronizing is indexed by token;
+  the end of the input always synchronizes) are skipped, and states are
+  popped off the parse stack until one has a goto on a nonterminal
+  (a token >= first_nonterminal) after which the synchronizing token
+  can be parsed, as if that nonterminal was just reduced to;
+  returns the number of errors, setting *out_error_positions to their
+  indices in tokens (to be freed by the caller)
+*/
+extern  unsigned        faDfaBt_parse_with_recovery(const faDfaBt* self,
+							const unsigned* tokens,
+							const boolean* is_synchronizing,
+							unsigned first_nonterminal,
+							unsigned** out_error_positions);
+
+/* faDfaBtPushParse */
+
+extern  void            faDfaBtPushParse_destroy_(faDfaBtPushParse* self);
+extern  void            faDfaBtPushParse_create_(faDfaBtPushParse* self,
+						 const faDfaBt* dfa_bt);
+/* token should not be 0; does the reductions the token calls for and
+   shifts it, unless the parse stops before that (then the token is
+   not consumed); once the parse stops, feeding does nothing */
+extern  faParseStatus   faDfaBtPushParse_feed_(faDfaBtPushParse* self,
+					       unsigned token);
+/* ends the input */
+extern  faParseStatus   faDfaBtPushParse_finish_(faDfaBtPushParse* self);
+/* the parse items, as returned by faDfaBt_parse, if the parse accepted
+   (and NULL otherwise), which the caller should free */
+extern  unsigned*       faDfaBtPushParse_release_items_(faDfaBtPushParse* self);
+
+/* faDfaBtIncrementalParse */
+
+extern  void            faDfaBtIncrementalParse_destroy_(faDfaBtIncrementalParse* self);
+/* parses tokens (0-terminated) */
+extern  void            faDfaBtIncrementalParse_create_(faDfaBtIncrementalParse* self,
+							const faDfaBt* dfa_bt,
+							const unsigned* tokens);
+/* replaces the tokens in [start, old_end) by the new_length ones
+   at new_tokens and reparses */
+extern  faParseStatus   faDfaBtIncrementalParse_edit_(faDfaBtIncrementalParse* self,
+						      unsigned start,
+						      unsigned old_end,
+						      const unsigned* new_tokens,
+						      unsigned new_length);
 
 #ifdef TESTING_PRINTS
 extern  void            faNfa_print(const faNfa* self);
@@ -51,8 +51,17 @@ void lexLexer_destroy(lexLexer* self) {
     return;
 }
 
+/* the returned pointer is valid until the next append */
+static rexCompileStats* _lex_append_zero_stats(gsStack* stats) {
+    gsStack_pre_append_(stats);
+    rexCompileStats* const result = gsStack_last(stats);
+    memset(result, 0, sizeof(*result));
+    return result;
+}
+
 static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
-                                            const rexRegexSLRParser* regex_slr_parser) {
+                                            const rexRegexSLRParser* regex_slr_parser,
+                                            gsStack* stats) {
     const char str_empty[] = "<empty>";
 
     if (regex_slr_parser == NULL) {
@@ -73,6 +82,11 @@ static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
 
     GS_APPEND(&token_names, str_create_copy(str_empty), char*);
     GS_APPEND(&compiled_regexes, NULL, rexCompiledRegex*);
+    /* the stats of <empty> */
+    rexCompileStats* current_stats = NULL;
+    if (stats != NULL) {
+        _lex_append_zero_stats(stats);
+    }
 
     boolean got_to_ignored_tokens = false;
     const char* cursor = spec;
@@ -93,9 +107,13 @@ static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
             }
             cursor = cursor_next + 1;
             cursor_next = str_while_not_newline(cursor);
+            if (stats != NULL) {
+                current_stats = _lex_append_zero_stats(stats);
+            }
             rexCompiledRegex* compiled_regex =
-                rexCompiledRegex_create_from_regex(self->regex_slr_parser,
-						   cursor, cursor_next);
+                rexCompiledRegex_create_from_regex_with_stats(self->regex_slr_parser,
+                                                              cursor, cursor_next,
+                                                              current_stats, NULL);
             if (compiled_regex == NULL) {
                 goto error_label;
             }
@@ -119,9 +137,13 @@ static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
                 GS_APPEND(&token_names,
                           str_create_copy_from_to(cursor, cursor_next),
                           char*);
+                if (stats != NULL) {
+                    current_stats = _lex_append_zero_stats(stats);
+                }
                 rexCompiledRegex* compiled_regex =
-                    rexCompiledRegex_create_from_raw_str(self->regex_slr_parser,
-							 cursor, cursor_next);
+                    rexCompiledRegex_create_from_raw_str_with_stats(self->regex_slr_parser,
+                                                                    cursor, cursor_next,
+                                                                    current_stats, NULL);
                 if (compiled_regex == NULL) {
                     goto error_label;
                 }
@@ -139,9 +161,13 @@ static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
             }
             cursor = cursor_next + 1;
             cursor_next = str_while_not_newline(cursor);
+            if (stats != NULL) {
+                current_stats = _lex_append_zero_stats(stats);
+            }
             rexCompiledRegex* compiled_regex =
-                rexCompiledRegex_create_from_regex(self->regex_slr_parser,
-						   cursor, cursor_next);
+                rexCompiledRegex_create_from_regex_with_stats(self->regex_slr_parser,
+                                                              cursor, cursor_next,
+                                                              current_stats, NULL);
             if (compiled_regex == NULL) {
                 goto error_label;
             }
@@ -179,7 +205,26 @@ static lexLexer* lexLexer_create_from_spec_(lexLexer* self, const char *spec,
 lexLexer* lexLexer_create_from_spec(const char *spec,
                                     const rexRegexSLRParser* regex_slr_parser) {
     lexLexer* self = MALLOC(sizeof(lexLexer));
-    lexLexer* result = lexLexer_create_from_spec_(self, spec, regex_slr_parser);
+    lexLexer* result = lexLexer_create_from_spec_(self, spec, regex_slr_parser,
+                                                 NULL);
+    if (result == NULL) {
+        FREE(self);
+        return NULL;
+    }
+    return self;
+}
+
+lexLexer* lexLexer_create_from_spec_with_stats(const char *spec,
+                                               const rexRegexSLRParser* regex_slr_parser,
+                                               rexCompileStats** out_stats,
+                                               unsigned* out_num_of_stats) {
+    gsStack stats;
+    gsStack_create_(&stats, sizeof(rexCompileStats));
+    lexLexer* self = MALLOC(sizeof(lexLexer));
+    lexLexer* result = lexLexer_create_from_spec_(self, spec, regex_slr_parser,
+                                                 &stats);
+    *out_num_of_stats = gsStack_length(&stats);
+    *out_stats = gsStack_0(&stats);
     if (result == NULL) {
         FREE(self);
         return NULL;
@@ -187,37 +232,287 @@ lexLexer* lexLexer_create_from_spec(const char *spec,
     return self;
 }
 
+rexRaceState* lexLexer_create_race_state(const lexLexer* self) {
+    return rexRaceState_create(self->num_of_tokens);
+}
+
+const char* lexLexer_process_onto(const lexLexer* self, const char* str,
+                                  lexStrToValFn str_to_val_fn, void* extra,
+                                  gsStack* tokens, gsStack* vals,
+                                  rexRaceState* race_state) {
+    rexRaceState* const own_race_state =
+        race_state == NULL ? lexLexer_create_race_state(self) : NULL;
+    if (race_state == NULL) {
+        race_state = own_race_state;
+    }
+    while (*str != 0) {
+        const char* end_pos;
+        const unsigned winner =
+            rexCompiledRegexList_race(self->compiled_regexes, race_state,
+                                      str, &end_pos);
+        if (winner == self->num_of_tokens) {
+            break;
+        }
+        if (winner < self->num_of_nonignored_tokens) {
+            GS_APPEND(tokens, winner, unsigned);
+            if (str_to_val_fn != NULL) {
+                GS_APPEND(vals, str_to_val_fn(winner, str, end_pos, extra),
+                          unsigned);
+            }
+        }
+        str = end_pos;
+    }
+    GS_APPEND(tokens, 0, unsigned);
+    rexRaceState_destroy(own_race_state);
+    return str;
+}
+
 unsigned* lexLexer_process(const lexLexer* self, const char* str,
                            lexStrToValFn str_to_val_fn, void* extra,
                            unsigned** out_vals,
                            const char** out_end_pos) {
     gsStack tokens, vals;
     gsStack_create_(&tokens, sizeof(unsigned));
+    gsStack_create_(&vals, sizeof(unsigned));
+    *out_end_pos =
+        lexLexer_process_onto(self, str,
+                              out_vals != NULL ? str_to_val_fn : NULL, extra,
+                              &tokens, &vals, NULL);
     if (out_vals != NULL) {
-        gsStack_create_(&vals, sizeof(unsigned));
+        *out_vals = gsStack_0(&vals);
+    } else {
+        gsStack_destroy_(&vals);
     }
-    while (*str != 0) {
+    return gsStack_0(&tokens);
+}
+
+void lexLexing_destroy_(lexLexing* self) {
+    if (self == NULL) {
+        return;
+    }
+    FREE(self->tokens);
+    FREE(self->vals);
+    FREE(self->spans);
+    return;
+}
+
+/* the old tokens a re-lex may fall in line with */
+typedef struct _lexOldTokens {
+    const lexTokenSpan* spans;
+    unsigned length;
+    /* the first which may be fallen in line with */
+    unsigned first;
+    /* the new offsets from which on the string is the old one, shifted */
+    unsigned unchanged_from;
+    /* an old offset plus added is the new offset plus removed */
+    unsigned removed;
+    unsigned added;
+} _lexOldTokens;
+
+/*
+  lexes str from pos on, appending to tokens, vals (unless str_to_val_fn
+  is NULL) and spans, until the string ends or lexing fails, or
+  (if old is not NULL) until a token is to be lexed where an old token
+  started in the unchanged part, which then is the one *out_resumed_old
+  (and otherwise it is old->length); ignored tokens lexed before any
+  token are accounted for in *previous_span, if it is not NULL;
+  returns where lexing stopped
+*/
+static unsigned _lexLexer_lex_(const lexLexer* self, const char* str,
+                               unsigned pos, lexTokenSpan* previous_span,
+                               lexStrToValFn str_to_val_fn, void* extra,
+                               gsStack* tokens, gsStack* vals, gsStack* spans,
+                               const _lexOldTokens* old,
+                               unsigned* out_resumed_old) {
+    rexRaceState* const race_state = lexLexer_create_race_state(self);
+    unsigned next_old = 0;
+    if (old != NULL) {
+        next_old = old->first;
+        *out_resumed_old = old->length;
+    }
+    while (str[pos] != 0) {
+        if (old != NULL && pos >= old->unchanged_from) {
+            while (next_old < old->length
+                   && old->spans[next_old].start + old->added
+                   < pos + old->removed) {
+                ++next_old;
+            }
+            if (next_old < old->length
+                && old->spans[next_old].start + old->added
+                == pos + old->removed) {
+                *out_resumed_old = next_old;
+                break;
+            }
+        }
         const char* end_pos;
+        const char* examined_end;
         const unsigned winner =
-            rexCompiledRegexList_race(self->compiled_regexes, str, &end_pos);
+            rexCompiledRegexList_race_examining(self->compiled_regexes,
+                                                race_state, str + pos,
+                                                &end_pos, &examined_end);
         if (winner == self->num_of_tokens) {
             break;
         }
+        const unsigned end = end_pos - str;
+        const unsigned examined = examined_end - str;
         if (winner < self->num_of_nonignored_tokens) {
-            GS_APPEND(&tokens, winner, unsigned);
-            if (out_vals != NULL) {
-                GS_APPEND(&vals, str_to_val_fn(winner, str, end_pos, extra),
+            GS_APPEND(tokens, winner, unsigned);
+            if (str_to_val_fn != NULL) {
+                GS_APPEND(vals, str_to_val_fn(winner, str + pos, end_pos, extra),
                           unsigned);
             }
+            const unsigned previous_examined =
+                (previous_span == NULL ? 0 : previous_span->examined_end);
+            gsStack_pre_append_(spans);
+            previous_span = gsStack_last(spans);
+            previous_span->start = pos;
+            previous_span->end = end;
+            previous_span->examined_end =
+                (examined > previous_examined ? examined : previous_examined);
+        } else if (previous_span != NULL
+                   && previous_span->examined_end < examined) {
+            previous_span->examined_end = examined;
         }
-        str = end_pos;
+        pos = end;
     }
+    rexRaceState_destroy(race_state);
+    return pos;
+}
+
+void lexLexing_create_(lexLexing* self, const lexLexer* lexer,
+                       const char* str, lexStrToValFn str_to_val_fn,
+                       void* extra) {
+    gsStack tokens, vals, spans;
+    gsStack_create_(&tokens, sizeof(unsigned));
+    gsStack_create_(&vals, sizeof(unsigned));
+    gsStack_create_(&spans, sizeof(lexTokenSpan));
+    self->end_pos = _lexLexer_lex_(lexer, str, 0, NULL, str_to_val_fn, extra,
+                                   &tokens, &vals, &spans, NULL, NULL);
+    self->num_of_tokens = gsStack_length(&tokens);
     GS_APPEND(&tokens, 0, unsigned);
-    if (out_vals != NULL) {
-        *out_vals = gsStack_0(&vals);
+    self->tokens = gsStack_0(&tokens);
+    self->vals = NULL;
+    if (str_to_val_fn != NULL) {
+        GS_APPEND(&vals, 0, unsigned);
+        self->vals = gsStack_0(&vals);
     }
-    *out_end_pos = str;
-    return gsStack_0(&tokens);
+    GS_APPEND(&spans, ((lexTokenSpan) {0, 0, 0}), lexTokenSpan);
+    self->spans = gsStack_0(&spans);
+    return;
+}
+
+/* replaces [start, old_end) of the array, of length elements,
+   by the new_length ones at new_elements */
+static void* _lex_splice(void* array, size_t element_size, unsigned length,
+                         unsigned start, unsigned old_end,
+                         const void* new_elements, unsigned new_length) {
+    const unsigned new_array_length = length - (old_end - start) + new_length;
+    char* result = array;
+    if (new_array_length > length) {
+        result = REALLOC(result, new_array_length * element_size);
+    }
+    if (length != old_end && start + new_length != old_end) {
+        memmove(result + (start + new_length) * element_size,
+                result + old_end * element_size,
+                (length - old_end) * element_size);
+    }
+    if (new_length != 0) {
+        memcpy(result + start * element_size, new_elements,
+               new_length * element_size);
+    }
+    return result;
+}
+
+void lexLexing_relex_(lexLexing* self, const lexLexer* lexer, const char* str,
+                      unsigned edit_start, unsigned edit_old_end,
+                      unsigned edit_new_length, lexStrToValFn str_to_val_fn,
+                      void* extra, unsigned* out_first, unsigned* out_old_end,
+                      unsigned* out_new_length) {
+    /* the tokens before the first one which looked at the edit stay,
+       and lexing resumes where it was when it got to that one;
+       as the examined ends never decrease, it is found by binary search */
+    unsigned first = 0;
+    unsigned first_end = self->num_of_tokens;
+    while (first < first_end) {
+        const unsigned middle = first + (first_end - first) / 2;
+        if (self->spans[middle].examined_end <= edit_start) {
+            first = middle + 1;
+        } else {
+            first_end = middle;
+        }
+    }
+    unsigned pos = 0;
+    if (first == self->num_of_tokens && first != 0) {
+        pos = self->end_pos;
+    } else if (first != 0) {
+        pos = self->spans[first].start;
+    }
+
+    _lexOldTokens old;
+    old.spans = self->spans;
+    old.length = self->num_of_tokens;
+    old.first = first;
+    old.unchanged_from = edit_start + edit_new_length;
+    old.removed = edit_old_end - edit_start;
+    old.added = edit_new_length;
+    gsStack tokens, vals, spans;
+    gsStack_create_(&tokens, sizeof(unsigned));
+    gsStack_create_(&vals, sizeof(unsigned));
+    gsStack_create_(&spans, sizeof(lexTokenSpan));
+    unsigned old_end;
+    pos = _lexLexer_lex_(lexer, str, pos,
+                         first == 0 ? NULL : self->spans + first - 1,
+                         str_to_val_fn, extra, &tokens, &vals, &spans,
+                         &old, &old_end);
+    /* the tokens fallen in line with are where they were, shifted */
+    if (old_end < self->num_of_tokens) {
+        for (unsigned i = old_end; i < self->num_of_tokens; ++i) {
+            self->spans[i].start = self->spans[i].start
+                - old.removed + old.added;
+            self->spans[i].end = self->spans[i].end - old.removed + old.added;
+            self->spans[i].examined_end = self->spans[i].examined_end
+                - old.removed + old.added;
+        }
+        self->end_pos = self->end_pos - old.removed + old.added;
+        /* the examined ends of the new tokens carry on to the old ones
+           for as long as they exceed theirs */
+        const lexTokenSpan* last_span = NULL;
+        if (gsStack_length(&spans) != 0) {
+            last_span = gsStack_last(&spans);
+        } else if (first != 0) {
+            last_span = self->spans + first - 1;
+        }
+        for (unsigned i = old_end; last_span != NULL
+                 && i < self->num_of_tokens
+                 && self->spans[i].examined_end < last_span->examined_end;
+             ++i) {
+            self->spans[i].examined_end = last_span->examined_end;
+        }
+    } else {
+        self->end_pos = pos;
+    }
+
+    const unsigned new_length = gsStack_length(&tokens);
+    /* the arrays have one more element than there are tokens */
+    self->tokens = _lex_splice(self->tokens, sizeof(unsigned),
+                               self->num_of_tokens + 1, first, old_end,
+                               gsStack_0(&tokens), new_length);
+    if (self->vals != NULL) {
+        self->vals = _lex_splice(self->vals, sizeof(unsigned),
+                                 self->num_of_tokens + 1, first, old_end,
+                                 gsStack_0(&vals), new_length);
+    }
+    self->spans = _lex_splice(self->spans, sizeof(lexTokenSpan),
+                              self->num_of_tokens + 1, first, old_end,
+                              gsStack_0(&spans), new_length);
+    self->num_of_tokens = self->num_of_tokens - (old_end - first) + new_length;
+    gsStack_destroy_(&tokens);
+    gsStack_destroy_(&vals);
+    gsStack_destroy_(&spans);
+    *out_first = first;
+    *out_old_end = old_end;
+    *out_new_length = new_length;
+    return;
 }
 
 /*-------------------------*//*-------------------------*/
@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h> /* for UINT_MAX */
+#include <time.h> /* for clock */
 
 #include "standard.h"
 #include "ma.h"
@@ -19,6 +21,37 @@ typedef struct prProduction {
     unsigned* body;
 }                          prProduction;
 
+/*
+  a perfect hash of names to their indices (the names being kept elsewhere):
+  a name hashes to a bucket, whose displacement then hashes each of its
+  names to a slot of its own, so that a lookup compares a single name;
+  if no displacements were found (num_of_slots is 0), the names are just
+  scanned through
+*/
+typedef struct _prNameIndex {
+    unsigned num_of_buckets;
+    unsigned num_of_slots;
+    unsigned* displacements;
+    /* the index of the name in each slot, or the number of names if none */
+    unsigned* slots;
+}                          _prNameIndex;
+
+typedef enum _prAssociativity {
+    PR_ASSOCIATIVITY_LEFT,
+    PR_ASSOCIATIVITY_RIGHT,
+    PR_ASSOCIATIVITY_NONASSOC
+}                          _prAssociativity;
+
+/* the part a production plays in a list (or option) written in the spec
+   with @*, @+ or @? */
+typedef enum _prListRole {
+    PR_LIST_ROLE_NONE,
+    /* L -> or L -> X, the first of a list */
+    PR_LIST_ROLE_START,
+    /* L -> L X */
+    PR_LIST_ROLE_APPEND
+}                          _prListRole;
+
 struct prGrammar {
     unsigned num_of_productions;
     unsigned max_production_body_length;
@@ -27,12 +60,37 @@ struct prGrammar {
     char** token_names;
     char** production_names;
     prProduction* productions;
+    /* the terminals the parser resynchronizes on after an error */
+    unsigned num_of_synchronizing_tokens;
+    unsigned* synchronizing_tokens;
+    /* the precedence levels of the terminals and of the productions
+       (0 for none), numbered from 1 in the order of the lines of the
+       "@@precedence" section, so that the higher binds tighter,
+       and the associativity of each level (at associativities[level-1]) */
+    unsigned num_of_precedence_levels;
+    _prAssociativity* associativities;
+    unsigned* terminal_precedences;
+    unsigned* production_precedences;
+    /* the list role of each production, and whether each token is
+       a list (heading productions of the role PR_LIST_ROLE_START) */
+    _prListRole* list_roles;
+    boolean* is_list;
+    _prNameIndex token_name_index;
+    _prNameIndex production_name_index;
 };
 
 struct prSLRParser {
     faDfaBt self_as_faDfaBt;
 };
 
+struct prSLRPushParser {
+    faDfaBtPushParse self_as_faDfaBtPushParse;
+};
+
+struct prSLRIncrementalParser {
+    faDfaBtIncrementalParse self_as_faDfaBtIncrementalParse;
+};
+
 /*-------------------------*/
 
 static const prProduction* prGrammar_production(const prGrammar* self,
@@ -40,14 +98,207 @@ static const prProduction* prGrammar_production(const prGrammar* self,
     return self->productions + id;
 }
 
+/* FNV-1a, with the seed mixed into the offset basis */
+static unsigned _pr_hash(const char* name, unsigned seed) {
+    unsigned hash = 2166136261u ^ (seed * 16777619u);
+    for (; *name != 0; ++name) {
+        hash ^= (unsigned char) *name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* displacements are tried up to this before the index is given up on */
+#define PR_NAME_INDEX_MAX_DISPLACEMENT 4096
+
+static void _prNameIndex_destroy_(_prNameIndex* self) {
+    FREE(self->displacements);
+    FREE(self->slots);
+    return;
+}
+
+static unsigned _prNameIndex_slot(const _prNameIndex* self, const char* name,
+                                  unsigned displacement) {
+    return _pr_hash(name, displacement + 1) % self->num_of_slots;
+}
+
+/* names may have NULLs (which are not indexed) and repetitions
+   (of which the first is indexed) */
+static void _prNameIndex_create_(_prNameIndex* self, unsigned num_of_names,
+                                 char* const* names) {
+    unsigned num_of_indexed = 0;
+    for (unsigned i = 0; i < num_of_names; ++i) {
+        if (names[i] != NULL) {
+            ++num_of_indexed;
+        }
+    }
+    self->num_of_buckets = num_of_indexed / 4 + 1;
+    self->num_of_slots = num_of_indexed + num_of_indexed / 4 + 1;
+    self->displacements = CALLOC(self->num_of_buckets, sizeof(unsigned));
+    self->slots = MALLOC(self->num_of_slots * sizeof(unsigned));
+    for (unsigned slot = 0; slot < self->num_of_slots; ++slot) {
+        self->slots[slot] = num_of_names;
+    }
+
+    /* the names of bucket b are bucket_names[offsets[b]], ...,
+       bucket_names[offsets[b+1]-1], in increasing order */
+    unsigned* const offsets = CALLOC(self->num_of_buckets + 1, sizeof(unsigned));
+    unsigned* const bucket_names = MALLOC(num_of_indexed * sizeof(unsigned));
+    unsigned* const buckets = MALLOC(self->num_of_buckets * sizeof(unsigned));
+    unsigned* const bucket_slots = MALLOC(num_of_indexed * sizeof(unsigned));
+    for (unsigned i = 0; i < num_of_names; ++i) {
+        if (names[i] != NULL) {
+            ++offsets[_pr_hash(names[i], 0) % self->num_of_buckets + 1];
+        }
+    }
+    for (unsigned b = 0; b < self->num_of_buckets; ++b) {
+        offsets[b+1] += offsets[b];
+        buckets[b] = b;
+    }
+    for (unsigned i = 0; i < num_of_names; ++i) {
+        if (names[i] != NULL) {
+            bucket_names[offsets[_pr_hash(names[i], 0) % self->num_of_buckets]++] = i;
+        }
+    }
+    for (unsigned b = self->num_of_buckets; b > 0; --b) {
+        offsets[b] = offsets[b-1];
+    }
+    offsets[0] = 0;
+    /* the bigger buckets are placed first, while most slots are free */
+    for (unsigned i = 1; i < self->num_of_buckets; ++i) {
+        const unsigned b = buckets[i];
+        unsigned j = i;
+        for (; j > 0 && offsets[buckets[j-1]+1] - offsets[buckets[j-1]]
+                 < offsets[b+1] - offsets[b]; --j) {
+            buckets[j] = buckets[j-1];
+        }
+        buckets[j] = b;
+    }
+
+    for (unsigned i = 0; i < self->num_of_buckets; ++i) {
+        const unsigned b = buckets[i];
+        unsigned displacement = 0;
+        for (; displacement < PR_NAME_INDEX_MAX_DISPLACEMENT; ++displacement) {
+            boolean is_fitting = true;
+            for (unsigned k = offsets[b]; k < offsets[b+1]; ++k) {
+                const char* const name = names[bucket_names[k]];
+                bucket_slots[k] = _prNameIndex_slot(self, name, displacement);
+                if (self->slots[bucket_slots[k]] != num_of_names) {
+                    is_fitting = false;
+                }
+                for (unsigned l = offsets[b]; l < k && is_fitting == true; ++l) {
+                    if (bucket_slots[l] == bucket_slots[k]
+                        && str_equal_to(names[bucket_names[l]], name) == false) {
+                        is_fitting = false;
+                    }
+                }
+                if (is_fitting == false) {
+                    break;
+                }
+            }
+            if (is_fitting == true) {
+                break;
+            }
+        }
+        if (displacement == PR_NAME_INDEX_MAX_DISPLACEMENT) {
+            self->num_of_slots = 0;
+            break;
+        }
+        self->displacements[b] = displacement;
+        /* backwards, so that the first of repeated names is the one kept */
+        for (unsigned k = offsets[b+1]; k > offsets[b]; --k) {
+            self->slots[bucket_slots[k-1]] = bucket_names[k-1];
+        }
+    }
+
+    FREE(bucket_slots);
+    FREE(buckets);
+    FREE(bucket_names);
+    FREE(offsets);
+    return;
+}
+
+static unsigned _prNameIndex_find(const _prNameIndex* self,
+                                  unsigned num_of_names, char* const* names,
+                                  const char* name) {
+    if (self->num_of_slots == 0) {
+        return str_equal_to_one_of(name, num_of_names,
+                                   (const char* const*) names);
+    }
+    const unsigned bucket = _pr_hash(name, 0) % self->num_of_buckets;
+    const unsigned i = self->slots[_prNameIndex_slot(self, name,
+                                                     self->displacements[bucket])];
+    if (i == num_of_names || str_equal_to(names[i], name) == false) {
+        return num_of_names;
+    }
+    return i;
+}
+
+/* indexes the names, once the grammar is read */
+static void _prGrammar_index_names_(prGrammar* self) {
+    _prNameIndex_create_(&self->token_name_index, self->num_of_tokens,
+                         self->token_names);
+    _prNameIndex_create_(&self->production_name_index,
+                         self->num_of_productions, self->production_names);
+    return;
+}
+
+/* finds the lists, once the grammar is read */
+static void _prGrammar_mark_lists_(prGrammar* self) {
+    self->is_list = CALLOC(self->num_of_tokens + 1, sizeof(boolean));
+    for (unsigned i = 0; i < self->num_of_productions; ++i) {
+        if (self->list_roles[i] == PR_LIST_ROLE_START) {
+            self->is_list[self->productions[i].head] = true;
+        }
+    }
+    return;
+}
+
+unsigned prGrammar_num_of_tokens(const prGrammar* self) {
+    return self->num_of_tokens;
+}
+
+unsigned prGrammar_num_of_productions(const prGrammar* self) {
+    return self->num_of_productions;
+}
+
 unsigned prGrammar_token_by_name(const prGrammar* self, const char *name) {
-    return str_equal_to_one_of(name, self->num_of_tokens,
-			       (const char**) self->token_names);
+    return _prNameIndex_find(&self->token_name_index, self->num_of_tokens,
+                             self->token_names, name);
 }
 
 unsigned prGrammar_production_by_name(const prGrammar* self, const char *name) {
-    return str_equal_to_one_of(name, self->num_of_productions,
-                               (const char**) self->production_names);
+    return _prNameIndex_find(&self->production_name_index,
+                             self->num_of_productions, self->production_names,
+                             name);
+}
+
+boolean prGrammar_tokens_by_names(const prGrammar* self,
+                                  unsigned num_of_names,
+                                  const char* const* names,
+                                  unsigned* out_tokens) {
+    boolean are_all_found = true;
+    for (unsigned i = 0; i < num_of_names; ++i) {
+        out_tokens[i] = prGrammar_token_by_name(self, names[i]);
+        if (out_tokens[i] == self->num_of_tokens) {
+            are_all_found = false;
+        }
+    }
+    return are_all_found;
+}
+
+boolean prGrammar_productions_by_names(const prGrammar* self,
+                                       unsigned num_of_names,
+                                       const char* const* names,
+                                       unsigned* out_productions) {
+    boolean are_all_found = true;
+    for (unsigned i = 0; i < num_of_names; ++i) {
+        out_productions[i] = prGrammar_production_by_name(self, names[i]);
+        if (out_productions[i] == self->num_of_productions) {
+            are_all_found = false;
+        }
+    }
+    return are_all_found;
 }
 
 void prGrammar_destroy_(prGrammar* self) {
@@ -66,6 +317,14 @@ void prGrammar_destroy_(prGrammar* self) {
         FREE(self->productions[i].body);
     }
     FREE(self->productions);
+    FREE(self->synchronizing_tokens);
+    FREE(self->associativities);
+    FREE(self->terminal_precedences);
+    FREE(self->production_precedences);
+    FREE(self->list_roles);
+    FREE(self->is_list);
+    _prNameIndex_destroy_(&self->token_name_index);
+    _prNameIndex_destroy_(&self->production_name_index);
     return;
 }
 
@@ -78,99 +337,685 @@ void prGrammar_destroy(prGrammar* self) {
     return;
 }
 
-static prGrammar* prGrammar_create_from_spec_given_terminal_names_(
-    prGrammar* self,
-    const char* spec,
-    unsigned terminal_names_list_length,
-    const char* const* terminal_names_list,
-    char* out_diagnostic) {
+/* whether cursor is at the start of a section following the non-terminals */
+static boolean _pr_is_at_section(const char* cursor) {
+    return str_starts_with(cursor, "@@synchronizing") != NULL
+        || str_starts_with(cursor, "@@precedence") != NULL
+        || str_starts_with(cursor, "@@productions") != NULL;
+}
 
-    const char str_nonterminals[] = "@@nonterminals";
-    const char str_productions[] = "@@productions";
-    const char str_formal[] = "<formal>";
-    const char str_to[] = "->";
+/*
+  reads the names of the synchronizing tokens, which should be terminals
+  (the first num_of_terminals of token_names), up to the next section,
+  returning the cursor at it, or NULL on failure
+*/
+static const char* _prGrammar_read_synchronizing_tokens(const char* cursor,
+                                                        const gsStack* token_names,
+                                                        unsigned num_of_terminals,
+                                                        gsStack* synchronizing_tokens,
+                                                        char* out_diagnostic) {
+    for (;;) {
+        if (_pr_is_at_section(cursor) == true) {
+            return cursor;
+        }
+        const char* const cursor_next = str_while_visible(cursor);
+        if (cursor_next == cursor) {
+            return NULL;
+        }
+        char* const name = str_create_copy_from_to(cursor, cursor_next);
+        const unsigned token =
+            str_equal_to_one_of(name, num_of_terminals,
+                                (const char* const*) gsStack_0(token_names));
+        if (token == num_of_terminals) {
+            if (out_diagnostic != NULL) {
+                sprintf(out_diagnostic,
+                        "Error parsing grammar file: the synchronizing "
+                        "token %s is not a terminal.\n", name);
+            }
+            FREE(name);
+            return NULL;
+        }
+        FREE(name);
+        GS_APPEND(synchronizing_tokens, token, unsigned);
+        cursor = str_while_not_visible(cursor_next);
+    }
+}
 
-    self->num_of_productions = 0;
-    self->max_production_body_length = 0;
-    self->num_of_tokens = 0;
-    self->num_of_terminals = terminal_names_list_length;
-    self->token_names = NULL;
-    self->productions = NULL;
-    self->production_names = NULL;
+/*
+  the precedences read from a spec, before the grammar takes them over;
+  the names in the "@@precedence" section which are not terminals
+  (such as UMINUS) only give their levels to the productions naming
+  them with "@prec", so they are kept just while reading
+*/
+typedef struct _prSpecPrecedences {
+    /* of _prAssociativity, one for each level */
+    gsStack associativities;
+    /* of unsigned, one for each terminal once the terminals are read */
+    gsStack terminal_precedences;
+    /* of unsigned, one for each production read */
+    gsStack production_precedences;
+    /* of char* and of unsigned */
+    gsStack pseudo_names;
+    gsStack pseudo_levels;
+} _prSpecPrecedences;
+
+static void _prSpecPrecedences_create_(_prSpecPrecedences* self) {
+    gsStack_create_(&self->associativities, sizeof(_prAssociativity));
+    gsStack_create_(&self->terminal_precedences, sizeof(unsigned));
+    gsStack_create_(&self->production_precedences, sizeof(unsigned));
+    gsStack_create_(&self->pseudo_names, sizeof(char*));
+    gsStack_create_(&self->pseudo_levels, sizeof(unsigned));
+    return;
+}
 
-    gsStack token_names, production_names, productions, body;
-    gsStack_create_(&token_names, sizeof(char*));
-    gsStack_create_(&production_names, sizeof(char*));
-    gsStack_create_(&productions, sizeof(prProduction));
-    gsStack_create_(&body, sizeof(unsigned));
+/* frees what the grammar has not taken over */
+static void _prSpecPrecedences_destroy_(_prSpecPrecedences* self) {
+    char** const names = gsStack_0(&self->pseudo_names);
+    for (unsigned i = 0; i < gsStack_length(&self->pseudo_names); ++i) {
+        FREE(names[i]);
+    }
+    gsStack_destroy_(&self->pseudo_levels);
+    gsStack_destroy_(&self->pseudo_names);
+    gsStack_destroy_(&self->production_precedences);
+    gsStack_destroy_(&self->terminal_precedences);
+    gsStack_destroy_(&self->associativities);
+    return;
+}
 
-    /* read terminals names */
+/* the grammar takes the levels over, and self is destroyed */
+static void _prSpecPrecedences_finalize_(_prSpecPrecedences* self,
+                                         prGrammar* grammar) {
+    grammar->num_of_precedence_levels =
+        gsStack_length(&self->associativities);
+    grammar->associativities = gsStack_0(&self->associativities);
+    grammar->terminal_precedences = gsStack_0(&self->terminal_precedences);
+    grammar->production_precedences =
+        gsStack_0(&self->production_precedences);
+    gsStack_create_(&self->associativities, sizeof(_prAssociativity));
+    gsStack_create_(&self->terminal_precedences, sizeof(unsigned));
+    gsStack_create_(&self->production_precedences, sizeof(unsigned));
+    _prSpecPrecedences_destroy_(self);
+    return;
+}
 
-    for (unsigned i = 0; i < self->num_of_terminals; ++i) {
-        GS_APPEND (&token_names, str_create_copy(terminal_names_list[i]),
-                   char*);
+/* the level of the terminal or pseudo name, or 0 if it has none */
+static unsigned _prSpecPrecedences_level(const _prSpecPrecedences* self,
+                                         const gsStack* token_names,
+                                         const char* name) {
+    const unsigned num_of_terminals =
+        gsStack_length(&self->terminal_precedences);
+    const unsigned token =
+        str_equal_to_one_of(name, num_of_terminals,
+                            (const char* const*) gsStack_0(token_names));
+    if (token != num_of_terminals) {
+        return ((unsigned*) gsStack_0(&self->terminal_precedences))[token];
     }
+    const unsigned pseudo =
+        str_equal_to_one_of(name, gsStack_length(&self->pseudo_names),
+                            (const char* const*) gsStack_0(&self->pseudo_names));
+    if (pseudo != gsStack_length(&self->pseudo_names)) {
+        return ((unsigned*) gsStack_0(&self->pseudo_levels))[pseudo];
+    }
+    return 0;
+}
 
-    /* skip to non-terminals names */
-
-    const char* cursor = spec;
-    const char* cursor_next;
-    for(;;) {
-        cursor_next = str_starts_with(cursor, str_nonterminals);
-        if (cursor_next != NULL) {
-            break;
+/*
+  reads the lines of the "@@precedence" section, each of "@left", "@right"
+  or "@nonassoc" and then the terminals (or pseudo names) of a level,
+  up to the next section, returning the cursor at it, or NULL on failure
+*/
+static const char* _prGrammar_read_precedences(const char* cursor,
+                                               const gsStack* token_names,
+                                               _prSpecPrecedences* precedences,
+                                               char* out_diagnostic) {
+    const unsigned num_of_tokens = gsStack_length(token_names);
+    const unsigned num_of_terminals =
+        gsStack_length(&precedences->terminal_precedences);
+    while (_pr_is_at_section(cursor) == false) {
+        const char* cursor_next;
+        _prAssociativity associativity;
+        if ((cursor_next = str_starts_with(cursor, "@left")) != NULL) {
+            associativity = PR_ASSOCIATIVITY_LEFT;
+        } else if ((cursor_next = str_starts_with(cursor, "@right")) != NULL) {
+            associativity = PR_ASSOCIATIVITY_RIGHT;
+        } else if ((cursor_next = str_starts_with(cursor, "@nonassoc"))
+                   != NULL) {
+            associativity = PR_ASSOCIATIVITY_NONASSOC;
+        } else {
+            if (out_diagnostic != NULL) {
+                sprintf(out_diagnostic,
+                        "Error parsing grammar file: a precedence line "
+                        "should start with @left, @right or @nonassoc.\n");
+            }
+            return NULL;
         }
-        cursor_next = str_while_visible(cursor);
+        GS_APPEND(&precedences->associativities, associativity,
+                  _prAssociativity);
+        const unsigned level = gsStack_length(&precedences->associativities);
+        cursor = str_while_not_visible_except_newline(cursor_next);
+        while (*cursor != 0 && *cursor != '\n') {
+            cursor_next = str_while_visible(cursor);
+            char* const name = str_create_copy_from_to(cursor, cursor_next);
+            const unsigned token =
+                str_equal_to_one_of(name, num_of_tokens,
+                                    (const char* const*) gsStack_0(token_names));
+            if (_prSpecPrecedences_level(precedences, token_names, name) != 0
+                || (token >= num_of_terminals && token < num_of_tokens)) {
+                if (out_diagnostic != NULL) {
+                    sprintf(out_diagnostic,
+                            "Error parsing grammar file: %s is a non-terminal "
+                            "or is given a precedence twice.\n", name);
+                }
+                FREE(name);
+                return NULL;
+            }
+            if (token < num_of_terminals) {
+                ((unsigned*) gsStack_0(&precedences->terminal_precedences))
+                    [token] = level;
+                FREE(name);
+            } else {
+                GS_APPEND(&precedences->pseudo_names, name, char*);
+                GS_APPEND(&precedences->pseudo_levels, level, unsigned);
+            }
+            cursor = str_while_not_visible_except_newline(cursor_next);
+        }
+        cursor = str_while_not_visible(cursor);
+    }
+    return cursor;
+}
+
+/*
+  reads the non-terminals names, and then the optional "@@synchronizing"
+  and "@@precedence" sections, up to "@@productions";
+  returns the cursor at the first production, or NULL on failure
+*/
+static const char* _prGrammar_read_nonterminals(const char* cursor,
+                                                gsStack* token_names,
+                                                unsigned num_of_terminals,
+                                                gsStack* synchronizing_tokens,
+                                                _prSpecPrecedences* precedences,
+                                                char* out_diagnostic) {
+    const char str_synchronizing[] = "@@synchronizing";
+    const char str_precedence[] = "@@precedence";
+    const char str_productions[] = "@@productions";
+
+    while (_pr_is_at_section(cursor) == false) {
+        const char* const cursor_next = str_while_visible(cursor);
         if (cursor_next == cursor) {
-            goto error_label;
+            return NULL;
         }
+        GS_APPEND(token_names, str_create_copy_from_to(cursor, cursor_next),
+                  char*);
         cursor = str_while_not_visible(cursor_next);
     }
-    self->num_of_terminals = gsStack_length(&token_names);
-    cursor = str_while_not_visible(cursor_next);
 
-    /* read non-terminals names */
+    gsStack_pre_append_several_(&precedences->terminal_precedences,
+                                num_of_terminals);
+    memset(gsStack_0(&precedences->terminal_precedences), 0,
+           num_of_terminals * sizeof(unsigned));
 
-    for(;;) {
-        cursor_next = str_starts_with(cursor, str_productions);
-        if (cursor_next != NULL) {
+    for (;;) {
+        const char* cursor_next;
+        if ((cursor_next = str_starts_with(cursor, str_productions)) != NULL) {
+            return str_while_not_visible(cursor_next);
+        }
+        if ((cursor_next = str_starts_with(cursor, str_synchronizing))
+            != NULL) {
+            cursor = _prGrammar_read_synchronizing_tokens(
+                str_while_not_visible(cursor_next), token_names,
+                num_of_terminals, synchronizing_tokens, out_diagnostic);
+        } else {
+            cursor_next = str_starts_with(cursor, str_precedence);
+            cursor = _prGrammar_read_precedences(
+                str_while_not_visible(cursor_next), token_names,
+                precedences, out_diagnostic);
+        }
+        if (cursor == NULL) {
+            return NULL;
+        }
+    }
+}
+
+/*
+  a trie of the token names, which finds the longest of them starting a
+  string in time linear in its length, rather than trying every name;
+  the nodes are kept in a gsStack, the root being the first
+*/
+typedef struct _prNameTrieNode {
+    /* 0 if none, as the root is never a child */
+    unsigned first_child;
+    unsigned next_sibling;
+    /* the token whose name ends here plus 1, or 0 if none */
+    unsigned token;
+    char character;
+}                          _prNameTrieNode;
+
+static void _prNameTrie_create_(gsStack* nodes) {
+    gsStack_create_(nodes, sizeof(_prNameTrieNode));
+    gsStack_pre_append_(nodes);
+    _prNameTrieNode* const root = gsStack_0(nodes);
+    root->first_child = 0;
+    root->next_sibling = 0;
+    root->token = 0;
+    root->character = 0;
+    return;
+}
+
+/* if a name is repeated, the first token having it is the one found */
+static void _prNameTrie_insert_(gsStack* nodes, const char* name,
+                                unsigned token) {
+    unsigned node = 0;
+    for (; *name != 0; ++name) {
+        unsigned child =
+            ((_prNameTrieNode*) gsStack_0(nodes))[node].first_child;
+        while (child != 0
+               && ((_prNameTrieNode*) gsStack_0(nodes))[child].character
+               != *name) {
+            child = ((_prNameTrieNode*) gsStack_0(nodes))[child].next_sibling;
+        }
+        if (child == 0) {
+            child = gsStack_length(nodes);
+            gsStack_pre_append_(nodes);
+            _prNameTrieNode* const trie = gsStack_0(nodes);
+            trie[child].first_child = 0;
+            trie[child].next_sibling = trie[node].first_child;
+            trie[child].token = 0;
+            trie[child].character = *name;
+            trie[node].first_child = child;
+        }
+        node = child;
+    }
+    _prNameTrieNode* const trie = gsStack_0(nodes);
+    if (trie[node].token == 0) {
+        trie[node].token = token + 1;
+    }
+    return;
+}
+
+/* as str_starts_with_one_of over the names inserted */
+static const char* _prNameTrie_longest_match(const gsStack* nodes,
+                                             const char* str,
+                                             unsigned* out_token) {
+    const _prNameTrieNode* const trie = gsStack_0(nodes);
+    const char* winning_cursor = NULL;
+    unsigned node = 0;
+    for (const char* cursor = str; *cursor != 0; ++cursor) {
+        node = trie[node].first_child;
+        while (node != 0 && trie[node].character != *cursor) {
+            node = trie[node].next_sibling;
+        }
+        if (node == 0) {
             break;
         }
-        cursor_next = str_while_visible(cursor);
-        if (cursor_next == cursor) {
-            goto error_label;
+        if (trie[node].token != 0) {
+            *out_token = trie[node].token - 1;
+            winning_cursor = cursor + 1;
         }
-        GS_APPEND(&token_names, str_create_copy_from_to(cursor, cursor_next),
-                  char*);
-        cursor = str_while_not_visible(cursor_next);
     }
-    cursor = str_while_not_visible(cursor_next);
+    return winning_cursor;
+}
+
+/*
+  a symbol of a body followed by @*, @+ or @? stands for a non-terminal
+  added with its productions, named after the symbol: X@* for <X*> -> and
+  <X*> -> <X*> X, X@+ for <X+> -> X and <X+> -> <X+> X, and X@? for
+  <X?> -> and <X?> -> X; symbols between @( and @) are a group, which
+  is as its symbols unless followed by one of those, and then stands for
+  a non-terminal <( ... )> added with the production <( ... )> -> ...;
+  the added non-terminals are appended to the token names (after the
+  formal one until the productions are read), and reused when repeated,
+  but may not be named as a declared token is; the added productions
+  take their precedences as the productions read do from their bodies
+*/
+typedef struct _prBodyReader {
+    const gsStack* trie;
+    gsStack* token_names;
+    unsigned first_added;
+    const unsigned* terminal_precedences;
+    unsigned num_of_terminals;
+    /* of prProduction, of _prListRole and of unsigned, those added */
+    gsStack productions;
+    gsStack list_roles;
+    gsStack precedences;
+}                          _prBodyReader;
+
+static void _prBodyReader_create_(_prBodyReader* self, const gsStack* trie,
+                                  gsStack* token_names,
+                                  const _prSpecPrecedences* precedences) {
+    self->trie = trie;
+    self->token_names = token_names;
+    self->first_added = gsStack_length(token_names);
+    self->terminal_precedences =
+        gsStack_0(&precedences->terminal_precedences);
+    self->num_of_terminals =
+        gsStack_length(&precedences->terminal_precedences);
+    gsStack_create_(&self->productions, sizeof(prProduction));
+    gsStack_create_(&self->list_roles, sizeof(_prListRole));
+    gsStack_create_(&self->precedences, sizeof(unsigned));
+    return;
+}
+
+/* the bodies of the productions are left to whoever took them */
+static void _prBodyReader_destroy_(_prBodyReader* self) {
+    gsStack_destroy_(&self->productions);
+    gsStack_destroy_(&self->list_roles);
+    gsStack_destroy_(&self->precedences);
+    return;
+}
+
+/* the precedence of the last terminal of body having one, or 0 */
+static unsigned _pr_body_precedence(const unsigned* body,
+                                    unsigned body_length,
+                                    const unsigned* terminal_precedences,
+                                    unsigned num_of_terminals) {
+    for (unsigned i = body_length; i > 0; --i) {
+        if (body[i - 1] < num_of_terminals
+            && terminal_precedences[body[i - 1]] != 0) {
+            return terminal_precedences[body[i - 1]];
+        }
+    }
+    return 0;
+}
+
+/* takes name over; returns false (with a diagnostic) if a declared token
+   has the name */
+static boolean _prBodyReader_add_nonterminal_(_prBodyReader* self,
+                                              char* name,
+                                              unsigned* out_nonterminal,
+                                              boolean* out_is_new,
+                                              char* out_diagnostic) {
+    char** const token_names = gsStack_0(self->token_names);
+    const unsigned num_of_tokens = gsStack_length(self->token_names);
+    for (unsigned i = 0; i < num_of_tokens; ++i) {
+        if (str_equal_to(token_names[i], name) == false) {
+            continue;
+        }
+        if (i < self->first_added) {
+            if (out_diagnostic != NULL) {
+                sprintf(out_diagnostic,
+                        "Error parsing grammar file: the non-terminal %s "
+                        "standing for a repetition, an option or a group "
+                        "is also declared.\n", name);
+            }
+            FREE(name);
+            return false;
+        }
+        FREE(name);
+        *out_nonterminal = i;
+        *out_is_new = false;
+        return true;
+    }
+    GS_APPEND(self->token_names, name, char*);
+    *out_nonterminal = num_of_tokens;
+    *out_is_new = true;
+    return true;
+}
+
+static void _prBodyReader_add_production_(_prBodyReader* self, unsigned head,
+                                          const unsigned* body,
+                                          unsigned body_length,
+                                          _prListRole list_role) {
+    GS_APPEND(&self->precedences,
+              _pr_body_precedence(body, body_length,
+                                  self->terminal_precedences,
+                                  self->num_of_terminals), unsigned);
+    gsStack production_body;
+    gsStack_create_(&production_body, sizeof(unsigned));
+    for (unsigned i = 0; i < body_length; ++i) {
+        GS_APPEND(&production_body, body[i], unsigned);
+    }
+    gsStack_pre_append_(&self->productions);
+    prProduction* const production = gsStack_last(&self->productions);
+    production->head = head;
+    production->body_length = body_length;
+    production->body = gsStack_0(&production_body);
+    GS_APPEND(&self->list_roles, list_role, _prListRole);
+    return;
+}
+
+/* the operator of @*, @+ or @? at cursor, or 0 if none */
+static char _pr_list_operator(const char* cursor) {
+    if (cursor[0] == '@'
+        && (cursor[1] == '*' || cursor[1] == '+' || cursor[1] == '?')) {
+        return cursor[1];
+    }
+    return 0;
+}
+
+/* sets *inout_symbol to the list of it; returns false on failure */
+static boolean _prBodyReader_add_list_(_prBodyReader* self,
+                                       unsigned* inout_symbol, char operator,
+                                       char* out_diagnostic) {
+    unsigned symbol = *inout_symbol;
+    const char* symbol_name = ((char**) gsStack_0(self->token_names))[symbol];
+    size_t length = strlen(symbol_name);
+    /* <X*>@? is named <X*?> rather than <<X*>?> */
+    if (symbol >= self->first_added) {
+        ++symbol_name;
+        length -= 2;
+    }
+    char* const name = MALLOC(length + 4);
+    name[0] = '<';
+    memcpy(name + 1, symbol_name, length);
+    name[length + 1] = operator;
+    name[length + 2] = '>';
+    name[length + 3] = 0;
+    unsigned list;
+    boolean is_new;
+    if (_prBodyReader_add_nonterminal_(self, name, &list, &is_new,
+                                       out_diagnostic) == false) {
+        return false;
+    }
+    if (is_new == true) {
+        const unsigned appending_body[2] = {list, symbol};
+        _prBodyReader_add_production_(self, list, &symbol,
+                                      operator == '+' ? 1 : 0,
+                                      PR_LIST_ROLE_START);
+        if (operator == '?') {
+            _prBodyReader_add_production_(self, list, &symbol, 1,
+                                          PR_LIST_ROLE_START);
+        } else {
+            _prBodyReader_add_production_(self, list, appending_body, 2,
+                                          PR_LIST_ROLE_APPEND);
+        }
+    }
+    *inout_symbol = list;
+    return true;
+}
+
+/* returns false on failure */
+static boolean _prBodyReader_add_group_(_prBodyReader* self,
+                                        const gsStack* group,
+                                        unsigned* out_nonterminal,
+                                        char* out_diagnostic) {
+    char** const token_names = gsStack_0(self->token_names);
+    const unsigned* const symbols = gsStack_0(group);
+    const unsigned num_of_symbols = gsStack_length(group);
+    size_t length = strlen("<( )>");
+    for (unsigned i = 0; i < num_of_symbols; ++i) {
+        length += strlen(token_names[symbols[i]]) + 1;
+    }
+    char* const name = MALLOC(length + 1);
+    strcpy(name, "<(");
+    for (unsigned i = 0; i < num_of_symbols; ++i) {
+        strcat(name, " ");
+        strcat(name, token_names[symbols[i]]);
+    }
+    strcat(name, " )>");
+    boolean is_new;
+    if (_prBodyReader_add_nonterminal_(self, name, out_nonterminal, &is_new,
+                                       out_diagnostic) == false) {
+        return false;
+    }
+    if (is_new == true) {
+        _prBodyReader_add_production_(self, *out_nonterminal, symbols,
+                                      num_of_symbols, PR_LIST_ROLE_NONE);
+    }
+    return true;
+}
+
+/*
+  reads a symbol or a group, with the @*, @+ and @? following it,
+  appending what it stands for to body; returns the cursor after it,
+  or NULL on failure
+*/
+static const char* _prBodyReader_read_symbol_(_prBodyReader* self,
+                                              const char* cursor,
+                                              gsStack* body,
+                                              char* out_diagnostic) {
+    unsigned symbol;
+    const char* cursor_next = str_starts_with(cursor, "@(");
+    if (cursor_next != NULL) {
+        gsStack group;
+        gsStack_create_(&group, sizeof(unsigned));
+        cursor = str_while_not_visible_except_newline(cursor_next);
+        while (str_starts_with(cursor, "@)") == NULL) {
+            if (*cursor == 0 || *cursor == '\n') {
+                if (out_diagnostic != NULL) {
+                    sprintf(out_diagnostic,
+                            "Error parsing grammar file: a group "
+                            "@( of a production has no @).\n");
+                }
+                gsStack_destroy_(&group);
+                return NULL;
+            }
+            cursor = _prBodyReader_read_symbol_(self, cursor, &group,
+                                                out_diagnostic);
+            if (cursor == NULL) {
+                gsStack_destroy_(&group);
+                return NULL;
+            }
+            cursor = str_while_not_visible_except_newline(cursor);
+        }
+        cursor += 2;
+        if (gsStack_length(&group) == 0) {
+            if (out_diagnostic != NULL) {
+                sprintf(out_diagnostic,
+                        "Error parsing grammar file: a group "
+                        "@( @) of a production is empty.\n");
+            }
+            gsStack_destroy_(&group);
+            return NULL;
+        }
+        if (_pr_list_operator(str_while_not_visible_except_newline(cursor))
+            == 0) {
+            for (unsigned i = 0; i < gsStack_length(&group); ++i) {
+                GS_APPEND(body, ((unsigned*) gsStack_0(&group))[i], unsigned);
+            }
+            gsStack_destroy_(&group);
+            return cursor;
+        }
+        symbol = * (unsigned*) gsStack_0(&group);
+        const boolean is_added = gsStack_length(&group) == 1
+            || _prBodyReader_add_group_(self, &group, &symbol,
+                                        out_diagnostic) == true;
+        gsStack_destroy_(&group);
+        if (is_added == false) {
+            return NULL;
+        }
+    } else {
+        cursor_next = _prNameTrie_longest_match(self->trie, cursor, &symbol);
+        if (cursor_next == NULL) {
+            if (out_diagnostic != NULL) {
+                char* what_was_not_found =
+                    str_create_copy_from_to(cursor, str_while_visible(cursor));
+                sprintf(out_diagnostic,
+                        "Error parsing grammar file: did not find the "
+                        "token %s encountered in a production.\n",
+                        what_was_not_found);
+                FREE(what_was_not_found);
+            }
+            return NULL;
+        }
+        cursor = cursor_next;
+    }
+    for (;;) {
+        cursor_next = str_while_not_visible_except_newline(cursor);
+        const char operator = _pr_list_operator(cursor_next);
+        if (operator == 0) {
+            break;
+        }
+        if (_prBodyReader_add_list_(self, &symbol, operator,
+                                    out_diagnostic) == false) {
+            return NULL;
+        }
+        cursor = cursor_next + 2;
+    }
+    GS_APPEND(body, symbol, unsigned);
+    return cursor;
+}
+
+/* where token goes once the start and formal non-terminals (start and
+   start + 1) are moved after the num_of_added non-terminals following them */
+static unsigned _pr_moved_token(unsigned token, unsigned start,
+                                unsigned num_of_added) {
+    if (token < start) {
+        return token;
+    }
+    return token < start + 2 ? token + num_of_added : token - 2;
+}
+
+/*
+  adds the formal non-terminal and the formal production, and then reads
+  the productions from cursor to the end of the spec, with their
+  precedences (that of "@prec NAME" ending the production, or else that
+  of the last terminal of the body having one) and list roles, the
+  non-terminals and productions added for the bodies (see _prBodyReader)
+  being last but for the start and formal non-terminals; the stacks keep
+  what was read even on failure, for the caller to free
+*/
+static boolean _prGrammar_read_productions(const char* cursor,
+                                           gsStack* token_names,
+                                           gsStack* productions,
+                                           gsStack* production_names,
+                                           gsStack* body,
+                                           _prSpecPrecedences* precedences,
+                                           gsStack* list_roles,
+                                           char* out_diagnostic) {
+    const char str_formal[] = "<formal>";
+    const char str_to[] = "->";
+    const char str_prec[] = "@prec";
+    const unsigned* const terminal_precedences =
+        gsStack_0(&precedences->terminal_precedences);
+    const unsigned num_of_terminals =
+        gsStack_length(&precedences->terminal_precedences);
 
     /* add formal non-terminal */
-    GS_APPEND(&token_names, str_create_copy(str_formal), char*);
+    GS_APPEND(token_names, str_create_copy(str_formal), char*);
 
     /* add formal production */
-    gsStack_pre_append_(&productions);
-    prProduction* const first_production = gsStack_last(&productions);
-    first_production->head = gsStack_length(&token_names) - 1;
+    gsStack_pre_append_(productions);
+    prProduction* const first_production = gsStack_last(productions);
+    first_production->head = gsStack_length(token_names) - 1;
     first_production->body_length = 1;
-    GS_APPEND(&body, gsStack_length(&token_names) - 2, unsigned);
-    first_production->body = gsStack_0(&body);
-    gsStack_create_(&body, sizeof(unsigned));
-    GS_APPEND(&production_names, str_create_copy(str_formal), char*);
+    GS_APPEND(body, gsStack_length(token_names) - 2, unsigned);
+    first_production->body = gsStack_0(body);
+    gsStack_create_(body, sizeof(unsigned));
+    GS_APPEND(production_names, str_create_copy(str_formal), char*);
+    GS_APPEND(&precedences->production_precedences, 0, unsigned);
+    GS_APPEND(list_roles, PR_LIST_ROLE_NONE, _prListRole);
+
+    gsStack trie;
+    _prNameTrie_create_(&trie);
+    for (unsigned i = 0; i < gsStack_length(token_names); ++i) {
+        _prNameTrie_insert_(&trie, ((char**) gsStack_0(token_names))[i], i);
+    }
+    _prBodyReader reader;
+    _prBodyReader_create_(&reader, &trie, token_names, precedences);
+    boolean is_read = false;
 
     /* read productions */
 
     const char* query_result;
+    const char* cursor_next;
     while (*cursor != 0) {
-        /* just since the str.h function uses size_t and I use unsigned... */
-        size_t temp;
+        unsigned token;
 
-        gsStack_pre_append_(&productions);
-        prProduction* production = gsStack_last(&productions);
+        gsStack_pre_append_(productions);
+        prProduction* production = gsStack_last(productions);
         production->body = NULL;
 
-        GS_APPEND(&production_names, NULL, char*);
+        GS_APPEND(production_names, NULL, char*);
 
         if (*cursor == '@') {
             ++cursor;
@@ -182,63 +1027,213 @@ static prGrammar* prGrammar_create_from_spec_given_terminal_names_(
             if (cursor_next == cursor) {
                 goto error_label;
             }
-            * (char**) gsStack_last(&production_names) =
+            * (char**) gsStack_last(production_names) =
                 str_create_copy_from_to(cursor, cursor_next);
             cursor = str_while_not_visible(cursor_next);
         }
 
-        query_result = str_starts_with_one_of(cursor,
-                                              gsStack_length(&token_names),
-                                              gsStack_0(&token_names),
-                                              &temp);
+        query_result = _prNameTrie_longest_match(&trie, cursor, &token);
         if (query_result == NULL) {
-	    if (out_diagnostic != NULL) {
-		char* what_was_not_found =
-		    str_create_copy_from_to(cursor, str_while_visible(cursor));
-		sprintf(out_diagnostic,
-			"Error parsing grammar file: did not find the "
-			"token %s encountered in a production.\n",
-			what_was_not_found);
-		FREE(what_was_not_found);
-	    }
-            goto error_label;
-        } else {
-            cursor = query_result;
+            goto not_found_label;
         }
-        production->head = temp;
+        cursor = query_result;
+        production->head = token;
         cursor = str_while_not_visible(cursor);
         cursor = str_starts_with(cursor, str_to);
         if (cursor == NULL) {
             goto error_label;
         }
         cursor = str_while_not_visible(cursor);
+        unsigned precedence = 0;
+        boolean is_precedence_given = false;
         while (*cursor != 0 && *cursor != '\n') {
-            gsStack_pre_append_(&body);
-            query_result = str_starts_with_one_of(cursor,
-                                                  gsStack_length(&token_names),
-                                                  gsStack_0(&token_names),
-                                                  &temp);
-            if (query_result == NULL) {
-                if (out_diagnostic != NULL) {
-		    char* what_was_not_found =
-			str_create_copy_from_to(cursor, str_while_visible(cursor));
-		    sprintf(out_diagnostic,
-			    "Error parsing grammar file: did not find the "
-			    "token %s encountered in a production.\n",
-			    what_was_not_found);
-		    FREE(what_was_not_found);
-		}
+            cursor_next = str_starts_with(cursor, str_prec);
+            if (cursor_next != NULL) {
+                cursor = str_while_not_visible_except_newline(cursor_next);
+                cursor_next = str_while_visible(cursor);
+                char* const name = str_create_copy_from_to(cursor, cursor_next);
+                precedence = _prSpecPrecedences_level(precedences, token_names,
+                                                      name);
+                if (precedence == 0) {
+                    if (out_diagnostic != NULL) {
+                        sprintf(out_diagnostic,
+                                "Error parsing grammar file: %s after @prec "
+                                "has no precedence.\n", name);
+                    }
+                    FREE(name);
+                    goto error_label;
+                }
+                FREE(name);
+                is_precedence_given = true;
+                cursor = str_while_not_visible_except_newline(cursor_next);
+                if (*cursor != 0 && *cursor != '\n') {
+                    goto error_label;
+                }
+                break;
+            }
+            cursor = _prBodyReader_read_symbol_(&reader, cursor, body,
+                                                out_diagnostic);
+            if (cursor == NULL) {
                 goto error_label;
-            } else {
-                cursor = query_result;
             }
-            * (unsigned*) gsStack_last(&body) = temp;
             cursor = str_while_not_visible_except_newline(cursor);
         }
+        if (is_precedence_given == false) {
+            precedence =
+                _pr_body_precedence(gsStack_0(body), gsStack_length(body),
+                                    terminal_precedences, num_of_terminals);
+        }
+        GS_APPEND(&precedences->production_precedences, precedence, unsigned);
+        GS_APPEND(list_roles, PR_LIST_ROLE_NONE, _prListRole);
         cursor = str_while_not_visible(cursor);
-        production->body_length = gsStack_length(&body);
-        production->body = gsStack_0(&body);
-        gsStack_create_(&body, sizeof(unsigned));
+        production->body_length = gsStack_length(body);
+        production->body = gsStack_0(body);
+        gsStack_create_(body, sizeof(unsigned));
+    }
+    is_read = true;
+    goto end_label;
+
+    not_found_label:;
+    if (out_diagnostic != NULL) {
+        char* what_was_not_found =
+            str_create_copy_from_to(cursor, str_while_visible(cursor));
+        sprintf(out_diagnostic,
+                "Error parsing grammar file: did not find the "
+                "token %s encountered in a production.\n",
+                what_was_not_found);
+        FREE(what_was_not_found);
+    }
+    error_label:;
+    end_label:;
+    /* the added productions go last, even on failure for their bodies to
+       be freed, and then the start and formal non-terminals are moved
+       after the added ones, as the last two tokens */
+    const unsigned num_of_added_productions =
+        gsStack_length(&reader.productions);
+    for (unsigned i = 0; i < num_of_added_productions; ++i) {
+        GS_APPEND(productions,
+                  ((prProduction*) gsStack_0(&reader.productions))[i],
+                  prProduction);
+    }
+    if (is_read == true) {
+        for (unsigned i = 0; i < num_of_added_productions; ++i) {
+            GS_APPEND(production_names, NULL, char*);
+            GS_APPEND(&precedences->production_precedences,
+                      ((unsigned*) gsStack_0(&reader.precedences))[i],
+                      unsigned);
+            GS_APPEND(list_roles,
+                      ((_prListRole*) gsStack_0(&reader.list_roles))[i],
+                      _prListRole);
+        }
+        const unsigned start = reader.first_added - 2;
+        const unsigned num_of_added_tokens =
+            gsStack_length(token_names) - reader.first_added;
+        if (num_of_added_tokens != 0) {
+            char** const names = gsStack_0(token_names);
+            char* const start_name = names[start];
+            char* const formal_name = names[start + 1];
+            memmove(names + start, names + start + 2,
+                    num_of_added_tokens * sizeof(char*));
+            names[start + num_of_added_tokens] = start_name;
+            names[start + num_of_added_tokens + 1] = formal_name;
+            prProduction* const production = gsStack_0(productions);
+            for (unsigned i = 0; i < gsStack_length(productions); ++i) {
+                production[i].head = _pr_moved_token(production[i].head,
+                                                     start,
+                                                     num_of_added_tokens);
+                for (unsigned j = 0; j < production[i].body_length; ++j) {
+                    production[i].body[j] =
+                        _pr_moved_token(production[i].body[j], start,
+                                        num_of_added_tokens);
+                }
+            }
+        }
+    }
+    _prBodyReader_destroy_(&reader);
+    gsStack_destroy_(&trie);
+    return is_read;
+}
+
+static prGrammar* prGrammar_create_from_spec_given_terminal_names_(
+    prGrammar* self,
+    const char* spec,
+    unsigned terminal_names_list_length,
+    const char* const* terminal_names_list,
+    char* out_diagnostic) {
+
+    const char str_nonterminals[] = "@@nonterminals";
+
+    self->num_of_productions = 0;
+    self->max_production_body_length = 0;
+    self->num_of_tokens = 0;
+    self->num_of_terminals = terminal_names_list_length;
+    self->token_names = NULL;
+    self->productions = NULL;
+    self->production_names = NULL;
+    self->num_of_synchronizing_tokens = 0;
+    self->synchronizing_tokens = NULL;
+    self->token_name_index.displacements = NULL;
+    self->token_name_index.slots = NULL;
+    self->production_name_index.displacements = NULL;
+    self->production_name_index.slots = NULL;
+    self->num_of_precedence_levels = 0;
+    self->associativities = NULL;
+    self->terminal_precedences = NULL;
+    self->production_precedences = NULL;
+    self->list_roles = NULL;
+    self->is_list = NULL;
+
+    gsStack token_names, production_names, productions, body;
+    gsStack synchronizing_tokens, list_roles;
+    _prSpecPrecedences precedences;
+    gsStack_create_(&synchronizing_tokens, sizeof(unsigned));
+    gsStack_create_(&list_roles, sizeof(_prListRole));
+    _prSpecPrecedences_create_(&precedences);
+    gsStack_create_(&token_names, sizeof(char*));
+    gsStack_create_(&production_names, sizeof(char*));
+    gsStack_create_(&productions, sizeof(prProduction));
+    gsStack_create_(&body, sizeof(unsigned));
+
+    /* read terminals names */
+
+    for (unsigned i = 0; i < self->num_of_terminals; ++i) {
+        GS_APPEND (&token_names, str_create_copy(terminal_names_list[i]),
+                   char*);
+    }
+
+    /* skip to non-terminals names */
+
+    const char* cursor = spec;
+    const char* cursor_next;
+    for(;;) {
+        cursor_next = str_starts_with(cursor, str_nonterminals);
+        if (cursor_next != NULL) {
+            break;
+        }
+        cursor_next = str_while_visible(cursor);
+        if (cursor_next == cursor) {
+            goto error_label;
+        }
+        cursor = str_while_not_visible(cursor_next);
+    }
+    self->num_of_terminals = gsStack_length(&token_names);
+    cursor = str_while_not_visible(cursor_next);
+
+    /* read non-terminals names, and the synchronizing tokens
+       and precedences if any */
+
+    cursor = _prGrammar_read_nonterminals(cursor, &token_names,
+                                          self->num_of_terminals,
+                                          &synchronizing_tokens, &precedences,
+                                          out_diagnostic);
+    if (cursor == NULL) {
+        goto error_label;
+    }
+
+    if (_prGrammar_read_productions(cursor, &token_names, &productions,
+                                    &production_names, &body, &precedences,
+                                    &list_roles, out_diagnostic) == false) {
+        goto error_label;
     }
 
     /* finalize */
@@ -248,9 +1243,18 @@ static prGrammar* prGrammar_create_from_spec_given_terminal_names_(
     self->num_of_productions = gsStack_length(&productions);
     self->productions = gsStack_0(&productions);
     self->production_names = gsStack_0(&production_names);
+    self->num_of_synchronizing_tokens = gsStack_length(&synchronizing_tokens);
+    self->synchronizing_tokens = gsStack_0(&synchronizing_tokens);
+    _prSpecPrecedences_finalize_(&precedences, self);
+    self->list_roles = gsStack_0(&list_roles);
+    _prGrammar_index_names_(self);
+    _prGrammar_mark_lists_(self);
     return self;
 
     error_label:;
+    _prSpecPrecedences_destroy_(&precedences);
+    gsStack_destroy_(&synchronizing_tokens);
+    gsStack_destroy_(&list_roles);
     gsStack_destroy_(&body);
     unsigned length = gsStack_length(&productions);
     prProduction* production = gsStack_0(&productions);
@@ -298,9 +1302,6 @@ static prGrammar* prGrammar_create_from_spec_(prGrammar* self, const char* spec,
 					      char* out_diagnostic) {
     const char str_empty[] = "<empty>";
     const char str_nonterminals[] = "@@nonterminals";
-    const char str_productions[] = "@@productions";
-    const char str_formal[] = "<formal>";
-    const char str_to[] = "->";
 
     self->num_of_productions = 0;
     self->max_production_body_length = 0;
@@ -309,39 +1310,38 @@ static prGrammar* prGrammar_create_from_spec_(prGrammar* self, const char* spec,
     self->token_names = NULL;
     self->productions = NULL;
     self->production_names = NULL;
+    self->num_of_synchronizing_tokens = 0;
+    self->synchronizing_tokens = NULL;
+    self->token_name_index.displacements = NULL;
+    self->token_name_index.slots = NULL;
+    self->production_name_index.displacements = NULL;
+    self->production_name_index.slots = NULL;
+    self->num_of_precedence_levels = 0;
+    self->associativities = NULL;
+    self->terminal_precedences = NULL;
+    self->production_precedences = NULL;
+    self->list_roles = NULL;
+    self->is_list = NULL;
 
     gsStack token_names, production_names, productions, body;
+    gsStack synchronizing_tokens, list_roles;
+    _prSpecPrecedences precedences;
+    gsStack_create_(&synchronizing_tokens, sizeof(unsigned));
+    gsStack_create_(&list_roles, sizeof(_prListRole));
+    _prSpecPrecedences_create_(&precedences);
     gsStack_create_(&token_names, sizeof(char*));
     gsStack_create_(&production_names, sizeof(char*));
-    gsStack_create_(&productions, sizeof(prProduction));
-    gsStack_create_(&body, sizeof(unsigned));
-
-    GS_APPEND(&token_names, str_create_copy(str_empty), char*);
-
-    /* read terminals names */
-
-    const char* cursor = spec;
-    const char* cursor_next;
-    for (;;) {
-        cursor_next = str_starts_with(cursor, str_nonterminals);
-        if (cursor_next != NULL) {
-            break;
-        }
-        cursor_next = str_while_visible(cursor);
-        if (cursor_next == cursor) {
-            goto error_label;
-        }
-        GS_APPEND(&token_names, str_create_copy_from_to(cursor, cursor_next),
-                  char*);
-        cursor = str_while_not_visible(cursor_next);
-    }
-    self->num_of_terminals = gsStack_length(&token_names);
-    cursor = str_while_not_visible(cursor_next);
+    gsStack_create_(&productions, sizeof(prProduction));
+    gsStack_create_(&body, sizeof(unsigned));
 
-    /* read non-terminals names */
+    GS_APPEND(&token_names, str_create_copy(str_empty), char*);
 
-    for(;;) {
-        cursor_next = str_starts_with(cursor, str_productions);
+    /* read terminals names */
+
+    const char* cursor = spec;
+    const char* cursor_next;
+    for (;;) {
+        cursor_next = str_starts_with(cursor, str_nonterminals);
         if (cursor_next != NULL) {
             break;
         }
@@ -353,101 +1353,24 @@ static prGrammar* prGrammar_create_from_spec_(prGrammar* self, const char* spec,
                   char*);
         cursor = str_while_not_visible(cursor_next);
     }
+    self->num_of_terminals = gsStack_length(&token_names);
     cursor = str_while_not_visible(cursor_next);
 
-    /* add formal non-terminal */
-    GS_APPEND(&token_names, str_create_copy(str_formal), char*);
-
-    /* add formal production */
-    gsStack_pre_append_(&productions);
-    prProduction* const first_production = gsStack_last(&productions);
-    first_production->head = gsStack_length(&token_names) - 1;
-    first_production->body_length = 1;
-    GS_APPEND(&body, gsStack_length(&token_names) - 2, unsigned);
-    first_production->body = gsStack_0(&body);
-    gsStack_create_(&body, sizeof(unsigned));
-    GS_APPEND(&production_names, str_create_copy(str_formal), char*);
-
-    /* read productions */
-
-    const char* query_result;
-    while (*cursor != 0) {
-        /* just since the str.h function uses size_t and I use unsigned... */
-        size_t temp;
-
-        gsStack_pre_append_(&productions);
-        prProduction* production = gsStack_last(&productions);
-        production->body = NULL;
-
-        GS_APPEND(&production_names, NULL, char*);
+    /* read non-terminals names, and the synchronizing tokens
+       and precedences if any */
 
-        if (*cursor == '@') {
-            ++cursor;
-            if (*cursor == '@') {
-                goto error_label;
-            }
-            cursor = str_while_not_visible(cursor);
-            cursor_next = str_while_visible(cursor);
-            if (cursor_next == cursor) {
-                goto error_label;
-            }
-            * (char**) gsStack_last(&production_names) =
-                str_create_copy_from_to(cursor, cursor_next);
-            cursor = str_while_not_visible(cursor_next);
-        }
+    cursor = _prGrammar_read_nonterminals(cursor, &token_names,
+                                          self->num_of_terminals,
+                                          &synchronizing_tokens, &precedences,
+                                          out_diagnostic);
+    if (cursor == NULL) {
+        goto error_label;
+    }
 
-        query_result = str_starts_with_one_of(cursor,
-                                              gsStack_length(&token_names),
-                                              gsStack_0(&token_names),
-                                              &temp);
-        if (query_result == NULL) {
-            if (out_diagnostic != NULL) {
-		char* what_was_not_found =
-		    str_create_copy_from_to(cursor, str_while_visible(cursor));
-		sprintf(out_diagnostic,
-			"Error parsing grammar file: did not find the "
-			"token %s encountered in a production.\n",
-			what_was_not_found);
-		FREE(what_was_not_found);
-	    }
-            goto error_label;
-        } else {
-            cursor = query_result;
-        }
-        production->head = temp;
-        cursor = str_while_not_visible(cursor);
-        cursor = str_starts_with(cursor, str_to);
-        if (cursor == NULL) {
-            goto error_label;
-        }
-        cursor = str_while_not_visible(cursor);
-        while (*cursor != 0 && *cursor != '\n') {
-            gsStack_pre_append_(&body);
-            query_result = str_starts_with_one_of(cursor,
-                                                  gsStack_length(&token_names),
-                                                  gsStack_0(&token_names),
-                                                  &temp);
-            if (query_result == NULL) {
-                if (out_diagnostic != NULL) {
-		    char* what_was_not_found =
-			str_create_copy_from_to(cursor, str_while_visible(cursor));
-		    sprintf(out_diagnostic,
-			    "Error parsing grammar file: did not find the "
-			    "token %s encountered in a production.\n",
-			    what_was_not_found);
-		    FREE(what_was_not_found);
-		}
-                goto error_label;
-            } else {
-                cursor = query_result;
-            }
-            * (unsigned*) gsStack_last(&body) = temp;
-            cursor = str_while_not_visible_except_newline(cursor);
-        }
-        cursor = str_while_not_visible(cursor);
-        production->body_length = gsStack_length(&body);
-        production->body = gsStack_0(&body);
-        gsStack_create_(&body, sizeof(unsigned));
+    if (_prGrammar_read_productions(cursor, &token_names, &productions,
+                                    &production_names, &body, &precedences,
+                                    &list_roles, out_diagnostic) == false) {
+        goto error_label;
     }
 
     /* finalize */
@@ -457,9 +1380,18 @@ static prGrammar* prGrammar_create_from_spec_(prGrammar* self, const char* spec,
     self->num_of_productions = gsStack_length(&productions);
     self->productions = gsStack_0(&productions);
     self->production_names = gsStack_0(&production_names);
+    self->num_of_synchronizing_tokens = gsStack_length(&synchronizing_tokens);
+    self->synchronizing_tokens = gsStack_0(&synchronizing_tokens);
+    _prSpecPrecedences_finalize_(&precedences, self);
+    self->list_roles = gsStack_0(&list_roles);
+    _prGrammar_index_names_(self);
+    _prGrammar_mark_lists_(self);
     return self;
 
     error_label:;
+    _prSpecPrecedences_destroy_(&precedences);
+    gsStack_destroy_(&synchronizing_tokens);
+    gsStack_destroy_(&list_roles);
     gsStack_destroy_(&body);
     unsigned length = gsStack_length(&productions);
     prProduction* production = gsStack_0(&productions);
@@ -496,6 +1428,279 @@ prGrammar* prGrammar_create_from_spec(const char* spec, char* out_diagnostic) {
     return self;
 }
 
+/* the binary form of a grammar starts with these */
+#define PR_GRAMMAR_BINARY_MAGIC 0x52475250u
+#define PR_GRAMMAR_BINARY_VERSION 3
+
+/*
+  the binary form of a grammar is a sequence of unsigned:
+  magic, version, sizeof(unsigned), num_of_tokens, num_of_terminals,
+  num_of_productions, max_production_body_length,
+  num_of_synchronizing_tokens, the synchronizing tokens,
+  num_of_precedence_levels, the associativity of each level,
+  the precedence of each terminal,
+  then head, body_length, precedence, list role and body of each production,
+  then the length and characters (padded to whole unsigneds)
+  of each token name and production name (UINT_MAX for no name)
+*/
+
+typedef struct _prBinaryCursor {
+    /* NULL when only measuring */
+    unsigned char* write;
+    const unsigned char* read;
+    const unsigned char* read_end;
+    size_t size;
+} _prBinaryCursor;
+
+static void _prBinaryCursor_write_(_prBinaryCursor* self, unsigned word) {
+    if (self->write != NULL) {
+        memcpy(self->write + self->size, &word, sizeof(unsigned));
+    }
+    self->size += sizeof(unsigned);
+    return;
+}
+
+static void _prBinaryCursor_write_name_(_prBinaryCursor* self,
+                                        const char* name) {
+    if (name == NULL) {
+        _prBinaryCursor_write_(self, UINT_MAX);
+        return;
+    }
+    const unsigned length = strlen(name);
+    const size_t padded = (length + sizeof(unsigned) - 1)
+        / sizeof(unsigned) * sizeof(unsigned);
+    _prBinaryCursor_write_(self, length);
+    if (self->write != NULL) {
+        memcpy(self->write + self->size, name, length);
+        memset(self->write + self->size + length, 0, padded - length);
+    }
+    self->size += padded;
+    return;
+}
+
+/* returns false if the buffer ran out */
+static boolean _prBinaryCursor_read_(_prBinaryCursor* self, unsigned* word) {
+    if ((size_t) (self->read_end - self->read) < sizeof(unsigned)) {
+        return false;
+    }
+    memcpy(word, self->read, sizeof(unsigned));
+    self->read += sizeof(unsigned);
+    return true;
+}
+
+static boolean _prBinaryCursor_read_name_(_prBinaryCursor* self, char** name) {
+    unsigned length;
+    *name = NULL;
+    if (_prBinaryCursor_read_(self, &length) == false) {
+        return false;
+    }
+    if (length == UINT_MAX) {
+        return true;
+    }
+    const size_t padded = ((size_t) length + sizeof(unsigned) - 1)
+        / sizeof(unsigned) * sizeof(unsigned);
+    if ((size_t) (self->read_end - self->read) < padded) {
+        return false;
+    }
+    *name = str_create_copy_from_to((const char*) self->read,
+                                    (const char*) self->read + length);
+    self->read += padded;
+    return true;
+}
+
+size_t prGrammar_serialize(const prGrammar* self, void* buffer) {
+    _prBinaryCursor cursor;
+    cursor.write = buffer;
+    cursor.size = 0;
+    _prBinaryCursor_write_(&cursor, PR_GRAMMAR_BINARY_MAGIC);
+    _prBinaryCursor_write_(&cursor, PR_GRAMMAR_BINARY_VERSION);
+    _prBinaryCursor_write_(&cursor, sizeof(unsigned));
+    _prBinaryCursor_write_(&cursor, self->num_of_tokens);
+    _prBinaryCursor_write_(&cursor, self->num_of_terminals);
+    _prBinaryCursor_write_(&cursor, self->num_of_productions);
+    _prBinaryCursor_write_(&cursor, self->max_production_body_length);
+    _prBinaryCursor_write_(&cursor, self->num_of_synchronizing_tokens);
+    for (unsigned i = 0; i < self->num_of_synchronizing_tokens; ++i) {
+        _prBinaryCursor_write_(&cursor, self->synchronizing_tokens[i]);
+    }
+    _prBinaryCursor_write_(&cursor, self->num_of_precedence_levels);
+    for (unsigned i = 0; i < self->num_of_precedence_levels; ++i) {
+        _prBinaryCursor_write_(&cursor, self->associativities[i]);
+    }
+    for (unsigned i = 0; i < self->num_of_terminals; ++i) {
+        _prBinaryCursor_write_(&cursor, self->terminal_precedences[i]);
+    }
+    for (unsigned i = 0; i < self->num_of_productions; ++i) {
+        const prProduction* const production = prGrammar_production(self, i);
+        _prBinaryCursor_write_(&cursor, production->head);
+        _prBinaryCursor_write_(&cursor, production->body_length);
+        _prBinaryCursor_write_(&cursor, self->production_precedences[i]);
+        _prBinaryCursor_write_(&cursor, self->list_roles[i]);
+        for (unsigned j = 0; j < production->body_length; ++j) {
+            _prBinaryCursor_write_(&cursor, production->body[j]);
+        }
+    }
+    for (unsigned i = 0; i < self->num_of_tokens; ++i) {
+        _prBinaryCursor_write_name_(&cursor, self->token_names[i]);
+    }
+    for (unsigned i = 0; i < self->num_of_productions; ++i) {
+        _prBinaryCursor_write_name_(&cursor, self->production_names[i]);
+    }
+    return cursor.size;
+}
+
+static prGrammar* prGrammar_create_from_binary_(prGrammar* self,
+                                                const void* buffer,
+                                                size_t size,
+                                                char* out_diagnostic) {
+    _prBinaryCursor cursor;
+    cursor.read = buffer;
+    cursor.read_end = cursor.read + size;
+    unsigned header[8];
+    self->num_of_productions = 0;
+    self->num_of_tokens = 0;
+    self->token_names = NULL;
+    self->production_names = NULL;
+    self->productions = NULL;
+    self->num_of_synchronizing_tokens = 0;
+    self->synchronizing_tokens = NULL;
+    self->token_name_index.displacements = NULL;
+    self->token_name_index.slots = NULL;
+    self->production_name_index.displacements = NULL;
+    self->production_name_index.slots = NULL;
+    self->num_of_precedence_levels = 0;
+    self->associativities = NULL;
+    self->terminal_precedences = NULL;
+    self->production_precedences = NULL;
+    self->list_roles = NULL;
+    self->is_list = NULL;
+    for (unsigned i = 0; i < 8; ++i) {
+        if (_prBinaryCursor_read_(&cursor, header + i) == false) {
+            goto error_label;
+        }
+    }
+    if (header[0] != PR_GRAMMAR_BINARY_MAGIC
+        || header[1] != PR_GRAMMAR_BINARY_VERSION
+        || header[2] != sizeof(unsigned)
+        || header[4] > header[3]
+        /* no more entries than there are bytes, before allocating */
+        || header[3] > size || header[5] > size || header[7] > size) {
+        goto error_label;
+    }
+    self->num_of_terminals = header[4];
+    self->max_production_body_length = header[6];
+
+    self->synchronizing_tokens = MALLOC((header[7] + 1) * sizeof(unsigned));
+    for (; self->num_of_synchronizing_tokens < header[7];
+         ++self->num_of_synchronizing_tokens) {
+        unsigned* const token = self->synchronizing_tokens
+            + self->num_of_synchronizing_tokens;
+        if (_prBinaryCursor_read_(&cursor, token) == false
+            || *token >= self->num_of_terminals) {
+            goto error_label;
+        }
+    }
+    unsigned num_of_precedence_levels;
+    if (_prBinaryCursor_read_(&cursor, &num_of_precedence_levels) == false
+        || num_of_precedence_levels > size) {
+        goto error_label;
+    }
+    self->associativities =
+        MALLOC((num_of_precedence_levels + 1) * sizeof(_prAssociativity));
+    for (; self->num_of_precedence_levels < num_of_precedence_levels;
+         ++self->num_of_precedence_levels) {
+        unsigned associativity;
+        if (_prBinaryCursor_read_(&cursor, &associativity) == false
+            || associativity > PR_ASSOCIATIVITY_NONASSOC) {
+            goto error_label;
+        }
+        self->associativities[self->num_of_precedence_levels] = associativity;
+    }
+    self->terminal_precedences =
+        MALLOC((self->num_of_terminals + 1) * sizeof(unsigned));
+    for (unsigned i = 0; i < self->num_of_terminals; ++i) {
+        if (_prBinaryCursor_read_(&cursor, self->terminal_precedences + i)
+            == false
+            || self->terminal_precedences[i] > num_of_precedence_levels) {
+            goto error_label;
+        }
+    }
+    self->productions = CALLOC(header[5] + 1, sizeof(prProduction));
+    self->production_names = CALLOC(header[5] + 1, sizeof(char*));
+    self->production_precedences = CALLOC(header[5] + 1, sizeof(unsigned));
+    self->list_roles = CALLOC(header[5] + 1, sizeof(_prListRole));
+    for (; self->num_of_productions < header[5]; ++self->num_of_productions) {
+        prProduction* const production =
+            self->productions + self->num_of_productions;
+        unsigned list_role;
+        if (_prBinaryCursor_read_(&cursor, &production->head) == false
+            || _prBinaryCursor_read_(&cursor, &production->body_length) == false
+            || _prBinaryCursor_read_(&cursor, self->production_precedences
+                                     + self->num_of_productions) == false
+            || self->production_precedences[self->num_of_productions]
+            > num_of_precedence_levels
+            || _prBinaryCursor_read_(&cursor, &list_role) == false
+            || list_role > PR_LIST_ROLE_APPEND
+            || production->head < self->num_of_terminals
+            || production->head >= header[3]
+            || production->body_length > size) {
+            goto error_label;
+        }
+        self->list_roles[self->num_of_productions] = list_role;
+        production->body = MALLOC((production->body_length + 1)
+                                  * sizeof(unsigned));
+        for (unsigned j = 0; j < production->body_length; ++j) {
+            if (_prBinaryCursor_read_(&cursor, production->body + j) == false
+                || production->body[j] >= header[3]) {
+                ++self->num_of_productions;
+                goto error_label;
+            }
+        }
+    }
+    self->token_names = CALLOC(header[3] + 1, sizeof(char*));
+    for (; self->num_of_tokens < header[3]; ++self->num_of_tokens) {
+        if (_prBinaryCursor_read_name_(&cursor,
+                                       self->token_names
+                                       + self->num_of_tokens) == false
+            || self->token_names[self->num_of_tokens] == NULL) {
+            ++self->num_of_tokens;
+            goto error_label;
+        }
+    }
+    for (unsigned i = 0; i < self->num_of_productions; ++i) {
+        if (_prBinaryCursor_read_name_(&cursor,
+                                       self->production_names + i) == false) {
+            goto error_label;
+        }
+    }
+    _prGrammar_index_names_(self);
+    _prGrammar_mark_lists_(self);
+    return self;
+
+    error_label:;
+    if (out_diagnostic != NULL) {
+        sprintf(out_diagnostic,
+                "Error reading grammar: the buffer does not hold a grammar "
+                "in the binary form of version %u for this platform.\n",
+                PR_GRAMMAR_BINARY_VERSION);
+    }
+    /* the names and bodies read so far are freed along with the rest */
+    prGrammar_destroy_(self);
+    return NULL;
+}
+
+prGrammar* prGrammar_create_from_binary(const void* buffer, size_t size,
+                                        char* out_diagnostic) {
+    prGrammar* self = MALLOC(sizeof(prGrammar));
+    prGrammar* result = prGrammar_create_from_binary_(self, buffer, size,
+                                                      out_diagnostic);
+    if (result == NULL) {
+        FREE(self);
+        return NULL;
+    }
+    return self;
+}
+
 void prSLRParser_destroy_(prSLRParser* self) {
     faDfaBt_destroy_((faDfaBt*) self);
 }
@@ -504,39 +1709,164 @@ void prSLRParser_destroy(prSLRParser* self) {
     faDfaBt_destroy((faDfaBt*) self);
 }
 
+/* the productions with head token are
+   productions[offsets[token]], ..., productions[offsets[token+1]-1],
+   in increasing order */
+typedef struct _prHeadIndex {
+    unsigned* offsets;
+    unsigned* productions;
+} _prHeadIndex;
+
+static void _prHeadIndex_destroy_(_prHeadIndex* self) {
+    if (self == NULL) {
+        return;
+    }
+    FREE(self->offsets);
+    FREE(self->productions);
+    return;
+}
+
+static void _prHeadIndex_create_(_prHeadIndex* self, const prGrammar* grammar) {
+    self->offsets = CALLOC(grammar->num_of_tokens + 1, sizeof(*self->offsets));
+    self->productions =
+        MALLOC(grammar->num_of_productions * sizeof(*self->productions));
+    for (unsigned i = 0; i < grammar->num_of_productions; ++i) {
+        ++self->offsets[prGrammar_production(grammar, i)->head + 1];
+    }
+    for (unsigned token = 0; token < grammar->num_of_tokens; ++token) {
+        self->offsets[token+1] += self->offsets[token];
+    }
+    for (unsigned i = 0; i < grammar->num_of_productions; ++i) {
+        const unsigned head = prGrammar_production(grammar, i)->head;
+        self->productions[self->offsets[head]++] = i;
+    }
+    /* the offsets were moved to the ends, move them back */
+    for (unsigned token = grammar->num_of_tokens; token > 0; --token) {
+        self->offsets[token] = self->offsets[token-1];
+    }
+    self->offsets[0] = 0;
+    return;
+}
+
+/* the item nfa: the state start_states[i] + j is the item of
+   production i with position j, and its epsilon edges lead to
+   the start states of the productions of the token at position j */
 static faNfa* _prGrammar_construct_nfa(const prGrammar* self) {
+    unsigned* const start_states =
+        MALLOC(self->num_of_productions * sizeof(*start_states));
     unsigned length = 0;
     for (unsigned i = 0; i < self->num_of_productions; ++i) {
         const prProduction* const production = prGrammar_production(self, i);
+        start_states[i] = length;
         length += production->body_length + 1;
     }
+    _prHeadIndex head_index;
+    _prHeadIndex_create_(&head_index, self);
     faNfa* nfa = faNfa_create(length, 0, 1);
-    unsigned production_start_state = 0;
     for (unsigned i = 0; i < self->num_of_productions; ++i) {
         const prProduction* const production = prGrammar_production(self, i);
         for (unsigned j = 0; j < production->body_length; ++j) {
             const unsigned token = production->body[j];
-            const unsigned source = production_start_state + j;
+            const unsigned source = start_states[i] + j;
             faNfa_add_edge_(nfa, source, source+1, token);
-            unsigned production1_start_state = 0;
-            for (unsigned k = 0; k < self->num_of_productions; ++k) {
-                const prProduction* const production1 =
-                    prGrammar_production(self, k);
-                if (production1->head == token) {
-                    const unsigned target = production1_start_state;
-                    faNfa_add_edge_(nfa, source, target, 0);
-                }
-                production1_start_state += production1->body_length + 1;
+            for (unsigned k = head_index.offsets[token];
+                 k < head_index.offsets[token+1]; ++k) {
+                const unsigned target = start_states[head_index.productions[k]];
+                faNfa_add_edge_(nfa, source, target, 0);
             }
         }
-        production_start_state += production->body_length + 1;
     }
+    _prHeadIndex_destroy_(&head_index);
+    FREE(start_states);
     return nfa;
 }
 
+/*
+  the digraph algorithm of DeRemer and Pennello:
+  given a relation on [0, num_of_nodes), as the pairs (x, y) with x related
+  to y listed consecutively in relation, replaces each sets[x] by the union
+  of the sets[y] over all y reachable from x (x itself included),
+  treating each strongly connected component once
+*/
+typedef struct _prDigraphAux {
+    /* the nodes related to x are
+       targets[offsets[x]], ..., targets[offsets[x+1]-1] */
+    unsigned* offsets;
+    unsigned* targets;
+    ssSubset* sets;
+    /* 0 if not yet visited, UINT_MAX if done */
+    unsigned* depths;
+    gsStack stack;
+} _prDigraphAux;
+
+static void _pr_digraph_traverse(_prDigraphAux* aux, unsigned x) {
+    GS_APPEND(&aux->stack, x, unsigned);
+    const unsigned depth = gsStack_length(&aux->stack);
+    aux->depths[x] = depth;
+    for (unsigned i = aux->offsets[x]; i < aux->offsets[x+1]; ++i) {
+        const unsigned y = aux->targets[i];
+        if (aux->depths[y] == 0) {
+            _pr_digraph_traverse(aux, y);
+        }
+        if (aux->depths[y] < aux->depths[x]) {
+            aux->depths[x] = aux->depths[y];
+        }
+        ssSubset_add_subset_(aux->sets + x, aux->sets + y);
+    }
+    if (aux->depths[x] == depth) {
+        for (;;) {
+            unsigned top;
+            GS_POP(&aux->stack, top, unsigned);
+            aux->depths[top] = UINT_MAX;
+            if (top == x) {
+                break;
+            }
+            ssSubset_make_empty_(aux->sets + top);
+            ssSubset_add_subset_(aux->sets + top, aux->sets + x);
+        }
+    }
+    return;
+}
+
+static void _pr_digraph(unsigned num_of_nodes, const gsStack* relation,
+                        ssSubset* sets) {
+    const unsigned* const pairs = gsStack_0(relation);
+    const unsigned num_of_pairs = gsStack_length(relation) / 2;
+    _prDigraphAux aux;
+    aux.offsets = CALLOC(num_of_nodes + 1, sizeof(*aux.offsets));
+    aux.targets = MALLOC((num_of_pairs + 1) * sizeof(*aux.targets));
+    aux.sets = sets;
+    aux.depths = CALLOC(num_of_nodes + 1, sizeof(*aux.depths));
+    gsStack_create_(&aux.stack, sizeof(unsigned));
+    /* sort the pairs by x, using depths as counters */
+    for (unsigned i = 0; i < num_of_pairs; ++i) {
+        ++aux.offsets[pairs[2*i] + 1];
+    }
+    for (unsigned x = 0; x < num_of_nodes; ++x) {
+        aux.offsets[x+1] += aux.offsets[x];
+    }
+    for (unsigned i = 0; i < num_of_pairs; ++i) {
+        const unsigned x = pairs[2*i];
+        aux.targets[aux.offsets[x] + aux.depths[x]++] = pairs[2*i + 1];
+    }
+    memset(aux.depths, 0, (num_of_nodes + 1) * sizeof(*aux.depths));
+    for (unsigned x = 0; x < num_of_nodes; ++x) {
+        if (aux.depths[x] == 0) {
+            _pr_digraph_traverse(&aux, x);
+        }
+    }
+    gsStack_destroy_(&aux.stack);
+    FREE(aux.depths);
+    FREE(aux.targets);
+    FREE(aux.offsets);
+    return;
+}
+
 typedef struct _prSLRHelper {
     unsigned num_of_tokens;
     ssSubset appearing_tokens;
+    boolean* nullable;
+    /* first[token] contains 0 if token is nullable */
     ssSubset* first;
     ssSubset* follow;
     unsigned* state_to_production;
@@ -554,6 +1884,7 @@ static void _prSLRHelper_destroy_(_prSLRHelper* self) {
         ssSubset_destroy_(self->first+i);
         ssSubset_destroy_(self->follow+i);
     }
+    FREE(self->nullable);
     FREE(self->first);
     FREE(self->follow);
     FREE(self->state_to_production);
@@ -562,35 +1893,95 @@ static void _prSLRHelper_destroy_(_prSLRHelper* self) {
 }
 
 static void _prSLRHelper_fill_(_prSLRHelper* self, const prGrammar* grammar) {
-    boolean got_something_new;
-    boolean query_result;
-
     /* just so that we know how much to destruct... */
     self->num_of_tokens = grammar->num_of_tokens;
 
-    /* compute necessary */
+    _prHeadIndex head_index;
+    _prHeadIndex_create_(&head_index, grammar);
+    gsStack worklist;
+    gsStack_create_(&worklist, sizeof(unsigned));
+
+    /* compute the tokens appearing in derivations of the start token */
     ssSubset_create_(&self->appearing_tokens, grammar->num_of_tokens);
     ssSubset_add_(&self->appearing_tokens, grammar->num_of_tokens - 2);
-    do {
-        got_something_new = false;
-        for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
+    GS_APPEND(&worklist, grammar->num_of_tokens - 2, unsigned);
+    while (gsStack_is_nonempty(&worklist) == true) {
+        unsigned token;
+        GS_POP(&worklist, token, unsigned);
+        for (unsigned k = head_index.offsets[token];
+             k < head_index.offsets[token+1]; ++k) {
             const prProduction* const production =
-                prGrammar_production(grammar, j);
-            query_result = ssSubset_is_in(&self->appearing_tokens,
-                                          production->head);
-            if (query_result == true) {
-                for (unsigned i = 0; i < production->body_length; ++i) {
-                    query_result = ssSubset_add_(&self->appearing_tokens,
-                                                 production->body[i]);
-                    if (query_result == false) {
-                        got_something_new = true;
-                    }
+                prGrammar_production(grammar, head_index.productions[k]);
+            for (unsigned i = 0; i < production->body_length; ++i) {
+                if (ssSubset_add_(&self->appearing_tokens, production->body[i])
+                    == false) {
+                    GS_APPEND(&worklist, production->body[i], unsigned);
                 }
             }
         }
-    } while (got_something_new == true);
+    }
 
-    /* compute first */
+    /* compute the nullable tokens: a production's head is nullable once
+       the number of non-nullable tokens in its body drops to 0 */
+    self->nullable = CALLOC(grammar->num_of_tokens, sizeof(*self->nullable));
+    unsigned* const num_of_non_nullable =
+        MALLOC((grammar->num_of_productions + 1) * sizeof(*num_of_non_nullable));
+    /* the occurrences of token in bodies are in the productions
+       occurrences[occurrence_offsets[token]], ...,
+       occurrences[occurrence_offsets[token+1]-1] */
+    unsigned* const occurrence_offsets =
+        CALLOC(grammar->num_of_tokens + 1, sizeof(*occurrence_offsets));
+    for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
+        const prProduction* const production = prGrammar_production(grammar, j);
+        num_of_non_nullable[j] = production->body_length;
+        for (unsigned i = 0; i < production->body_length; ++i) {
+            ++occurrence_offsets[production->body[i] + 1];
+        }
+        if (production->body_length == 0
+            && self->nullable[production->head] == false) {
+            self->nullable[production->head] = true;
+            GS_APPEND(&worklist, production->head, unsigned);
+        }
+    }
+    for (unsigned token = 0; token < grammar->num_of_tokens; ++token) {
+        occurrence_offsets[token+1] += occurrence_offsets[token];
+    }
+    unsigned* const occurrences =
+        MALLOC((occurrence_offsets[grammar->num_of_tokens] + 1)
+               * sizeof(*occurrences));
+    unsigned* const occurrence_counts =
+        CALLOC(grammar->num_of_tokens, sizeof(*occurrence_counts));
+    for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
+        const prProduction* const production = prGrammar_production(grammar, j);
+        for (unsigned i = 0; i < production->body_length; ++i) {
+            const unsigned token = production->body[i];
+            occurrences[occurrence_offsets[token]
+                        + occurrence_counts[token]++] = j;
+        }
+    }
+    FREE(occurrence_counts);
+    while (gsStack_is_nonempty(&worklist) == true) {
+        unsigned token;
+        GS_POP(&worklist, token, unsigned);
+        for (unsigned k = occurrence_offsets[token];
+             k < occurrence_offsets[token+1]; ++k) {
+            const unsigned j = occurrences[k];
+            --num_of_non_nullable[j];
+            const unsigned head = prGrammar_production(grammar, j)->head;
+            if (num_of_non_nullable[j] == 0 && self->nullable[head] == false) {
+                self->nullable[head] = true;
+                GS_APPEND(&worklist, head, unsigned);
+            }
+        }
+    }
+    FREE(occurrences);
+    FREE(occurrence_offsets);
+    FREE(num_of_non_nullable);
+
+    /* compute first: FIRST(A) contains FIRST(X) for A -> x X y
+       with x nullable */
+    gsStack relation;
+    gsStack_create_(&relation, sizeof(unsigned));
     self->first = MALLOC(grammar->num_of_tokens * sizeof(*self->first));
     for (unsigned i = 0; i < grammar->num_of_tokens; ++i) {
         ssSubset_create_(self->first + i, grammar->num_of_terminals);
@@ -598,199 +1989,465 @@ static void _prSLRHelper_fill_(_prSLRHelper* self, const prGrammar* grammar) {
     for (unsigned i = 0; i < grammar->num_of_terminals; ++i) {
         ssSubset_add_(self->first + i, i);
     }
-    do {
-        got_something_new = false;
-        for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
-            const prProduction* const production =
-                prGrammar_production(grammar, j);
-            ssSubset* const head_subset = self->first + production->head;
-            boolean all_can_derive_empty = true;
-            for (unsigned i = 0; i < production->body_length; ++i) {
-                const ssSubset* const subset =
-                    self->first + production->body[i];
-                const unsigned length = ssSubset_length(subset);
+    for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
+        const prProduction* const production = prGrammar_production(grammar, j);
+        for (unsigned i = 0; i < production->body_length; ++i) {
+            GS_APPEND(&relation, production->head, unsigned);
+            GS_APPEND(&relation, production->body[i], unsigned);
+            if (self->nullable[production->body[i]] == false) {
+                break;
+            }
+        }
+    }
+    _pr_digraph(grammar->num_of_tokens, &relation, self->first);
+    gsStack_make_empty_(&relation);
+    for (unsigned i = grammar->num_of_terminals; i < grammar->num_of_tokens; ++i) {
+        if (self->nullable[i] == true) {
+            ssSubset_add_(self->first + i, 0);
+        }
+    }
+
+    /* compute follow: for A -> x X y, FOLLOW(X) contains FIRST(y)
+       (without 0), and also FOLLOW(A) if y is nullable */
+    self->follow = MALLOC(grammar->num_of_tokens * sizeof(*self->follow));
+    for (unsigned i = 0; i < grammar->num_of_tokens; ++i) {
+        ssSubset_create_(self->follow + i, grammar->num_of_terminals);
+    }
+    ssSubset_add_(self->follow + (grammar->num_of_tokens - 2), 0);
+    for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
+        const prProduction* const production =
+            prGrammar_production(grammar, j);
+        if (ssSubset_is_in(&self->appearing_tokens, production->head)
+            == false) {
+            continue;
+        }
+        boolean all_following_are_nullable = true;
+        for (unsigned ii = 0; ii < production->body_length; ++ii) {
+            const unsigned i = production->body_length - 1 - ii;
+            ssSubset* const subset = self->follow + production->body[i];
+            if (all_following_are_nullable == true) {
+                GS_APPEND(&relation, production->body[i], unsigned);
+                GS_APPEND(&relation, production->head, unsigned);
+            }
+            for (unsigned l = i+1; l < production->body_length; ++l) {
+                const ssSubset* const next_first_subset =
+                    self->first + production->body[l];
+                const unsigned length = ssSubset_length(next_first_subset);
                 for (unsigned k = 0; k < length; ++k) {
-                    const unsigned element = ssSubset_element(subset, k);
-                    if (ssSubset_add_(head_subset, element) == false) {
-                        got_something_new = true;
+                    const unsigned element =
+                        ssSubset_element(next_first_subset, k);
+                    if (element != 0) {
+                        ssSubset_add_(subset, element);
                     }
                 }
-                if (ssSubset_is_in(subset, 0) == false) {
-                    all_can_derive_empty = false;
+                if (self->nullable[production->body[l]] == false) {
                     break;
                 }
             }
-            if (all_can_derive_empty == true) {
-                if (ssSubset_add_(head_subset, 0) == false) {
-                    got_something_new = true;
-                }
+            if (self->nullable[production->body[i]] == false) {
+                all_following_are_nullable = false;
             }
         }
-    } while (got_something_new == true);
+    }
+    _pr_digraph(grammar->num_of_tokens, &relation, self->follow);
+    gsStack_destroy_(&relation);
+    gsStack_destroy_(&worklist);
+    _prHeadIndex_destroy_(&head_index);
 
-    /* compute follow */
-    self->follow = MALLOC(grammar->num_of_tokens * sizeof(*self->follow));
-    for (unsigned i = 0; i < grammar->num_of_tokens; ++i) {
-        ssSubset_create_(self->follow + i, grammar->num_of_terminals);
+    /* compute state_to_production and state_to_production_position*/
+    gsStack state_to_production, state_to_production_position;
+    gsStack_create_(&state_to_production, sizeof(unsigned));
+    gsStack_create_(&state_to_production_position, sizeof(unsigned));
+    for (unsigned i = 0; i < grammar->num_of_productions; ++i) {
+        const prProduction* const production = prGrammar_production(grammar, i);
+        for (unsigned j = 0; j < production->body_length + 1; ++j) {
+            GS_APPEND(&state_to_production, i, unsigned);
+            GS_APPEND(&state_to_production_position, j, unsigned);
+        }
     }
-    ssSubset_add_(self->follow + (grammar->num_of_tokens - 2), 0);
-    do {
-        got_something_new = false;
-        for (unsigned j = 0; j < grammar->num_of_productions; ++j) {
-            const prProduction* const production =
-                prGrammar_production(grammar, j);
-            query_result = ssSubset_is_in(&self->appearing_tokens,
-                                          production->head);
-            if (query_result == false) {
+    self->state_to_production = gsStack_0(&state_to_production);
+    self->state_to_production_position =
+        gsStack_0(&state_to_production_position);
+
+    return;
+}
+
+/* the terminals on which the completed production should be reduced
+   in the state (a state of the LR(0) automaton) */
+typedef const ssSubset* (*_prLookaheadFn)(const void* aux, unsigned state,
+                                          unsigned production);
+
+typedef struct _prSLRLookaheadAux {
+    const prGrammar* grammar;
+    const _prSLRHelper* slr_helper;
+} _prSLRLookaheadAux;
+
+static const ssSubset* _pr_slr_lookahead(const void* aux, unsigned state,
+                                         unsigned production) {
+    const _prSLRLookaheadAux* const slr_aux = aux;
+    (void) state;
+    return slr_aux->slr_helper->follow
+        + prGrammar_production(slr_aux->grammar, production)->head;
+}
+
+/* the LALR(1) lookaheads, computed from the LR(0) automaton
+   as described by DeRemer and Pennello */
+typedef struct _prLALRHelper {
+    /* the completed productions (having lookaheads) in state i are
+       lookahead_productions[lookahead_offsets[i]], ...,
+       lookahead_productions[lookahead_offsets[i+1]-1],
+       with the lookaheads at the same positions of lookaheads */
+    unsigned num_of_states;
+    unsigned* lookahead_offsets;
+    unsigned* lookahead_productions;
+    ssSubset* lookaheads;
+    /* the lookaheads of the productions completed in no state */
+    ssSubset empty;
+} _prLALRHelper;
+
+static void _prLALRHelper_destroy_(_prLALRHelper* self) {
+    if (self == NULL) {
+        return;
+    }
+    const unsigned num_of_lookaheads =
+        self->lookahead_offsets[self->num_of_states];
+    for (unsigned i = 0; i < num_of_lookaheads; ++i) {
+        ssSubset_destroy_(self->lookaheads + i);
+    }
+    FREE(self->lookaheads);
+    FREE(self->lookahead_productions);
+    FREE(self->lookahead_offsets);
+    ssSubset_destroy_(&self->empty);
+    return;
+}
+
+static void _prLALRHelper_fill_(_prLALRHelper* self, const prGrammar* grammar,
+                                const faDfa* dfa, const boolean* nullable) {
+    const unsigned num_of_terminals = grammar->num_of_terminals;
+    const unsigned num_of_nonterminals =
+        grammar->num_of_tokens - grammar->num_of_terminals;
+
+    self->num_of_states = dfa->num_of_states;
+    ssSubset_create_(&self->empty, num_of_terminals);
+
+    /* number the transitions on nonterminals;
+       transition_ids[state * num_of_nonterminals + token - num_of_terminals]
+       is the number of the transition plus 1, or 0 if there is none */
+    unsigned* const transition_ids =
+        CALLOC(dfa->num_of_states * num_of_nonterminals,
+               sizeof(*transition_ids));
+    gsStack transition_states, transition_tokens;
+    gsStack_create_(&transition_states, sizeof(unsigned));
+    gsStack_create_(&transition_tokens, sizeof(unsigned));
+    for (unsigned p = 0; p < dfa->num_of_states; ++p) {
+        if (p == dfa->reject) {
+            continue;
+        }
+        for (unsigned a = num_of_terminals; a < grammar->num_of_tokens; ++a) {
+            if (faDfa_goto(dfa, p, a) == dfa->reject) {
                 continue;
             }
-            if (production->body_length == 0) {
-                continue;
+            GS_APPEND(&transition_states, p, unsigned);
+            GS_APPEND(&transition_tokens, a, unsigned);
+            transition_ids[p * num_of_nonterminals + a - num_of_terminals] =
+                gsStack_length(&transition_states);
+        }
+    }
+    const unsigned num_of_transitions = gsStack_length(&transition_states);
+    const unsigned* const states = gsStack_0(&transition_states);
+    const unsigned* const tokens = gsStack_0(&transition_tokens);
+
+    /* the terminals directly read after the transitions;
+       reaching the sink means the input should end */
+    ssSubset* const follow = MALLOC((num_of_transitions + 1) * sizeof(*follow));
+    for (unsigned t = 0; t < num_of_transitions; ++t) {
+        ssSubset_create_(follow + t, num_of_terminals);
+        const unsigned r = faDfa_goto(dfa, states[t], tokens[t]);
+        for (unsigned a = 1; a < num_of_terminals; ++a) {
+            if (faDfa_goto(dfa, r, a) != dfa->reject) {
+                ssSubset_add_(follow + t, a);
+            }
+        }
+        if (dfa->sinks[r] == true) {
+            ssSubset_add_(follow + t, 0);
+        }
+    }
+
+    /* the reads relation: (p, A) reads (r, C) if r = goto(p, A)
+       and C is nullable */
+    gsStack relation;
+    gsStack_create_(&relation, sizeof(unsigned));
+    for (unsigned t = 0; t < num_of_transitions; ++t) {
+        const unsigned r = faDfa_goto(dfa, states[t], tokens[t]);
+        for (unsigned c = num_of_terminals; c < grammar->num_of_tokens; ++c) {
+            const unsigned id =
+                transition_ids[r * num_of_nonterminals + c - num_of_terminals];
+            if (nullable[c] == true && id != 0) {
+                GS_APPEND(&relation, t, unsigned);
+                GS_APPEND(&relation, id - 1, unsigned);
+            }
+        }
+    }
+    _pr_digraph(num_of_transitions, &relation, follow);
+    gsStack_make_empty_(&relation);
+
+    /* the includes relation: (p', A) includes (p, B) if B -> x A y,
+       y is nullable and x leads from p to p';
+       the lookback relation: (q, B -> x) lookbacks (p, B)
+       if x leads from p to q */
+    _prHeadIndex head_index;
+    _prHeadIndex_create_(&head_index, grammar);
+    gsStack path, lookbacks;
+    gsStack_create_(&path, sizeof(unsigned));
+    gsStack_create_(&lookbacks, sizeof(unsigned));
+    for (unsigned t = 0; t < num_of_transitions; ++t) {
+        for (unsigned k = head_index.offsets[tokens[t]];
+             k < head_index.offsets[tokens[t]+1]; ++k) {
+            const unsigned j = head_index.productions[k];
+            const prProduction* const production =
+                prGrammar_production(grammar, j);
+            gsStack_make_empty_(&path);
+            unsigned state = states[t];
+            GS_APPEND(&path, state, unsigned);
+            for (unsigned i = 0; i < production->body_length; ++i) {
+                state = faDfa_goto(dfa, state, production->body[i]);
+                GS_APPEND(&path, state, unsigned);
             }
-            boolean all_following_can_derive_empty = true;
+            const unsigned* const path_states = gsStack_0(&path);
             for (unsigned ii = 0; ii < production->body_length; ++ii) {
                 const unsigned i = production->body_length - 1 - ii;
-                ssSubset* const subset = self->follow + production->body[i];
-                if (all_following_can_derive_empty == true) {
-                    const ssSubset* const head_subset =
-                        self->follow + production->head;
-                    const unsigned length = ssSubset_length(head_subset);
-                    for (unsigned k = 0; k < length; ++k) {
-                        const unsigned element =
-                            ssSubset_element(head_subset, k);
-                        if (ssSubset_add_(subset, element) == false) {
-                            got_something_new = true;
-                        }
-                    }
-                }
-                for (unsigned l = i+1; l < production->body_length; ++l) {
-                    const ssSubset* const next_first_subset =
-                        self->first + production->body[l];
-                    const unsigned length = ssSubset_length(next_first_subset);
-                    for (unsigned k = 0; k < length; ++k) {
-                        const unsigned element =
-                            ssSubset_element(next_first_subset, k);
-                        if (element == 0) {
-                            continue;
-                        }
-                        if (ssSubset_add_(subset, element) == false) {
-                            got_something_new = true;
-                        }
-                    }
-                    query_result =
-                        ssSubset_is_in(self->first + production->body[l], 0);
-                    if (query_result == false) {
-                        break;
-                    }
+                const unsigned token = production->body[i];
+                if (token < num_of_terminals) {
+                    break;
                 }
-                query_result =
-                    ssSubset_is_in(self->first + production->body[i], 0);
-                if (query_result == false) {
-                    all_following_can_derive_empty = false;
+                const unsigned id =
+                    transition_ids[path_states[i] * num_of_nonterminals
+                                   + token - num_of_terminals];
+                GS_APPEND(&relation, id - 1, unsigned);
+                GS_APPEND(&relation, t, unsigned);
+                if (nullable[token] == false) {
+                    break;
                 }
             }
+            GS_APPEND(&lookbacks, state, unsigned);
+            GS_APPEND(&lookbacks, j, unsigned);
+            GS_APPEND(&lookbacks, t, unsigned);
         }
-    } while (got_something_new == true);
-
-    /* compute state_to_production and state_to_production_position*/
-    gsStack state_to_production, state_to_production_position;
-    gsStack_create_(&state_to_production, sizeof(unsigned));
-    gsStack_create_(&state_to_production_position, sizeof(unsigned));
-    for (unsigned i = 0; i < grammar->num_of_productions; ++i) {
-        const prProduction* const production = prGrammar_production(grammar, i);
-        for (unsigned j = 0; j < production->body_length + 1; ++j) {
-            GS_APPEND(&state_to_production, i, unsigned);
-            GS_APPEND(&state_to_production_position, j, unsigned);
+    }
+    _pr_digraph(num_of_transitions, &relation, follow);
+    _prHeadIndex_destroy_(&head_index);
+
+    /* the lookaheads, grouped by state */
+    const unsigned num_of_lookbacks = gsStack_length(&lookbacks) / 3;
+    const unsigned* const lookback_triples = gsStack_0(&lookbacks);
+    unsigned* const order = MALLOC((num_of_lookbacks + 1) * sizeof(*order));
+    unsigned* const counts =
+        CALLOC(dfa->num_of_states + 1, sizeof(*counts));
+    for (unsigned i = 0; i < num_of_lookbacks; ++i) {
+        ++counts[lookback_triples[3*i] + 1];
+    }
+    for (unsigned q = 0; q < dfa->num_of_states; ++q) {
+        counts[q+1] += counts[q];
+    }
+    for (unsigned i = 0; i < num_of_lookbacks; ++i) {
+        order[counts[lookback_triples[3*i]]++] = i;
+    }
+    self->lookahead_offsets =
+        MALLOC((dfa->num_of_states + 1) * sizeof(*self->lookahead_offsets));
+    self->lookahead_productions =
+        MALLOC((num_of_lookbacks + 1) * sizeof(*self->lookahead_productions));
+    self->lookaheads = MALLOC((num_of_lookbacks + 1) * sizeof(*self->lookaheads));
+    unsigned num_of_lookaheads = 0;
+    unsigned k = 0;
+    for (unsigned q = 0; q < dfa->num_of_states; ++q) {
+        self->lookahead_offsets[q] = num_of_lookaheads;
+        for (; k < num_of_lookbacks && lookback_triples[3*order[k]] == q; ++k) {
+            const unsigned production = lookback_triples[3*order[k] + 1];
+            const unsigned t = lookback_triples[3*order[k] + 2];
+            unsigned l = self->lookahead_offsets[q];
+            while (l < num_of_lookaheads
+                   && self->lookahead_productions[l] != production) {
+                ++l;
+            }
+            if (l == num_of_lookaheads) {
+                self->lookahead_productions[l] = production;
+                ssSubset_create_(self->lookaheads + l, num_of_terminals);
+                ++num_of_lookaheads;
+            }
+            ssSubset_add_subset_(self->lookaheads + l, follow + t);
         }
     }
-    self->state_to_production = gsStack_0(&state_to_production);
-    self->state_to_production_position =
-        gsStack_0(&state_to_production_position);
-
+    self->lookahead_offsets[dfa->num_of_states] = num_of_lookaheads;
+
+    FREE(counts);
+    FREE(order);
+    gsStack_destroy_(&lookbacks);
+    gsStack_destroy_(&path);
+    gsStack_destroy_(&relation);
+    for (unsigned t = 0; t < num_of_transitions; ++t) {
+        ssSubset_destroy_(follow + t);
+    }
+    FREE(follow);
+    gsStack_destroy_(&transition_tokens);
+    gsStack_destroy_(&transition_states);
+    FREE(transition_ids);
     return;
 }
 
-prSLRParser* prSLRParser_create_from_grammar(const prGrammar* grammar,
-					     char* out_diagnostic) {
-    faDfaBt* self = MALLOC(sizeof(*self));
-
-    _prSLRHelper slr_helper;
-    _prSLRHelper_fill_(&slr_helper, grammar);
-
-    faNfa* const nfa = _prGrammar_construct_nfa(grammar);
-    if (nfa == NULL) {
-        _prSLRHelper_destroy_(&slr_helper);
-        FREE(self);
-        return NULL;
+static const ssSubset* _pr_lalr_lookahead(const void* aux, unsigned state,
+                                          unsigned production) {
+    const _prLALRHelper* const lalr_helper = aux;
+    for (unsigned i = lalr_helper->lookahead_offsets[state];
+         i < lalr_helper->lookahead_offsets[state+1]; ++i) {
+        if (lalr_helper->lookahead_productions[i] == production) {
+            return lalr_helper->lookaheads + i;
+        }
     }
+    return &lalr_helper->empty;
+}
 
-    gsStack subsets;
-    faDfa_create_nfaec_with_subsets_(&self->dfa, &subsets, nfa,
-                                     unsignedMaybe_from_unsigned(grammar->num_of_tokens));
-    faNfa_destroy(nfa);
+typedef enum _prResolution {
+    PR_RESOLUTION_NONE,
+    PR_RESOLUTION_SHIFT,
+    PR_RESOLUTION_REDUCE,
+    /* neither, for a non-associative level */
+    PR_RESOLUTION_ERROR
+} _prResolution;
+
+/* resolves a conflict between shifting terminal and reducing by
+   production by their precedences, if they both have one */
+static _prResolution _prGrammar_resolve(const prGrammar* self,
+                                        unsigned production,
+                                        unsigned terminal) {
+    const unsigned production_precedence =
+        self->production_precedences[production];
+    const unsigned terminal_precedence = self->terminal_precedences[terminal];
+    if (production_precedence == 0 || terminal_precedence == 0) {
+        return PR_RESOLUTION_NONE;
+    }
+    if (production_precedence > terminal_precedence) {
+        return PR_RESOLUTION_REDUCE;
+    }
+    if (production_precedence < terminal_precedence) {
+        return PR_RESOLUTION_SHIFT;
+    }
+    switch (self->associativities[production_precedence-1]) {
+    case PR_ASSOCIATIVITY_LEFT:
+        return PR_RESOLUTION_REDUCE;
+    case PR_ASSOCIATIVITY_RIGHT:
+        return PR_RESOLUTION_SHIFT;
+    case PR_ASSOCIATIVITY_NONASSOC:
+        break;
+    }
+    return PR_RESOLUTION_ERROR;
+}
 
-    self->bt_list_length = 0;
-    self->bt_list = NULL;
-    self->bt_table = CALLOC(self->dfa.num_of_tokens * self->dfa.num_of_states,
-                            sizeof(*self->bt_table));
+static void _pr_add_conflict(gsStack* conflicts, unsigned state,
+                             unsigned lookahead, unsigned production,
+                             unsigned other_production) {
+    gsStack_pre_append_(conflicts);
+    prConflict* const conflict = gsStack_last(conflicts);
+    conflict->state = state;
+    conflict->lookahead = lookahead;
+    conflict->production = production;
+    conflict->other_production = other_production;
+    return;
+}
 
+/* fills the bt_table of self, whose dfa is the LR(0) automaton
+   with the given subsets, so that the completed productions are reduced
+   on their lookaheads; kind is the name of the method, for the diagnostic
+   (which describes the first conflict); the conflicts between shifting
+   and reducing which the precedences of the grammar resolve are not
+   conflicts, the shift being dropped from the transition table if it
+   loses; if conflicts is NULL, stops at
+   the first conflict, and otherwise goes on, appending every conflict
+   to it as a prConflict (the table then keeping the first action);
+   returns false on a conflict */
+static boolean _prSLRParser_fill_bt_table_(faDfaBt* self,
+                                           const prGrammar* grammar,
+                                           const gsStack* subsets,
+                                           const _prSLRHelper* slr_helper,
+                                           _prLookaheadFn lookahead_fn,
+                                           const void* lookahead_aux,
+                                           const char* kind,
+                                           gsStack* conflicts,
+                                           char* out_diagnostic) {
     boolean is_slr = true;
 
     ssSubset completed_productions;
     ssSubset terminals_next;
-    ssSubset_create_(&completed_productions, grammar->num_of_productions);
-    ssSubset_create_(&terminals_next, grammar->num_of_terminals);
+    gsStack lookaheads;
+    ssSubset_create_sparse_(&completed_productions, grammar->num_of_productions);
+    ssSubset_create_sparse_(&terminals_next, grammar->num_of_terminals);
+    gsStack_create_(&lookaheads, sizeof(const ssSubset*));
     for (unsigned i = 0; i < self->dfa.num_of_states; ++i) {
         ssSubset_make_empty_(&completed_productions);
         ssSubset_make_empty_(&terminals_next);
-        const ssSubset* const subset = gsStack_element(&subsets, i);
+        const ssSubset* const subset = gsStack_element(subsets, i);
         const unsigned subset_length = ssSubset_length(subset);
         for (unsigned j = 0; j < subset_length; ++j) {
             const unsigned item = ssSubset_element(subset, j);
-            const unsigned production_id = slr_helper.state_to_production[item];
+            const unsigned production_id = slr_helper->state_to_production[item];
             const prProduction* const production =
                 prGrammar_production(grammar, production_id);
             const unsigned position =
-                slr_helper.state_to_production_position[item];
+                slr_helper->state_to_production_position[item];
             if (position == production->body_length) {
                 ssSubset_add_(&completed_productions, production_id);
             } else if (production->body[position] < grammar->num_of_terminals) {
                 ssSubset_add_(&terminals_next, production->body[position]);
             }
         }
+        gsStack_make_empty_(&lookaheads);
+        const unsigned length = ssSubset_length(&completed_productions);
+        for (unsigned k = 0; k < length; ++k) {
+            GS_APPEND(&lookaheads,
+                      lookahead_fn(lookahead_aux, i,
+                                   ssSubset_element(&completed_productions, k)),
+                      const ssSubset*);
+        }
         for (unsigned j = 0; j < grammar->num_of_terminals; ++j) {
             const boolean is_in_terminals_next =
                 ssSubset_is_in(&terminals_next, j);
             if (self->dfa.sinks[i] == true && is_in_terminals_next == true) {
-                is_slr = false;
-		if (out_diagnostic != NULL) {
+		if (is_slr == true && out_diagnostic != NULL) {
 		    sprintf(out_diagnostic,
-			    "The given grammar is not SLR!\n"
+			    "The given grammar is not %s!\n"
 			    "Encountered problem with:\n"
 			    "  * terminal %s\n"
 			    "  * the state containing the sink "
 			    "completed production\n",
-			    grammar->token_names[j]);
+			    kind, grammar->token_names[j]);
 		}
-                goto exit_all_fors;
+                is_slr = false;
+                if (conflicts == NULL) {
+                    goto exit_all_fors;
+                }
+                /* the sink completed production is the formal one */
+                _pr_add_conflict(conflicts, i, j, 0, PR_CONFLICT_SHIFT);
+                continue;
             }
+            /* the first production reducible on j is weighed against
+               shifting j, and any other one conflicts with it, however
+               the shifting was resolved */
             boolean found_completed_production = false;
-            const unsigned length = ssSubset_length(&completed_productions);
+            unsigned first_production_id = 0;
             for (unsigned k = 0; k < length; ++k) {
                 const unsigned production_id =
                     ssSubset_element(&completed_productions, k);
                 const prProduction* const production =
                     prGrammar_production(grammar, production_id);
-                if (ssSubset_is_in(slr_helper.follow + production->head, j)
-                    == true) {
+                const ssSubset* const lookahead =
+                    * (const ssSubset**) gsStack_element(&lookaheads, k);
+                if (ssSubset_is_in(lookahead, j) == true) {
                     if (self->dfa.sinks[i] == true) {
-                        is_slr = false;
-			if (out_diagnostic != NULL) {
+			if (is_slr == true && out_diagnostic != NULL) {
 			    sprintf(out_diagnostic,
-				    "The given grammar is not SLR!\n"
+				    "The given grammar is not %s!\n"
 				    "Encountered problem with:"
 				    "\n  * completed production %s -> ",
-				    grammar->token_names[production->head]);
+				    kind, grammar->token_names[production->head]);
 			    out_diagnostic = str_goto_end(out_diagnostic);
 			    for (unsigned l = 0; l < production->body_length; ++l) {
 				sprintf(out_diagnostic,
@@ -804,18 +2461,29 @@ prSLRParser* prSLRParser_create_from_grammar(const prGrammar* grammar,
 				    "followed by terminal %s\n",
 				    grammar->token_names[j]);
 			}
-                        goto exit_all_fors;
-                    }
-                    if (found_completed_production == true ||
-                        is_in_terminals_next == true) {
                         is_slr = false;
-			if (out_diagnostic != NULL) {
+                        if (conflicts == NULL) {
+                            goto exit_all_fors;
+                        }
+                        _pr_add_conflict(conflicts, i, j, 0, production_id);
+                        continue;
+                    }
+                    const unsigned entry = i * self->dfa.num_of_tokens + j;
+                    _prResolution resolution = PR_RESOLUTION_REDUCE;
+                    if (found_completed_production == false
+                        && is_in_terminals_next == true) {
+                        resolution =
+                            _prGrammar_resolve(grammar, production_id, j);
+                    }
+                    if (found_completed_production == true
+                        || resolution == PR_RESOLUTION_NONE) {
+			if (is_slr == true && out_diagnostic != NULL) {
 			    sprintf(out_diagnostic,
-				    "The given grammar is not SLR!\n"
+				    "The given grammar is not %s!\n"
 				    "Encountered problem with:\n"
 				    "  * terminal %s\n"
 				    "  * completed production %s -> ",
-				    grammar->token_names[j],
+				    kind, grammar->token_names[j],
 				    grammar->token_names[production->head]);
 			    out_diagnostic = str_goto_end(out_diagnostic);
 			    for (unsigned l = 0; l < production->body_length; ++l) {
@@ -826,18 +2494,161 @@ prSLRParser* prSLRParser_create_from_grammar(const prGrammar* grammar,
 			    }
 			    sprintf(out_diagnostic, "\n");
 			}
-                        goto exit_all_fors;
+                        is_slr = false;
+                        if (conflicts == NULL) {
+                            goto exit_all_fors;
+                        }
+                        _pr_add_conflict(conflicts, i, j, production_id,
+                                         found_completed_production == true ?
+                                         first_production_id :
+                                         PR_CONFLICT_SHIFT);
+                        if (found_completed_production == true) {
+                            continue;
+                        }
+                    } else if (resolution != PR_RESOLUTION_SHIFT) {
+                        self->dfa.transition_table[entry] = self->dfa.reject;
+                        if (resolution == PR_RESOLUTION_REDUCE) {
+                            self->bt_table[entry] = production_id + 1;
+                        }
                     }
                     found_completed_production = true;
-                    self->bt_table[i * self->dfa.num_of_tokens + j] =
-                        production_id + 1;
+                    first_production_id = production_id;
                 }
             }
         }
     }
     exit_all_fors:;
+    gsStack_destroy_(&lookaheads);
     ssSubset_destroy_(&terminals_next);
     ssSubset_destroy_(&completed_productions);
+    return is_slr;
+}
+
+static double _pr_seconds_since(clock_t start) {
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* fills what report tells about the tables of self, built from subsets */
+static void _prSLRParserReport_fill_tables_(prSLRParserReport* self,
+                                            const faDfaBt* dfa_bt,
+                                            const prGrammar* grammar,
+                                            const gsStack* subsets) {
+    const unsigned num_of_states = dfa_bt->dfa.num_of_states;
+    const unsigned num_of_tokens = dfa_bt->dfa.num_of_tokens;
+    self->num_of_states = num_of_states;
+    self->num_of_items = MALLOC(num_of_states * sizeof(unsigned));
+    self->num_of_action_entries = num_of_states * grammar->num_of_terminals;
+    self->num_of_filled_action_entries = 0;
+    self->num_of_goto_entries =
+        num_of_states * (num_of_tokens - grammar->num_of_terminals);
+    self->num_of_filled_goto_entries = 0;
+    for (unsigned i = 0; i < num_of_states; ++i) {
+        self->num_of_items[i] =
+            ssSubset_length((const ssSubset*) gsStack_element(subsets, i));
+        for (unsigned j = 0; j < num_of_tokens; ++j) {
+            const unsigned entry = i * num_of_tokens + j;
+            const boolean is_filled =
+                dfa_bt->dfa.transition_table[entry] != dfa_bt->dfa.reject
+                || dfa_bt->bt_table[entry] != 0;
+            if (is_filled == true && j < grammar->num_of_terminals) {
+                ++self->num_of_filled_action_entries;
+            } else if (is_filled == true) {
+                ++self->num_of_filled_goto_entries;
+            }
+        }
+    }
+    self->sinks_size = num_of_states * sizeof(boolean);
+    self->transition_table_size =
+        (size_t) num_of_states * num_of_tokens * sizeof(unsigned);
+    self->bt_table_size = self->transition_table_size;
+    self->bt_list_size = grammar->num_of_productions * sizeof(faBtItem);
+    return;
+}
+
+static prSLRParser* _prSLRParser_create_from_grammar(const prGrammar* grammar,
+                                                     boolean is_lalr,
+                                                     prSLRParserReport* report,
+                                                     char* out_diagnostic) {
+    faDfaBt* self = MALLOC(sizeof(*self));
+    gsStack conflicts;
+    if (report != NULL) {
+        /* zeroed at once, so that a report is whole however early the
+           building fails */
+        memset(report, 0, sizeof(*report));
+        report->num_of_items = NULL;
+        report->conflicts = NULL;
+        gsStack_create_(&conflicts, sizeof(prConflict));
+    }
+    clock_t start = clock();
+
+    _prSLRHelper slr_helper;
+    _prSLRHelper_fill_(&slr_helper, grammar);
+    if (report != NULL) {
+        report->first_follow_seconds = _pr_seconds_since(start);
+        start = clock();
+    }
+
+    faNfa* const nfa = _prGrammar_construct_nfa(grammar);
+    if (nfa == NULL) {
+        if (report != NULL) {
+            gsStack_destroy_(&conflicts);
+        }
+        _prSLRHelper_destroy_(&slr_helper);
+        FREE(self);
+        return NULL;
+    }
+    if (report != NULL) {
+        report->item_nfa_seconds = _pr_seconds_since(start);
+        start = clock();
+    }
+
+    gsStack subsets;
+    faDfa_create_nfaec_with_subsets_(&self->dfa, &subsets, nfa,
+                                     unsignedMaybe_from_unsigned(grammar->num_of_tokens));
+    faNfa_destroy(nfa);
+    if (report != NULL) {
+        report->subset_construction_seconds = _pr_seconds_since(start);
+        start = clock();
+    }
+
+    self->are_tables_borrowed = false;
+    self->bt_list_length = 0;
+    self->bt_list = NULL;
+    self->bt_table = CALLOC(self->dfa.num_of_tokens * self->dfa.num_of_states,
+                            sizeof(*self->bt_table));
+
+    boolean is_slr;
+    if (is_lalr == true) {
+        _prLALRHelper lalr_helper;
+        _prLALRHelper_fill_(&lalr_helper, grammar, &self->dfa,
+                            slr_helper.nullable);
+        if (report != NULL) {
+            report->lookahead_seconds = _pr_seconds_since(start);
+            start = clock();
+        }
+        is_slr = _prSLRParser_fill_bt_table_(self, grammar, &subsets,
+                                             &slr_helper, _pr_lalr_lookahead,
+                                             &lalr_helper, "LALR",
+                                             report != NULL ? &conflicts : NULL,
+                                             out_diagnostic);
+        _prLALRHelper_destroy_(&lalr_helper);
+    } else {
+        _prSLRLookaheadAux slr_lookahead_aux;
+        slr_lookahead_aux.grammar = grammar;
+        slr_lookahead_aux.slr_helper = &slr_helper;
+        is_slr = _prSLRParser_fill_bt_table_(self, grammar, &subsets,
+                                             &slr_helper, _pr_slr_lookahead,
+                                             &slr_lookahead_aux, "SLR",
+                                             report != NULL ? &conflicts : NULL,
+                                             out_diagnostic);
+    }
+    if (report != NULL) {
+        report->action_filling_seconds = _pr_seconds_since(start);
+        report->num_of_conflicts = gsStack_length(&conflicts);
+        report->conflicts = gsStack_0(&conflicts);
+        _prSLRParserReport_fill_tables_(report, self, grammar, &subsets);
+    }
+
     if (gsStack_length(&subsets) != 0) {
 	ssSubset* const s0 = gsStack_0(&subsets);
 	for (ssSubset* s = gsStack_end(&subsets); s > s0;) {
@@ -864,11 +2675,133 @@ prSLRParser* prSLRParser_create_from_grammar(const prGrammar* grammar,
     return (prSLRParser*) self;
 }
 
+prSLRParser* prSLRParser_create_from_grammar(const prGrammar* grammar,
+					     char* out_diagnostic) {
+    return _prSLRParser_create_from_grammar(grammar, false, NULL,
+                                            out_diagnostic);
+}
+
+prSLRParser* prSLRParser_create_lalr_from_grammar(const prGrammar* grammar,
+                                                  char* out_diagnostic) {
+    return _prSLRParser_create_from_grammar(grammar, true, NULL,
+                                            out_diagnostic);
+}
+
+prSLRParser* prSLRParser_create_with_report(const prGrammar* grammar,
+                                            boolean is_lalr,
+                                            prSLRParserReport* out_report,
+                                            char* out_diagnostic) {
+    return _prSLRParser_create_from_grammar(grammar, is_lalr, out_report,
+                                            out_diagnostic);
+}
+
+void prSLRParserReport_destroy_(prSLRParserReport* self) {
+    FREE(self->num_of_items);
+    FREE(self->conflicts);
+    return;
+}
+
+void prSLRParser_get_tables(const prSLRParser* self,
+                            prSLRParserTables* out_tables) {
+    const faDfaBt* const dfa_bt = (const faDfaBt*) self;
+    out_tables->num_of_states = dfa_bt->dfa.num_of_states;
+    out_tables->num_of_tokens = dfa_bt->dfa.num_of_tokens;
+    out_tables->cosink = dfa_bt->dfa.cosink;
+    out_tables->reject = dfa_bt->dfa.reject;
+    out_tables->num_of_productions = dfa_bt->bt_list_length;
+    out_tables->sinks = dfa_bt->dfa.sinks;
+    out_tables->transition_table = dfa_bt->dfa.transition_table;
+    out_tables->bt_table = dfa_bt->bt_table;
+    out_tables->bt_list = (const unsigned*) dfa_bt->bt_list;
+    return;
+}
+
+prSLRParser* prSLRParser_create_from_tables(const prSLRParserTables* tables) {
+    faDfaBt* const self = MALLOC(sizeof(*self));
+    self->dfa.num_of_states = tables->num_of_states;
+    self->dfa.num_of_tokens = tables->num_of_tokens;
+    self->dfa.cosink = tables->cosink;
+    self->dfa.reject = tables->reject;
+    self->bt_list_length = tables->num_of_productions;
+    /* the tables are never written to, so casting the const away is fine */
+    self->dfa.sinks = (boolean*) tables->sinks;
+    self->dfa.transition_table = (unsigned*) tables->transition_table;
+    self->bt_table = (unsigned*) tables->bt_table;
+    /* faBtItem is a pair of unsigned, as bt_list lists them */
+    self->bt_list = (faBtItem*) tables->bt_list;
+    self->are_tables_borrowed = true;
+    return (prSLRParser*) self;
+}
+
+void prSLRParser_bypass_unit_productions(prSLRParser* self,
+                                         const prGrammar* grammar,
+                                         const boolean* is_pass_through) {
+    boolean* const is_bypassable =
+        MALLOC(grammar->num_of_productions * sizeof(boolean));
+    for (unsigned i = 0; i < grammar->num_of_productions; ++i) {
+        is_bypassable[i] = is_pass_through == NULL || is_pass_through[i];
+    }
+    /* the formal production is what accepts, after the end of the input,
+       and the lists are gathered by their reductions */
+    is_bypassable[0] = false;
+    for (unsigned i = 1; i < grammar->num_of_productions; ++i) {
+        const prProduction* const production = prGrammar_production(grammar,
+                                                                    i);
+        if (grammar->list_roles[i] != PR_LIST_ROLE_NONE
+            || (production->body_length == 1
+                && grammar->is_list[production->body[0]] == true)) {
+            is_bypassable[i] = false;
+        }
+    }
+    faDfaBt_bypass_unit_reductions_((faDfaBt*) self, is_bypassable,
+                                    grammar->num_of_terminals);
+    FREE(is_bypassable);
+    return;
+}
+
+size_t prSLRParser_serialize(const prSLRParser* self, void* buffer) {
+    return faDfaBt_serialize((const faDfaBt*) self, buffer);
+}
+
+prSLRParser* prSLRParser_create_from_binary(const void* buffer, size_t size,
+                                            char* out_diagnostic) {
+    faDfaBt* const self = MALLOC(sizeof(*self));
+    if (faDfaBt_create_from_binary_(self, buffer, size) == false) {
+        if (out_diagnostic != NULL) {
+            sprintf(out_diagnostic,
+                    "Error reading parser: the buffer does not hold valid "
+                    "parse tables in the binary form of version %u "
+                    "for this platform.\n", FA_DFA_BT_BINARY_VERSION);
+        }
+        FREE(self);
+        return NULL;
+    }
+    return (prSLRParser*) self;
+}
+
 unsigned* prSLRParser_parse(const prSLRParser* self, const unsigned* tokens,
                             const unsigned** out_end_pos) {
     return faDfaBt_parse((faDfaBt*) self, tokens, out_end_pos);
 }
 
+unsigned prSLRParser_parse_with_recovery(const prSLRParser* self,
+                                        const prGrammar* grammar,
+                                        const unsigned* tokens,
+                                        unsigned** out_error_positions) {
+    boolean* const is_synchronizing =
+        CALLOC(grammar->num_of_tokens, sizeof(boolean));
+    for (unsigned i = 0; i < grammar->num_of_synchronizing_tokens; ++i) {
+        is_synchronizing[grammar->synchronizing_tokens[i]] = true;
+    }
+    const unsigned num_of_errors =
+        faDfaBt_parse_with_recovery((const faDfaBt*) self, tokens,
+                                    is_synchronizing,
+                                    grammar->num_of_terminals,
+                                    out_error_positions);
+    FREE(is_synchronizing);
+    return num_of_errors;
+}
+
 void prSLRParser_synthesize(const prSLRParser* self, const unsigned* items,
                             const unsigned* vals, unsigned element_size,
                             prTerminalSynthFn terminal_synth_fn,
@@ -879,6 +2812,330 @@ void prSLRParser_synthesize(const prSLRParser* self, const unsigned* items,
     return;
 }
 
+boolean prSLRParser_parse_and_synthesize(const prSLRParser* self,
+                                         const unsigned* tokens,
+                                         const unsigned* vals,
+                                         unsigned element_size,
+                                         prTerminalSynthFn terminal_synth_fn,
+                                         prProductionSynthFn production_synth_fn,
+                                         void* extra, void* result,
+                                         const unsigned** out_end_pos) {
+    return faDfaBt_parse_and_synthesize((faDfaBt*) self, tokens, vals,
+                                        element_size, terminal_synth_fn,
+                                        production_synth_fn, extra, result,
+                                        out_end_pos);
+}
+
+typedef struct _prListSynthesizer {
+    const prGrammar* grammar;
+    unsigned element_size;
+    prTerminalSynthFn terminal_synth_fn;
+    prProductionSynthFn production_synth_fn;
+    prListSynthFn list_synth_fn;
+    void* extra;
+    /* the elements of the lists not complete yet, one list after the
+       other, and where each list starts; as the lists are parts of the
+       parse stack, the last one started is the first completed */
+    gsStack elements;
+    gsStack list_starts;
+}                          _prListSynthesizer;
+
+static void _prListSynthesizer_terminal_synth_fn(unsigned token,
+                                                 unsigned val,
+                                                 void* attribute,
+                                                 void* extra) {
+    _prListSynthesizer* const self = extra;
+    self->terminal_synth_fn(token, val, attribute, self->extra);
+    return;
+}
+
+static void _prListSynthesizer_production_synth_fn(unsigned production,
+                                                   void* attributes,
+                                                   void* extra) {
+    _prListSynthesizer* const self = extra;
+    const prProduction* const reduced =
+        prGrammar_production(self->grammar, production);
+    const _prListRole list_role = self->grammar->list_roles[production];
+    char* const result = attributes;
+    const size_t size = self->element_size;
+
+    /* the lists of the body are complete (but the one appended to) */
+    const unsigned first = list_role == PR_LIST_ROLE_APPEND ? 1 : 0;
+    for (unsigned i = reduced->body_length; i > first; --i) {
+        const unsigned list = reduced->body[i - 1];
+        if (self->grammar->is_list[list] == false) {
+            continue;
+        }
+        const unsigned start = * (unsigned*) gsStack_last(&self->list_starts);
+        const unsigned count = gsStack_length(&self->elements) - start;
+        self->list_synth_fn(list, count,
+                            (char*) gsStack_0(&self->elements) + start * size,
+                            result - (reduced->body_length - i + 1) * size,
+                            self->extra);
+        gsStack_post_pop_several_(&self->elements, count);
+        gsStack_post_pop_(&self->list_starts);
+    }
+
+    switch (list_role) {
+    case PR_LIST_ROLE_NONE:
+        self->production_synth_fn(production, attributes, self->extra);
+        return;
+    case PR_LIST_ROLE_START:
+        GS_APPEND(&self->list_starts, gsStack_length(&self->elements),
+                  unsigned);
+        break;
+    case PR_LIST_ROLE_APPEND:
+        break;
+    }
+    if (reduced->body_length != 0) {
+        gsStack_pre_append_(&self->elements);
+        memcpy(gsStack_last(&self->elements), result - size, size);
+    }
+    /* the attribute of a list is written once it is complete */
+    memset(result, 0, size);
+    return;
+}
+
+boolean prSLRParser_parse_and_synthesize_lists(const prSLRParser* self,
+                                               const prGrammar* grammar,
+                                               const unsigned* tokens,
+                                               const unsigned* vals,
+                                               unsigned element_size,
+                                               prTerminalSynthFn terminal_synth_fn,
+                                               prProductionSynthFn production_synth_fn,
+                                               prListSynthFn list_synth_fn,
+                                               void* extra, void* result,
+                                               const unsigned** out_end_pos) {
+    _prListSynthesizer synthesizer;
+    synthesizer.grammar = grammar;
+    synthesizer.element_size = element_size;
+    synthesizer.terminal_synth_fn = terminal_synth_fn;
+    synthesizer.production_synth_fn = production_synth_fn;
+    synthesizer.list_synth_fn = list_synth_fn;
+    synthesizer.extra = extra;
+    gsStack_create_(&synthesizer.elements, element_size);
+    gsStack_create_(&synthesizer.list_starts, sizeof(unsigned));
+    const boolean is_parsed =
+        faDfaBt_parse_and_synthesize((const faDfaBt*) self, tokens, vals,
+                                     element_size,
+                                     _prListSynthesizer_terminal_synth_fn,
+                                     _prListSynthesizer_production_synth_fn,
+                                     &synthesizer, result, out_end_pos);
+    gsStack_destroy_(&synthesizer.elements);
+    gsStack_destroy_(&synthesizer.list_starts);
+    return is_parsed;
+}
+
+/* a node of a prCst under construction */
+typedef struct _prCstNode {
+    unsigned kind;
+    unsigned first_child;
+    unsigned next_sibling;
+    unsigned start;
+    unsigned end;
+    unsigned subtree_size;
+}                          _prCstNode;
+
+typedef struct _prCstBuilder {
+    const faDfaBt* dfa_bt;
+    const unsigned char* token_spans;
+    unsigned span_size;
+    unsigned num_of_leaves;
+    /* of _prCstNode */
+    gsStack nodes;
+    /* the nodes of the parse stack, whose parents are not built yet */
+    gsStack roots;
+}                          _prCstBuilder;
+
+/* adds the node of the item, as a faItemFn */
+static void _prCstBuilder_item_fn(unsigned item, void* extra) {
+    _prCstBuilder* const self = extra;
+    const unsigned num_of_tokens = self->dfa_bt->dfa.num_of_tokens;
+    gsStack_pre_append_(&self->nodes);
+    _prCstNode* const nodes = gsStack_0(&self->nodes);
+    _prCstNode* const node = gsStack_last(&self->nodes);
+    node->kind = item;
+    node->next_sibling = PR_CST_NONE;
+    node->subtree_size = 1;
+    if (item < num_of_tokens) {
+        node->first_child = PR_CST_NONE;
+        if (self->token_spans == NULL) {
+            node->start = self->num_of_leaves;
+            node->end = self->num_of_leaves + 1;
+        } else {
+            const unsigned* const span = (const unsigned*)
+                (self->token_spans + self->num_of_leaves * self->span_size);
+            node->start = span[0];
+            node->end = span[1];
+        }
+        ++self->num_of_leaves;
+    } else {
+        /* the children are the last roots */
+        const unsigned num_of_children =
+            self->dfa_bt->bt_list[item - num_of_tokens].num_of_steps;
+        if (num_of_children == 0) {
+            node->first_child = PR_CST_NONE;
+            node->start = node->end = node == nodes ? 0 : node[-1].end;
+        } else {
+            const unsigned* const children = (const unsigned*)
+                gsStack_end(&self->roots) - num_of_children;
+            node->first_child = children[0];
+            node->start = nodes[children[0]].start;
+            node->end = nodes[children[num_of_children - 1]].end;
+            for (unsigned i = 0; i < num_of_children; ++i) {
+                nodes[children[i]].next_sibling =
+                    i + 1 < num_of_children ? children[i + 1] : PR_CST_NONE;
+                node->subtree_size += nodes[children[i]].subtree_size;
+            }
+        }
+        gsStack_post_pop_several_(&self->roots, num_of_children);
+    }
+    GS_APPEND(&self->roots, gsStack_length(&self->nodes) - 1, unsigned);
+    return;
+}
+
+prCst* prSLRParser_parse_to_cst(const prSLRParser* self,
+                                const unsigned* tokens,
+                                const void* token_spans, unsigned span_size,
+                                const unsigned** out_end_pos) {
+    _prCstBuilder builder;
+    builder.dfa_bt = (const faDfaBt*) self;
+    builder.token_spans = token_spans;
+    builder.span_size = span_size;
+    builder.num_of_leaves = 0;
+    gsStack_create_(&builder.nodes, sizeof(_prCstNode));
+    gsStack_create_(&builder.roots, sizeof(unsigned));
+    const boolean is_parsed =
+        faDfaBt_parse_with_item_fn(builder.dfa_bt, tokens,
+                                   _prCstBuilder_item_fn, &builder,
+                                   out_end_pos);
+    gsStack_destroy_(&builder.roots);
+    if (is_parsed == false) {
+        gsStack_destroy_(&builder.nodes);
+        return NULL;
+    }
+
+    /* the arrays right after the struct, in one allocation */
+    const unsigned num_of_nodes = gsStack_length(&builder.nodes);
+    prCst* const cst =
+        MALLOC(sizeof(prCst) + 6 * (size_t) num_of_nodes * sizeof(unsigned));
+    cst->num_of_nodes = num_of_nodes;
+    cst->kinds = (unsigned*) (cst + 1);
+    cst->first_children = cst->kinds + num_of_nodes;
+    cst->next_siblings = cst->first_children + num_of_nodes;
+    cst->starts = cst->next_siblings + num_of_nodes;
+    cst->ends = cst->starts + num_of_nodes;
+    cst->subtree_sizes = cst->ends + num_of_nodes;
+    const _prCstNode* const nodes = gsStack_0(&builder.nodes);
+    for (unsigned i = 0; i < num_of_nodes; ++i) {
+        cst->kinds[i] = nodes[i].kind;
+        cst->first_children[i] = nodes[i].first_child;
+        cst->next_siblings[i] = nodes[i].next_sibling;
+        cst->starts[i] = nodes[i].start;
+        cst->ends[i] = nodes[i].end;
+        cst->subtree_sizes[i] = nodes[i].subtree_size;
+    }
+    gsStack_destroy_(&builder.nodes);
+    return cst;
+}
+
+void prCst_destroy(prCst* self) {
+    FREE(self);
+    return;
+}
+
+void prSLRPushParser_destroy(prSLRPushParser* self) {
+    if (self == NULL) {
+        return;
+    }
+    faDfaBtPushParse_destroy_((faDfaBtPushParse*) self);
+    FREE(self);
+    return;
+}
+
+prSLRPushParser* prSLRPushParser_create(const prSLRParser* parser) {
+    prSLRPushParser* const self = MALLOC(sizeof(*self));
+    faDfaBtPushParse_create_((faDfaBtPushParse*) self, (const faDfaBt*) parser);
+    return self;
+}
+
+static prParseStatus _pr_parse_status(faParseStatus status) {
+    switch (status) {
+    case FA_PARSE_ACCEPT:
+        return PR_PARSE_ACCEPT;
+    case FA_PARSE_REJECT:
+        return PR_PARSE_REJECT;
+    default:
+        return PR_PARSE_CONTINUE;
+    }
+}
+
+prParseStatus prSLRPushParser_feed(prSLRPushParser* self, unsigned token) {
+    return _pr_parse_status(
+        faDfaBtPushParse_feed_((faDfaBtPushParse*) self, token));
+}
+
+prParseStatus prSLRPushParser_finish(prSLRPushParser* self) {
+    return _pr_parse_status(faDfaBtPushParse_finish_((faDfaBtPushParse*) self));
+}
+
+unsigned prSLRPushParser_num_of_consumed_tokens(const prSLRPushParser* self) {
+    return ((const faDfaBtPushParse*) self)->num_of_consumed_tokens;
+}
+
+unsigned* prSLRPushParser_release_items(prSLRPushParser* self) {
+    return faDfaBtPushParse_release_items_((faDfaBtPushParse*) self);
+}
+
+void prSLRIncrementalParser_destroy(prSLRIncrementalParser* self) {
+    if (self == NULL) {
+        return;
+    }
+    faDfaBtIncrementalParse_destroy_((faDfaBtIncrementalParse*) self);
+    FREE(self);
+    return;
+}
+
+prSLRIncrementalParser* prSLRIncrementalParser_create(const prSLRParser* parser,
+                                                      const unsigned* tokens) {
+    prSLRIncrementalParser* const self = MALLOC(sizeof(*self));
+    faDfaBtIncrementalParse_create_((faDfaBtIncrementalParse*) self,
+                                    (const faDfaBt*) parser, tokens);
+    return self;
+}
+
+prParseStatus prSLRIncrementalParser_edit(prSLRIncrementalParser* self,
+                                          unsigned start, unsigned old_end,
+                                          const unsigned* new_tokens,
+                                          unsigned new_length) {
+    return _pr_parse_status(
+        faDfaBtIncrementalParse_edit_((faDfaBtIncrementalParse*) self,
+                                      start, old_end, new_tokens, new_length));
+}
+
+prParseStatus prSLRIncrementalParser_status(const prSLRIncrementalParser* self) {
+    return _pr_parse_status(
+        ((const faDfaBtIncrementalParse*) self)->push_parse.status);
+}
+
+unsigned prSLRIncrementalParser_num_of_consumed_tokens(const prSLRIncrementalParser* self) {
+    return ((const faDfaBtIncrementalParse*) self)
+        ->push_parse.num_of_consumed_tokens;
+}
+
+const unsigned* prSLRIncrementalParser_items(const prSLRIncrementalParser* self) {
+    const faDfaBtPushParse* const push_parse =
+        &((const faDfaBtIncrementalParse*) self)->push_parse;
+    if (push_parse->status != FA_PARSE_ACCEPT) {
+        return NULL;
+    }
+    return gsStack_0(&push_parse->parse_items);
+}
+
+unsigned prSLRIncrementalParser_num_of_reparsed_tokens(const prSLRIncrementalParser* self) {
+    return ((const faDfaBtIncrementalParse*) self)->num_of_reparsed_tokens;
+}
+
 /*-------------------------*//*-------------------------*/
 /*-------------------------*//*-------------------------*/
 /*-------------------------*//*-------------------------*/
@@ -915,10 +3172,103 @@ void prGrammar_print(const prGrammar* self) {
         for (unsigned j = 0; j < production->body_length; ++j) {
             printf("%s ", self->token_names[production->body[j]]);
         }
+        if (self->production_precedences[i] != 0) {
+            printf("(precedence %u)", self->production_precedences[i]);
+        }
+        printf("\n");
+    }
+    if (self->num_of_precedence_levels != 0) {
+        const char* const associativity_names[] = {
+            "left", "right", "nonassoc"
+        };
+        printf("  * %u precedence levels:\n", self->num_of_precedence_levels);
+        for (unsigned i = 0; i < self->num_of_precedence_levels; ++i) {
+            printf("    - %u (%s): ", i + 1,
+                   associativity_names[self->associativities[i]]);
+            for (unsigned j = 0; j < self->num_of_terminals; ++j) {
+                if (self->terminal_precedences[j] == i + 1) {
+                    printf("%s ", self->token_names[j]);
+                }
+            }
+            printf("\n");
+        }
+    }
+    if (self->num_of_synchronizing_tokens != 0) {
+        printf("  * %u synchronizing tokens:\n    ",
+               self->num_of_synchronizing_tokens);
+        for (unsigned i = 0; i < self->num_of_synchronizing_tokens; ++i) {
+            printf("%s ", self->token_names[self->synchronizing_tokens[i]]);
+        }
         printf("\n");
     }
     printf("----\n");
     return;
 }
 
+static void _prGrammar_print_production(const prGrammar* self,
+                                        unsigned production_id) {
+    const prProduction* const production =
+        prGrammar_production(self, production_id);
+    printf("%s -> ", self->token_names[production->head]);
+    for (unsigned j = 0; j < production->body_length; ++j) {
+        printf("%s ", self->token_names[production->body[j]]);
+    }
+    return;
+}
+
+void prSLRParserReport_print(const prSLRParserReport* self,
+                             const prGrammar* grammar) {
+    printf("----\n");
+    unsigned max_num_of_items = 0;
+    unsigned long total_num_of_items = 0;
+    for (unsigned i = 0; i < self->num_of_states; ++i) {
+        total_num_of_items += self->num_of_items[i];
+        if (self->num_of_items[i] > max_num_of_items) {
+            max_num_of_items = self->num_of_items[i];
+        }
+    }
+    printf("The LR(0) automaton has %u states, of %lu items in all "
+           "(at most %u in a state).\n",
+           self->num_of_states, total_num_of_items, max_num_of_items);
+    printf("The tables have:\n");
+    printf("  * %u of %u action entries filled (%.1f%%)\n",
+           self->num_of_filled_action_entries, self->num_of_action_entries,
+           self->num_of_action_entries == 0 ? 0.0 :
+           100.0 * self->num_of_filled_action_entries
+           / self->num_of_action_entries);
+    printf("  * %u of %u goto entries filled (%.1f%%)\n",
+           self->num_of_filled_goto_entries, self->num_of_goto_entries,
+           self->num_of_goto_entries == 0 ? 0.0 :
+           100.0 * self->num_of_filled_goto_entries
+           / self->num_of_goto_entries);
+    printf("  * %zu bytes of sinks, %zu of transition table, "
+           "%zu of bt table and %zu of bt list\n",
+           self->sinks_size, self->transition_table_size,
+           self->bt_table_size, self->bt_list_size);
+    printf("The generation took %.6f s for FIRST and FOLLOW, "
+           "%.6f s for the item NFA,\n"
+           "%.6f s for the subset construction, %.6f s for the LALR(1) "
+           "lookaheads and %.6f s for filling the actions.\n",
+           self->first_follow_seconds, self->item_nfa_seconds,
+           self->subset_construction_seconds, self->lookahead_seconds,
+           self->action_filling_seconds);
+    printf("There are %u conflicts%s\n", self->num_of_conflicts,
+           self->num_of_conflicts == 0 ? "." : ":");
+    for (unsigned i = 0; i < self->num_of_conflicts; ++i) {
+        const prConflict* const conflict = self->conflicts + i;
+        printf("  * in state %u on %s, reducing by ", conflict->state,
+               grammar->token_names[conflict->lookahead]);
+        _prGrammar_print_production(grammar, conflict->production);
+        if (conflict->other_production == PR_CONFLICT_SHIFT) {
+            printf("or shifting\n");
+        } else {
+            printf("or by ");
+            _prGrammar_print_production(grammar, conflict->other_production);
+            printf("\n");
+        }
+    }
+    printf("----\n");
+    return;
+}
+
 #endif /* TESTING_PRINTS */
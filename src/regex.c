@@ -1,11 +1,16 @@
 #include "regex.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h> /* for uintptr_t */
+#include <time.h>
 
 #include "standard.h"
 #include "ma.h"
 #include "str.h"
 #include "gs.h"
+#include "./ss.h"
 #include "./fa.h"
 #include "parser.h"
 
@@ -22,7 +27,53 @@ struct rexCompiledRegex {
 struct rexCompiledRegexList {
     unsigned length;
     rexCompiledRegex** compiled_regexes;
-    faDfaOfCharsRaceAux* aux;
+};
+
+struct rexRaceState {
+    /* the number of regexes it has room for */
+    unsigned length;
+    faDfaOfCharsRaceAux aux[];
+};
+
+struct rexCompiledRegexSet {
+    unsigned length;
+    faDfaOfChars self_as_faDfaOfChars;
+    /* the patterns accepted at state i are
+       accept_list[accept_offsets[i]], ..., accept_list[accept_offsets[i+1]-1],
+       in increasing order */
+    unsigned* accept_offsets;
+    unsigned* accept_list;
+};
+
+typedef struct _rexCacheEntry {
+    char* regex;
+    size_t hash;
+    rexCompiledRegex* compiled_regex;
+    size_t memory_size;
+    unsigned num_of_references;
+    /* the entries with no references form a list, from the most recently
+       released to the least recently released */
+    struct _rexCacheEntry* lru_previous;
+    struct _rexCacheEntry* lru_next;
+    /* chaining in the hash table by regex */
+    struct _rexCacheEntry* next_by_regex;
+    /* chaining in the hash table by compiled_regex */
+    struct _rexCacheEntry* next_by_compiled_regex;
+} _rexCacheEntry;
+
+struct rexCompiledRegexCache {
+    const rexRegexSLRParser* regex_slr_parser;
+    size_t max_memory_size;
+    size_t memory_size;
+    rexLockFn lock_fn;
+    rexLockFn unlock_fn;
+    void* lock;
+    unsigned num_of_entries;
+    unsigned num_of_buckets;
+    _rexCacheEntry** buckets_by_regex;
+    _rexCacheEntry** buckets_by_compiled_regex;
+    _rexCacheEntry* lru_first;
+    _rexCacheEntry* lru_last;
 };
 
 /*-------------------------*/
@@ -30,7 +81,7 @@ struct rexCompiledRegexList {
 /*-------------------------*/
 
 static const char rex_spec[] =
-    "char letter digit whitespace specific_char ( ) * + ? | \n"
+    "char letter digit whitespace specific_char ( ) * + ? | repeat class \n"
     "@@nonterminals \n"
     "E F G S \n"
     "@@productions \n"
@@ -38,24 +89,30 @@ static const char rex_spec[] =
     "G -> ( E ) \n E -> E | F \n F -> F G \n"
     "G -> G * \n G -> G + \n G -> G ? \n"
     "G -> char \n G -> letter \n G -> digit \n"
-    "G -> whitespace \n G -> specific_char";
+    "G -> whitespace \n G -> specific_char \n"
+    "G -> G repeat \n G -> class";
+
+/* the tables of the parser of rex_spec, baked by tools/prgen.sh */
+#include "./regex_tables.h"
 
 /* the tokens in the regular expression grammar */
 
 #define REX_UNDEFINED 0 /* 0 is always undefined token */
-#define REX_C 1 /* a specific character */
+#define REX_C 1 /* any character */
 #define REX_A 2 /* a letter */
 #define REX_D 3 /* a digit */
 #define REX_W 4 /* a white space */
-#define REX_c 5 /* any charater */
+#define REX_c 5 /* a specific charater */
 #define REX_LP 6 /* ( */
 #define REX_RP 7 /* ) */
 #define REX_STAR 8 /* * */
 #define REX_PLUS 9 /* + */
 #define REX_QUESTION 10 /* ? */
 #define REX_OR 11 /* | */
-#define REX_S 12 /* a statement */
-#define REX_SS 13 /* a formally added token, producing REX_S */
+#define REX_REPEAT 12 /* {m}, {m,} or {m,n} */
+#define REX_CLASS 13 /* [...] or [^...] */
+#define REX_S 17 /* a statement */
+#define REX_SS 18 /* a formally added token, producing REX_S */
 
 /* the productions in the regular expression grammar */
 
@@ -74,6 +131,8 @@ static const char rex_spec[] =
 #define REX_PR_D 12
 #define REX_PR_W 13
 #define REX_PR_c 14
+#define REX_PR_REPEAT 15
+#define REX_PR_CLASS 16
 
 /*-------------------------*/
 
@@ -83,56 +142,349 @@ void rexRegexSLRParser_destroy(rexRegexSLRParser* self) {
 }
 
 rexRegexSLRParser* rexRegexSLRParser_create(void) {
+    return (rexRegexSLRParser*) prSLRParser_create_from_tables(&rex_tables);
+}
+
+rexRegexSLRParser* rexRegexSLRParser_create_from_spec(void) {
     prGrammar* grammar = prGrammar_create_from_spec(rex_spec, NULL);
     if (grammar == NULL) {
 	return NULL;
     }
     rexRegexSLRParser* regex_slr_parser =
 	(rexRegexSLRParser*) prSLRParser_create_from_grammar(grammar, NULL);
-    prGrammar_destroy(grammar);
     if (regex_slr_parser == NULL) {
+	prGrammar_destroy(grammar);
 	return NULL;
     }
+    /* the unit productions (REX_PR_RED1..3 and those of G to a single token)
+       pass the attribute through in _rex_production_synth_fn */
+    prSLRParser_bypass_unit_productions((prSLRParser*) regex_slr_parser,
+					grammar, NULL);
+    prGrammar_destroy(grammar);
     return regex_slr_parser;
 }
 
+size_t rexRegexSLRParser_serialize(const rexRegexSLRParser* self,
+				   void* buffer) {
+    return prSLRParser_serialize((const prSLRParser*) self, buffer);
+}
+
+rexRegexSLRParser* rexRegexSLRParser_create_from_binary(const void* buffer,
+							size_t size) {
+    return (rexRegexSLRParser*) prSLRParser_create_from_binary(buffer, size,
+							       NULL);
+}
+
 void rexCompiledRegex_destroy(rexCompiledRegex* self) {
     faDfaOfChars_destroy((faDfaOfChars*) self);
 }
 
+/* the bounds of a counted repetition */
+typedef struct _rexRepeatBounds {
+    unsigned min;
+    unsignedMaybe max;
+} _rexRepeatBounds;
+
+/* a set of characters, given by \c, \a, \d, \w or [...] */
+typedef struct _rexCharClass {
+    unsigned char is_in[128];
+} _rexCharClass;
+
+/* the classes which always come first in the classes of a regex */
+#define REX_CLASS_ANY 0
+#define REX_CLASS_LETTER 1
+#define REX_CLASS_DIGIT 2
+#define REX_CLASS_WHITESPACE 3
+#define REX_NUM_OF_PREDEFINED_CLASSES 4
+
+/* the attributes synthesized when parsing a regex */
+typedef union _rexAttribute {
+    faNfa* nfa;
+    /* for REX_REPEAT, the index of its bounds in repeat_bounds */
+    unsigned repeat;
+} _rexAttribute;
+
 typedef struct _rexPreprocessResult {
     const rexRegexSLRParser* regex_slr_parser;
     unsigned* char_to_token_table;
     unsigned* tokens;
     unsigned* ids;
-    unsigned* tokens_C;
-    unsigned* tokens_A;
-    unsigned* tokens_D;
-    unsigned* tokens_W;
+    _rexRepeatBounds* repeat_bounds;
+    /* the tokens of class i (which are exactly those of the characters
+       in class i) are
+       class_tokens[class_tokens_offsets[i]], ...,
+       class_tokens[class_tokens_offsets[i+1]-1] */
+    unsigned* class_tokens;
+    unsigned* class_tokens_offsets;
     unsigned num_of_tokens;
 } _rexPreprocessResult;
 
 static void _rexPreprocessResult_destroy_(_rexPreprocessResult* self) {
     FREE(self->tokens);
     FREE(self->ids);
-    FREE(self->tokens_W);
-    FREE(self->tokens_D);
-    FREE(self->tokens_A);
-    FREE(self->tokens_C);
+    FREE(self->repeat_bounds);
+    FREE(self->class_tokens);
+    FREE(self->class_tokens_offsets);
+    return;
+}
+
+static void _rex_add_predefined_classes(gsStack* classes) {
+    gsStack_pre_append_several_(classes, REX_NUM_OF_PREDEFINED_CLASSES);
+    _rexCharClass* const predefined = gsStack_0(classes);
+    for (unsigned c = 0; c < 128; ++c) {
+	predefined[REX_CLASS_ANY].is_in[c] = (c != 0);
+	predefined[REX_CLASS_LETTER].is_in[c] =
+	    ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+	predefined[REX_CLASS_DIGIT].is_in[c] = (c >= '0' && c <= '9');
+	predefined[REX_CLASS_WHITESPACE].is_in[c] =
+	    (c == ' ' || c == '\t' || c == '\n');
+    }
     return;
 }
 
+/* reads an escaped character standing for itself, with the cursor on the
+   backslash; returns 0 if there is none */
+static char _rex_read_escaped_char(const char* cursor) {
+    switch (*(cursor+1)) {
+    case 't':
+	return '\t';
+    case 'n':
+	return '\n';
+    case '(':
+    case ')':
+    case '*':
+    case '+':
+    case '?':
+    case '|':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case '^':
+    case '-':
+    case '\\':
+	return *(cursor+1);
+    }
+    return 0;
+}
+
+/* reads [...] or [^...] with the cursor on the opening bracket,
+   leaving the cursor on the closing bracket;
+   returns false if it is not well formed */
+static boolean _rex_read_class(const char** cursor, const char* regex_end,
+			       const _rexCharClass* predefined,
+			       _rexCharClass* out_class) {
+    boolean is_negated = false;
+    memset(out_class->is_in, 0, sizeof(out_class->is_in));
+    ++*cursor;
+    if (*cursor != regex_end && **cursor == '^') {
+	is_negated = true;
+	++*cursor;
+    }
+    for (;;) {
+	if (*cursor == regex_end || **cursor == 0) {
+	    return false;
+	}
+	if (**cursor == ']') {
+	    break;
+	}
+	unsigned char first;
+	if (**cursor == '\\') {
+	    const char next = *(*cursor+1);
+	    const unsigned predefined_class =
+		(next == 'c' ? REX_CLASS_ANY
+		 : next == 'a' ? REX_CLASS_LETTER
+		 : next == 'd' ? REX_CLASS_DIGIT
+		 : next == 'w' ? REX_CLASS_WHITESPACE
+		 : REX_NUM_OF_PREDEFINED_CLASSES);
+	    if (predefined_class != REX_NUM_OF_PREDEFINED_CLASSES) {
+		for (unsigned c = 0; c < 128; ++c) {
+		    out_class->is_in[c] |=
+			predefined[predefined_class].is_in[c];
+		}
+		*cursor += 2;
+		continue;
+	    }
+	    first = _rex_read_escaped_char(*cursor);
+	    if (first == 0) {
+		return false;
+	    }
+	    *cursor += 2;
+	} else {
+	    first = **cursor;
+	    ++*cursor;
+	}
+	unsigned char last = first;
+	/* a range, unless the - is last in the class */
+	if (*cursor != regex_end && **cursor == '-'
+	    && *cursor + 1 != regex_end && *(*cursor+1) != ']') {
+	    ++*cursor;
+	    if (*cursor == regex_end || **cursor == 0) {
+		return false;
+	    }
+	    if (**cursor == '\\') {
+		last = _rex_read_escaped_char(*cursor);
+		if (last == 0) {
+		    return false;
+		}
+		*cursor += 2;
+	    } else {
+		last = **cursor;
+		++*cursor;
+	    }
+	    if (last < first) {
+		return false;
+	    }
+	}
+	for (unsigned c = first; c <= last && c < 128; ++c) {
+	    out_class->is_in[c] = 1;
+	}
+    }
+    if (is_negated == true) {
+	for (unsigned c = 1; c < 128; ++c) {
+	    out_class->is_in[c] = !out_class->is_in[c];
+	}
+    }
+    out_class->is_in[0] = 0;
+    return true;
+}
+
+static unsigned _rex_read_number(const char** cursor, const char* regex_end,
+				 boolean* out_found) {
+    unsigned result = 0;
+    *out_found = false;
+    for (; *cursor != regex_end && **cursor >= '0' && **cursor <= '9';
+	 ++*cursor) {
+	if (result > REX_MAX_REPEAT_BOUND) {
+	    continue;
+	}
+	result = 10 * result + (**cursor - '0');
+	*out_found = true;
+    }
+    return result;
+}
+
+/* reads {m}, {m,} or {m,n} with the cursor on the opening brace,
+   leaving the cursor on the closing brace;
+   returns false if it is not well formed */
+static boolean _rex_read_repeat_bounds(const char** cursor,
+				       const char* regex_end,
+				       _rexRepeatBounds* out_bounds) {
+    boolean found;
+    ++*cursor;
+    out_bounds->min = _rex_read_number(cursor, regex_end, &found);
+    if (found == false || *cursor == regex_end) {
+	return false;
+    }
+    if (**cursor == '}') {
+	out_bounds->max = unsignedMaybe_from_unsigned(out_bounds->min);
+    } else if (**cursor == ',') {
+	++*cursor;
+	const unsigned max = _rex_read_number(cursor, regex_end, &found);
+	if (*cursor == regex_end || **cursor != '}') {
+	    return false;
+	}
+	if (found == true) {
+	    if (max < out_bounds->min) {
+		return false;
+	    }
+	    out_bounds->max = unsignedMaybe_from_unsigned(max);
+	} else {
+	    out_bounds->max = unsignedMaybe_from_false();
+	}
+    } else {
+	return false;
+    }
+    if (out_bounds->min > REX_MAX_REPEAT_BOUND
+	|| (unsignedMaybe_is(out_bounds->max) == true
+	    && unsignedMaybe_value(out_bounds->max) > REX_MAX_REPEAT_BOUND)) {
+	return false;
+    }
+    return true;
+}
+
+/*
+  refines joint_table (a partition of the characters into tokens)
+  by table, so that two characters share a joint token only if they
+  shared one before and also share a token of table;
+  returns the number of joint tokens (including 0, for the character 0);
+  pair_to_token should be all zeros, and is left so
+*/
+static unsigned _rex_refine_char_to_token_table(unsigned* joint_table,
+						const unsigned* table,
+						unsigned table_num_of_tokens,
+						unsigned* pair_to_token) {
+    unsigned num_of_tokens = 1;
+    unsigned refined_table[128];
+    refined_table[0] = 0;
+    for (unsigned c = 1; c < 128; ++c) {
+	unsigned* const pair =
+	    pair_to_token + joint_table[c] * table_num_of_tokens + table[c];
+	if (*pair == 0) {
+	    *pair = num_of_tokens++;
+	}
+	refined_table[c] = *pair;
+    }
+    for (unsigned c = 1; c < 128; ++c) {
+	pair_to_token[joint_table[c] * table_num_of_tokens + table[c]] = 0;
+    }
+    memcpy(joint_table, refined_table, sizeof(refined_table));
+    return num_of_tokens;
+}
+
+static unsigned _rex_class_of_token(unsigned token, unsigned id) {
+    switch (token) {
+    case REX_C:
+	return REX_CLASS_ANY;
+    case REX_A:
+	return REX_CLASS_LETTER;
+    case REX_D:
+	return REX_CLASS_DIGIT;
+    case REX_W:
+	return REX_CLASS_WHITESPACE;
+    }
+    return id;
+}
+
 static _rexPreprocessResult rex_preprocess_regex(const char* regex,
 						 const char *regex_end,
-						 unsigned* char_to_token_table) {
-    gsStack token_sequence, id_sequence;
+						 unsigned* char_to_token_table,
+						 char* out_diagnostic) {
+    gsStack token_sequence, id_sequence, repeat_bounds, classes;
     _rexPreprocessResult result;
     gsStack_create_(&token_sequence, sizeof(unsigned));
     gsStack_create_(&id_sequence, sizeof(unsigned));
+    gsStack_create_(&repeat_bounds, sizeof(_rexRepeatBounds));
+    gsStack_create_(&classes, sizeof(_rexCharClass));
+    _rex_add_predefined_classes(&classes);
     for (; *regex != 0 && regex != regex_end; ++regex) {
 	unsigned new_token;
 	unsigned new_id = 0;
 	switch (*regex) {
+	case '{':
+	    new_token = REX_REPEAT;
+	    new_id = gsStack_length(&repeat_bounds);
+	    gsStack_pre_append_(&repeat_bounds);
+	    if (_rex_read_repeat_bounds(&regex, regex_end,
+					gsStack_last(&repeat_bounds)) == false) {
+		if (out_diagnostic != NULL) {
+		    snprintf(out_diagnostic, REX_MAX_DIAGNOSTIC_LENGTH,
+			     "Error compiling regex: a repetition is not well "
+			     "formed, or has a bound above %u.\n",
+			     REX_MAX_REPEAT_BOUND);
+		}
+		goto diagnosed_error_label;
+	    }
+	    break;
+	case '[':
+	    new_token = REX_CLASS;
+	    new_id = gsStack_length(&classes);
+	    gsStack_pre_append_(&classes);
+	    if (_rex_read_class(&regex, regex_end, gsStack_0(&classes),
+				gsStack_last(&classes)) == false) {
+		goto error_label;
+	    }
+	    break;
 	case '(':
 	    new_token = REX_LP;
 	    break;
@@ -152,15 +504,7 @@ static _rexPreprocessResult rex_preprocess_regex(const char* regex,
 	    new_token = REX_OR;
 	    break;
 	case '\\':
-	    ++regex;
-	    if (*regex == 0) {
-		gsStack_destroy_(&token_sequence);
-		gsStack_destroy_(&id_sequence);
-		result.tokens = NULL;
-		result.ids = NULL;
-		return result;
-	    }
-	    switch (*regex) {
+	    switch (*(regex+1)) {
 	    case 'a':
 		new_token = REX_A;
 		break;
@@ -173,29 +517,21 @@ static _rexPreprocessResult rex_preprocess_regex(const char* regex,
 	    case 'c':
 		new_token = REX_C;
 		break;
-	    case 't':
-		new_token = REX_c;
-		new_id = '\t';
-		break;
-	    case 'n':
+	    default:
 		new_token = REX_c;
-		new_id = '\n';
-		break;
-	    case '(':
-	    case ')':
-	    case '*':
-	    case '+':
-	    case '?':
-	    case '|':
-	    case '\\':
-		new_token = REX_c;
-		new_id = *regex;
-		break;
+		new_id = (unsigned char) _rex_read_escaped_char(regex);
+		if (new_id == 0) {
+		    goto error_label;
+		}
 	    }
+	    ++regex;
 	    break;
 	default:
 	    new_token = REX_c;
-	    new_id = *regex;
+	    new_id = (unsigned char) *regex;
+	    if (new_id >= 128) {
+		goto error_label;
+	    }
 	}
 	GS_APPEND(&token_sequence, new_token, unsigned);
 	GS_APPEND(&id_sequence, new_id, unsigned);
@@ -203,174 +539,334 @@ static _rexPreprocessResult rex_preprocess_regex(const char* regex,
     GS_APPEND(&token_sequence, 0, unsigned);
     result.tokens = gsStack_0(&token_sequence);
     result.ids = gsStack_0(&id_sequence);
+    result.repeat_bounds = gsStack_0(&repeat_bounds);
 
-    for (unsigned i = 0; i < 128; ++i) {
-	char_to_token_table[i] = 0;
-    }
-    unsigned token_counter = REX_c;
-    gsStack tokens_C, tokens_A, tokens_D, tokens_W;
-    gsStack_create_(&tokens_C, sizeof(unsigned));
-    gsStack_create_(&tokens_A, sizeof(unsigned));
-    gsStack_create_(&tokens_D, sizeof(unsigned));
-    gsStack_create_(&tokens_W, sizeof(unsigned));
-    unsigned* id = result.ids;
-    for (unsigned* token = result.tokens; *token != 0; ++token, ++id) {
-	if (*token != REX_c) {
+    /*
+      the tokens are the classes of characters which the regex does not
+      tell apart: each explicit character is apart from all the others,
+      and each class used is apart from its complement
+    */
+    const unsigned num_of_classes = gsStack_length(&classes);
+    const _rexCharClass* const classes_0 = gsStack_0(&classes);
+    /* the explicit characters refine the 2 tokens there are at first, and
+       each class has 2 tokens, so the pairs of tokens are below 2 * 128 */
+    unsigned pair_to_token[2 * 128] = {0};
+    unsigned table[128];
+    char_to_token_table[0] = 0;
+    for (unsigned c = 1; c < 128; ++c) {
+	char_to_token_table[c] = 1;
+    }
+    result.num_of_tokens = 2;
+    boolean has_explicit_chars = false;
+    for (unsigned c = 0; c < 128; ++c) {
+	table[c] = 0;
+    }
+    boolean* const is_class_used = CALLOC(num_of_classes, sizeof(boolean));
+    const unsigned* id = result.ids;
+    for (const unsigned* token = result.tokens; *token != 0; ++token, ++id) {
+	if (*token == REX_c) {
+	    table[*id] = *id;
+	    has_explicit_chars = true;
+	} else if (*token == REX_C || *token == REX_A || *token == REX_D
+		   || *token == REX_W || *token == REX_CLASS) {
+	    is_class_used[_rex_class_of_token(*token, *id)] = true;
+	}
+    }
+    if (has_explicit_chars == true) {
+	result.num_of_tokens =
+	    _rex_refine_char_to_token_table(char_to_token_table, table, 128,
+					    pair_to_token);
+    }
+    for (unsigned i = 0; i < num_of_classes; ++i) {
+	if (is_class_used[i] == false) {
 	    continue;
 	}
-	if (char_to_token_table[*id] == 0) {
-	    char_to_token_table[*id] = token_counter++;
-	}
-	GS_APPEND(&tokens_C, *id, unsigned);
-	if ((*id >= 'a' && *id <= 'z') || (*id >= 'A' && *id <= 'Z')) {
-	    GS_APPEND(&tokens_A, *id, unsigned);
-	} else if (*id >= '0' && *id <= '9') {
-	    GS_APPEND(&tokens_D, *id, unsigned);
-	} else if (*id == ' ' || *id == '\t' || *id == '\n') {
-	    GS_APPEND(&tokens_W, *id, unsigned);
-	}
-    }
-    char_to_token_table[0] = REX_UNDEFINED;
-    for (unsigned i = 1; i < 128; ++i) {
-	if (char_to_token_table[i] == 0) {
-	    if ((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z')) {
-		char_to_token_table[i] = REX_A;
-	    } else if (i >= '0' && i <= '9') {
-		char_to_token_table[i] = REX_D;
-	    } else if (i == ' ' || i == '\t' || i == '\n') {
-		char_to_token_table[i] = REX_W;
-	    } else {
-		char_to_token_table[i] = REX_C;
+	for (unsigned c = 0; c < 128; ++c) {
+	    table[c] = classes_0[i].is_in[c];
+	}
+	result.num_of_tokens =
+	    _rex_refine_char_to_token_table(char_to_token_table, table, 2,
+					    pair_to_token);
+    }
+
+    /* each class used is a union of tokens */
+    gsStack class_tokens;
+    gsStack_create_(&class_tokens, sizeof(unsigned));
+    result.class_tokens_offsets =
+	MALLOC((num_of_classes + 1) * sizeof(*result.class_tokens_offsets));
+    boolean is_token_in[128];
+    for (unsigned i = 0; i < num_of_classes; ++i) {
+	result.class_tokens_offsets[i] = gsStack_length(&class_tokens);
+	if (is_class_used[i] == false) {
+	    continue;
+	}
+	for (unsigned t = 0; t < result.num_of_tokens; ++t) {
+	    is_token_in[t] = false;
+	}
+	for (unsigned c = 1; c < 128; ++c) {
+	    if (classes_0[i].is_in[c] != 0) {
+		is_token_in[char_to_token_table[c]] = true;
+	    }
+	}
+	for (unsigned t = 1; t < result.num_of_tokens; ++t) {
+	    if (is_token_in[t] == true) {
+		GS_APPEND(&class_tokens, t, unsigned);
 	    }
 	}
     }
-    GS_APPEND(&tokens_C, 0, unsigned);
-    GS_APPEND(&tokens_A, 0, unsigned);
-    GS_APPEND(&tokens_D, 0, unsigned);
-    GS_APPEND(&tokens_W, 0, unsigned);
-    result.tokens_C = gsStack_0(&tokens_C);
-    result.tokens_A = gsStack_0(&tokens_A);
-    result.tokens_D = gsStack_0(&tokens_D);
-    result.tokens_W = gsStack_0(&tokens_W);
+    result.class_tokens_offsets[num_of_classes] = gsStack_length(&class_tokens);
+    /* a sentinel, so that the list is allocated even if no class is used */
+    GS_APPEND(&class_tokens, 0, unsigned);
+    result.class_tokens = gsStack_0(&class_tokens);
+    FREE(is_class_used);
+    gsStack_destroy_(&classes);
 
-    result.num_of_tokens = token_counter;
+    return result;
 
+    error_label:;
+    if (out_diagnostic != NULL) {
+	snprintf(out_diagnostic, REX_MAX_DIAGNOSTIC_LENGTH,
+		 "Error compiling regex: could not read it.\n");
+    }
+    diagnosed_error_label:;
+    gsStack_destroy_(&token_sequence);
+    gsStack_destroy_(&id_sequence);
+    gsStack_destroy_(&repeat_bounds);
+    gsStack_destroy_(&classes);
+    result.tokens = NULL;
+    result.ids = NULL;
     return result;
 }
 
 static void _rex_terminal_synth_fn(unsigned token, unsigned val,
 				   void* attribute, void* extra) {
     _rexPreprocessResult* const preprocess_result = extra;
-    faNfa** nfa = attribute;
+    faNfa** nfa = &((_rexAttribute*) attribute)->nfa;
     switch (token) {
         case REX_C:;
-	    *nfa = faNfa_create_token(REX_C);
-	    for (unsigned* t = preprocess_result->tokens_C; *t != 0; ++t) {
-		faNfa_add_edge_(*nfa, 0, 1,
-				preprocess_result->char_to_token_table[*t]);
-	    }
-	    break;
         case REX_A:;
-	    *nfa = faNfa_create_token(REX_A);
-	    for (unsigned* t = preprocess_result->tokens_A; *t != 0; ++t) {
-	        faNfa_add_edge_(*nfa, 0, 1,
-				preprocess_result->char_to_token_table[*t]);
-	    }
-	    break;
         case REX_D:;
-	    *nfa = faNfa_create_token(REX_D);
-	    for (unsigned* t = preprocess_result->tokens_D; *t != 0; ++t) {
-	        faNfa_add_edge_(*nfa, 0, 1,
-				preprocess_result->char_to_token_table[*t]);
-	    }
-	    break;
         case REX_W:;
-	    *nfa = faNfa_create_token(REX_W);
-	    for (unsigned* t = preprocess_result->tokens_W; *t != 0; ++t) {
-	        faNfa_add_edge_(*nfa, 0, 1,
-				preprocess_result->char_to_token_table[*t]);
+        case REX_CLASS:;
+	    /* a single edge for each token of the class */
+	    const unsigned class = _rex_class_of_token(token, val);
+	    *nfa = faNfa_create(2, 0, 1);
+	    for (unsigned i = preprocess_result->class_tokens_offsets[class];
+		 i < preprocess_result->class_tokens_offsets[class+1]; ++i) {
+		faNfa_add_edge_(*nfa, 0, 1, preprocess_result->class_tokens[i]);
 	    }
 	    break;
         case REX_c:;
 	    *nfa =
 		faNfa_create_token(preprocess_result->char_to_token_table[val]);
 	    break;
+        case REX_REPEAT:;
+	    ((_rexAttribute*) attribute)->repeat = val;
+	    break;
         default:;
 	    *nfa = NULL;
     }
     return;
 }
 
+/* a repetition too long to unroll leaves a NULL nfa, failing whatever
+   contains it; returns whether either of the operands failed, destroying
+   the other one if so */
+static boolean _rex_is_either_failed(faNfa* nfa1, faNfa* nfa2) {
+    if (nfa1 != NULL && nfa2 != NULL) {
+	return false;
+    }
+    faNfa_destroy(nfa1);
+    faNfa_destroy(nfa2);
+    return true;
+}
+
 static void _rex_production_synth_fn(unsigned production, void* attributes,
 				     void* extra) {
-    faNfa** nfas = attributes;
+    _rexPreprocessResult* const preprocess_result = extra;
+    _rexAttribute* const results = attributes;
     switch (production) {
         case REX_PR_P:;
-	    *nfas = *(nfas-2);
+	    results[0].nfa = results[-2].nfa;
 	    break;
         case REX_PR_OR:;
-	    *nfas = faNfa_sum__(*(nfas-3), *(nfas-1));
+	    results[0].nfa =
+		(_rex_is_either_failed(results[-3].nfa, results[-1].nfa) == true ?
+		 NULL : faNfa_sum__(results[-3].nfa, results[-1].nfa));
 	    break;
         case REX_PR_AND:;
-	    *nfas = faNfa_prod__(*(nfas-2), *(nfas-1));
+	    results[0].nfa =
+		(_rex_is_either_failed(results[-2].nfa, results[-1].nfa) == true ?
+		 NULL : faNfa_prod__(results[-2].nfa, results[-1].nfa));
 	    break;
         case REX_PR_STAR:;
-	    *nfas = faNfa_star__(*(nfas-2));
+	    results[0].nfa = (results[-2].nfa == NULL ?
+			      NULL : faNfa_star__(results[-2].nfa));
 	    break;
         case REX_PR_PLUS:;
-	    *nfas = faNfa_plus__(*(nfas-2));
+	    results[0].nfa = (results[-2].nfa == NULL ?
+			      NULL : faNfa_plus__(results[-2].nfa));
 	    break;
         case REX_PR_QUESTION:;
-	    *nfas = faNfa_question__(*(nfas-2));
+	    results[0].nfa = (results[-2].nfa == NULL ?
+			      NULL : faNfa_question__(results[-2].nfa));
+	    break;
+        case REX_PR_REPEAT:;
+	    const _rexRepeatBounds* const bounds =
+		preprocess_result->repeat_bounds + results[-1].repeat;
+	    results[0].nfa = (results[-2].nfa == NULL ? NULL :
+			      faNfa_repeat__(results[-2].nfa, bounds->min,
+					     bounds->max,
+					     REX_MAX_REPEAT_NFA_LENGTH));
 	    break;
         default:;
-	    *nfas = *(nfas-1);
+	    results[0] = results[-1];
     }
     return;
 }
 
-rexCompiledRegex* rexCompiledRegex_create_from_regex(const rexRegexSLRParser* regex_slr_parser,
-						     const char* regex,
-						     const char* regex_end) {
-    faDfaOfChars* const self = MALLOC(sizeof(*self));
+static double _rex_seconds_since(clock_t start) {
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* compiles the regex into an nfa whose tokens are given by
+   char_to_token_table (which is filled here),
+   or returns NULL (writing why to out_diagnostic, if given) if the regex
+   could not be parsed or has a repetition too long to unroll;
+   fills the fields of stats (if given) concerning the phases up to the nfa */
+static faNfa* _rex_nfa_create_from_regex(const rexRegexSLRParser* regex_slr_parser,
+					 const char* regex,
+					 const char* regex_end,
+					 unsigned* char_to_token_table,
+					 unsigned* out_num_of_tokens,
+					 rexCompileStats* stats,
+					 char* out_diagnostic) {
+    clock_t start = clock();
     _rexPreprocessResult preprocess_result =
-	rex_preprocess_regex(regex, regex_end,
-			     self->char_to_token_table);
+	rex_preprocess_regex(regex, regex_end, char_to_token_table,
+			     out_diagnostic);
+    if (stats != NULL) {
+	stats->preprocess_time = _rex_seconds_since(start);
+    }
     if (preprocess_result.tokens == NULL) {
-	FREE(self);
 	return NULL;
     }
     preprocess_result.regex_slr_parser = regex_slr_parser;
-    preprocess_result.char_to_token_table = self->char_to_token_table;
+    preprocess_result.char_to_token_table = char_to_token_table;
+    start = clock();
     const unsigned* out_end_point;
     unsigned* parse_items =
 	faDfaBt_parse((faDfaBt*) regex_slr_parser, preprocess_result.tokens,
 		      &out_end_point);
+    if (stats != NULL) {
+	stats->parse_time = _rex_seconds_since(start);
+    }
     if (parse_items == NULL) {
+	if (out_diagnostic != NULL) {
+	    snprintf(out_diagnostic, REX_MAX_DIAGNOSTIC_LENGTH,
+		     "Error compiling regex: could not parse it.\n");
+	}
 	_rexPreprocessResult_destroy_(&preprocess_result);
-	FREE(self);
 	return NULL;
     }
-    faNfa* nfa;
+    start = clock();
+    _rexAttribute result;
     prSLRParser_synthesize((prSLRParser*) regex_slr_parser, parse_items,
-			   preprocess_result.ids, sizeof(faNfa*),
+			   preprocess_result.ids, sizeof(_rexAttribute),
 			   _rex_terminal_synth_fn, _rex_production_synth_fn,
-			   &preprocess_result, &nfa);
+			   &preprocess_result, &result);
+    if (stats != NULL) {
+	stats->synthesize_time = _rex_seconds_since(start);
+    }
+    if (result.nfa == NULL) {
+	if (out_diagnostic != NULL) {
+	    snprintf(out_diagnostic, REX_MAX_DIAGNOSTIC_LENGTH,
+		     "Error compiling regex: a repetition would unroll into "
+		     "more than %u NFA states.\n", REX_MAX_REPEAT_NFA_LENGTH);
+	}
+	FREE(parse_items);
+	_rexPreprocessResult_destroy_(&preprocess_result);
+	return NULL;
+    }
+    if (stats != NULL) {
+	stats->num_of_parse_items = 0;
+	for (const unsigned* item = parse_items; *item != 0; ++item) {
+	    ++stats->num_of_parse_items;
+	}
+	stats->alphabet_size = preprocess_result.num_of_tokens - 1;
+	stats->num_of_nfa_states = faNfa_length(result.nfa);
+	stats->num_of_nfa_edges = 0;
+	stats->num_of_nfa_epsilon_edges = 0;
+	for (unsigned i = 0; i < stats->num_of_nfa_states; ++i) {
+	    const faNfaEdgeList* const edge_list =
+		faNfa_edge_list(result.nfa, i);
+	    const unsigned edge_list_length = faNfaEdgeList_length(edge_list);
+	    stats->num_of_nfa_edges += edge_list_length;
+	    for (unsigned j = 0; j < edge_list_length; ++j) {
+		if (faNfaEdgeList_edge(edge_list, j)->token == 0) {
+		    ++stats->num_of_nfa_epsilon_edges;
+		}
+	    }
+	}
+    }
     FREE(parse_items);
     _rexPreprocessResult_destroy_(&preprocess_result);
+    *out_num_of_tokens = preprocess_result.num_of_tokens;
+    return result.nfa;
+}
+
+rexCompiledRegex* rexCompiledRegex_create_from_regex_with_stats(
+    const rexRegexSLRParser* regex_slr_parser,
+    const char* regex,
+    const char* regex_end,
+    rexCompileStats* out_stats,
+    char* out_diagnostic) {
+    const clock_t start = clock();
+    if (out_stats != NULL) {
+	memset(out_stats, 0, sizeof(*out_stats));
+    }
+    faDfaOfChars* const self = MALLOC(sizeof(*self));
+    unsigned num_of_tokens;
+    faNfa* const nfa =
+	_rex_nfa_create_from_regex(regex_slr_parser, regex, regex_end,
+				   self->char_to_token_table, &num_of_tokens,
+				   out_stats, out_diagnostic);
+    if (nfa == NULL) {
+	FREE(self);
+	if (out_stats != NULL) {
+	    out_stats->total_time = _rex_seconds_since(start);
+	}
+	return NULL;
+    }
+    const clock_t determinize_start = clock();
     faDfa_create_nfaec_(&self->dfa, nfa,
-			unsignedMaybe_from_unsigned(
-			    preprocess_result.num_of_tokens));
+			unsignedMaybe_from_unsigned(num_of_tokens));
     faNfa_destroy(nfa);
+    if (out_stats != NULL) {
+	out_stats->determinize_time = _rex_seconds_since(determinize_start);
+	out_stats->num_of_dfa_states = faDfa_length(&self->dfa);
+	out_stats->table_bytes =
+	    rexCompiledRegex_memory_size((rexCompiledRegex*) self);
+	out_stats->total_time = _rex_seconds_since(start);
+    }
     return (rexCompiledRegex*) self;
 }
 
+rexCompiledRegex* rexCompiledRegex_create_from_regex(const rexRegexSLRParser* regex_slr_parser,
+						     const char* regex,
+						     const char* regex_end) {
+    return rexCompiledRegex_create_from_regex_with_stats(regex_slr_parser,
+							 regex, regex_end,
+							 NULL, NULL);
+}
+
 static char* rex_raw_str_to_regex(const char *str_start, const char *str_end) {
     char* const result = MALLOC(2 * (str_end - str_start) + 1);
     char* cursor = result;
     for (const char* s = str_start; s < str_end; ++s) {
 	if (*s == '(' || *s == ')' || *s == '*' || *s == '+'
-	    || *s == '?' ||  *s == '|' || *s == '\\') {
+	    || *s == '?' ||  *s == '|' || *s == '{' || *s == '}'
+	    || *s == '[' || *s == ']' || *s == '\\') {
 	    *cursor++ = '\\';
 	}
 	*cursor++ = *s;
@@ -379,16 +875,36 @@ static char* rex_raw_str_to_regex(const char *str_start, const char *str_end) {
     return result;
 }
 
-rexCompiledRegex* rexCompiledRegex_create_from_raw_str(const rexRegexSLRParser* regex_slr_parser,
-						       const char *str_start,
-						       const char *str_end) {
+rexCompiledRegex* rexCompiledRegex_create_from_raw_str_with_stats(
+    const rexRegexSLRParser* regex_slr_parser,
+    const char *str_start,
+    const char *str_end,
+    rexCompileStats* out_stats,
+    char* out_diagnostic) {
     char* const regex = rex_raw_str_to_regex(str_start, str_end);
     rexCompiledRegex* const result =
-	rexCompiledRegex_create_from_regex(regex_slr_parser, regex, NULL);
+	rexCompiledRegex_create_from_regex_with_stats(regex_slr_parser,
+						      regex, NULL, out_stats,
+						      out_diagnostic);
     FREE(regex);
     return result;
 }
 
+rexCompiledRegex* rexCompiledRegex_create_from_raw_str(const rexRegexSLRParser* regex_slr_parser,
+						       const char *str_start,
+						       const char *str_end) {
+    return rexCompiledRegex_create_from_raw_str_with_stats(regex_slr_parser,
+							   str_start, str_end,
+							   NULL, NULL);
+}
+
+size_t rexCompiledRegex_memory_size(const rexCompiledRegex* self) {
+    const faDfa* const dfa = &((const faDfaOfChars*) self)->dfa;
+    return sizeof(faDfaOfChars)
+	+ (size_t) dfa->num_of_states * dfa->num_of_tokens * sizeof(unsigned)
+	+ dfa->num_of_states * sizeof(boolean);
+}
+
 boolean rexCompiledRegex_accepts(const rexCompiledRegex* self,
 				 const char* str) {
     return faDfaOfChars_accepts((faDfaOfChars*) self, str);
@@ -402,7 +918,6 @@ void rexCompiledRegexList_destroy(rexCompiledRegexList* self) {
 	rexCompiledRegex_destroy(self->compiled_regexes[i]);
     }
     FREE(self->compiled_regexes);
-    FREE(self->aux);
     FREE(self);
     return;
 }
@@ -410,17 +925,520 @@ void rexCompiledRegexList_destroy(rexCompiledRegexList* self) {
 extern rexCompiledRegexList* rexCompiledRegexList_create_from_compiled_regex_list__(
     unsigned length,
     rexCompiledRegex** compiled_regexes) {
-    rexCompiledRegexList* const self = MALLOC(sizeof(rexCompiledRegexList*));
+    rexCompiledRegexList* const self = MALLOC(sizeof(rexCompiledRegexList));
     self->length = length;
     self->compiled_regexes = compiled_regexes;
-    self->aux = MALLOC(self->length * sizeof(faDfaOfCharsRaceAux));
     return self;
 }
 
+unsigned rexCompiledRegexList_length(const rexCompiledRegexList* self) {
+    return self->length;
+}
+
 unsigned rexCompiledRegexList_race(const rexCompiledRegexList* self,
+				   rexRaceState* state,
 				   const char* str,
 				   const char** out_end_pos) {
+    return rexCompiledRegexList_race_examining(self, state, str, out_end_pos,
+					       NULL);
+}
+
+unsigned rexCompiledRegexList_race_examining(const rexCompiledRegexList* self,
+					     rexRaceState* state,
+					     const char* str,
+					     const char** out_end_pos,
+					     const char** out_examined_end) {
+    /* the race would write past the aux of a state too short */
+    if (state->length < self->length) {
+	if (out_examined_end != NULL) {
+	    *out_examined_end = str;
+	}
+	return self->length;
+    }
     return faDfaOfChars_race(self->length,
 			     (const faDfaOfChars* const*) self->compiled_regexes,
-			     str, self->aux, out_end_pos);
+			     str, state->aux, out_end_pos, out_examined_end);
+}
+
+void rexRaceState_destroy(rexRaceState* self) {
+    FREE(self);
+    return;
+}
+
+rexRaceState* rexRaceState_create(unsigned length) {
+    rexRaceState* const self =
+	MALLOC(sizeof(rexRaceState) + length * sizeof(faDfaOfCharsRaceAux));
+    self->length = length;
+    return self;
+}
+
+void rexCompiledRegexSet_destroy(rexCompiledRegexSet* self) {
+    if (self == NULL) {
+	return;
+    }
+    faDfaOfChars_destroy_(&self->self_as_faDfaOfChars);
+    FREE(self->accept_offsets);
+    FREE(self->accept_list);
+    FREE(self);
+    return;
+}
+
+rexCompiledRegexSet* rexCompiledRegexSet_create_from_regexes(
+    const rexRegexSLRParser* regex_slr_parser,
+    unsigned length,
+    const char* const* regexes) {
+    /* compile each regex into an nfa over its own tokens */
+    faNfa** const nfas = MALLOC((length + 1) * sizeof(*nfas));
+    unsigned (* const tables)[128] = MALLOC((length + 1) * sizeof(*tables));
+    unsigned* const tables_num_of_tokens =
+	MALLOC((length + 1) * sizeof(*tables_num_of_tokens));
+    unsigned max_num_of_tokens = 1;
+    for (unsigned i = 0; i < length; ++i) {
+	nfas[i] = _rex_nfa_create_from_regex(regex_slr_parser, regexes[i], NULL,
+					     tables[i], tables_num_of_tokens + i, NULL,
+					     NULL);
+	if (nfas[i] == NULL) {
+	    for (unsigned j = 0; j < i; ++j) {
+		faNfa_destroy(nfas[j]);
+	    }
+	    FREE(tables_num_of_tokens);
+	    FREE(tables);
+	    FREE(nfas);
+	    return NULL;
+	}
+	if (tables_num_of_tokens[i] > max_num_of_tokens) {
+	    max_num_of_tokens = tables_num_of_tokens[i];
+	}
+    }
+
+    rexCompiledRegexSet* const self = MALLOC(sizeof(*self));
+    self->length = length;
+    faDfaOfChars* const dfa_of_chars = &self->self_as_faDfaOfChars;
+
+    /* the joint tokens are the classes of characters
+       which no regex tells apart */
+    unsigned* const joint_table = dfa_of_chars->char_to_token_table;
+    unsigned num_of_joint_tokens = 2;
+    joint_table[0] = 0;
+    for (unsigned c = 1; c < 128; ++c) {
+	joint_table[c] = 1;
+    }
+    unsigned* const pair_to_token =
+	CALLOC(128 * max_num_of_tokens, sizeof(*pair_to_token));
+    for (unsigned i = 0; i < length; ++i) {
+	num_of_joint_tokens =
+	    _rex_refine_char_to_token_table(joint_table, tables[i],
+					    tables_num_of_tokens[i],
+					    pair_to_token);
+    }
+    FREE(pair_to_token);
+
+    /* the union nfa: a new cosink with epsilon edges to the cosinks of
+       the regexes' nfas, whose edges are translated to joint tokens,
+       and a never reached sink */
+    unsigned union_length = 2;
+    for (unsigned i = 0; i < length; ++i) {
+	union_length += faNfa_length(nfas[i]);
+    }
+    faNfa* const nfa = faNfa_create(union_length, 0, union_length - 1);
+    /* sink_owner[state] is the regex whose sink the state is, or length */
+    unsigned* const sink_owner = MALLOC(union_length * sizeof(*sink_owner));
+    for (unsigned state = 0; state < union_length; ++state) {
+	sink_owner[state] = length;
+    }
+    unsigned char* const is_joint_of_token =
+	MALLOC(max_num_of_tokens * num_of_joint_tokens);
+    unsigned offset = 1;
+    for (unsigned i = 0; i < length; ++i) {
+	memset(is_joint_of_token, 0,
+	       tables_num_of_tokens[i] * num_of_joint_tokens);
+	for (unsigned c = 1; c < 128; ++c) {
+	    is_joint_of_token[tables[i][c] * num_of_joint_tokens
+			      + joint_table[c]] = 1;
+	}
+	const unsigned nfa_length = faNfa_length(nfas[i]);
+	for (unsigned source = 0; source < nfa_length; ++source) {
+	    const faNfaEdgeList* const edge_list =
+		faNfa_edge_list(nfas[i], source);
+	    const unsigned edge_list_length = faNfaEdgeList_length(edge_list);
+	    for (unsigned k = 0; k < edge_list_length; ++k) {
+		const faNfaEdge* const edge = faNfaEdgeList_edge(edge_list, k);
+		if (edge->token == 0) {
+		    faNfa_add_edge_(nfa, offset + source, offset + edge->target,
+				    0);
+		    continue;
+		}
+		const unsigned char* const is_joint =
+		    is_joint_of_token + edge->token * num_of_joint_tokens;
+		for (unsigned t = 1; t < num_of_joint_tokens; ++t) {
+		    if (is_joint[t] != 0) {
+			faNfa_add_edge_(nfa, offset + source,
+					offset + edge->target, t);
+		    }
+		}
+	    }
+	}
+	faNfa_add_edge_(nfa, 0, offset + faNfa_cosink(nfas[i]), 0);
+	sink_owner[offset + faNfa_sink(nfas[i])] = i;
+	offset += nfa_length;
+	faNfa_destroy(nfas[i]);
+    }
+    FREE(is_joint_of_token);
+    FREE(tables_num_of_tokens);
+    FREE(tables);
+    FREE(nfas);
+
+    gsStack subsets;
+    faDfa_create_nfaec_with_subsets_(&dfa_of_chars->dfa, &subsets, nfa,
+				     unsignedMaybe_from_unsigned(
+					 num_of_joint_tokens));
+    faNfa_destroy(nfa);
+
+    /* read off the accepted regexes of every state */
+    const unsigned num_of_states = faDfa_length(&dfa_of_chars->dfa);
+    gsStack accept_list;
+    gsStack_create_(&accept_list, sizeof(unsigned));
+    self->accept_offsets =
+	MALLOC((num_of_states + 1) * sizeof(*self->accept_offsets));
+    for (unsigned i = 0; i < num_of_states; ++i) {
+	const unsigned start = gsStack_length(&accept_list);
+	self->accept_offsets[i] = start;
+	const ssSubset* const subset = gsStack_element(&subsets, i);
+	const unsigned subset_length = ssSubset_length(subset);
+	for (unsigned j = 0; j < subset_length; ++j) {
+	    const unsigned owner = sink_owner[ssSubset_element(subset, j)];
+	    if (owner == length) {
+		continue;
+	    }
+	    /* insert keeping the state's list sorted */
+	    gsStack_pre_append_(&accept_list);
+	    unsigned* const list = gsStack_0(&accept_list);
+	    unsigned k = gsStack_length(&accept_list) - 1;
+	    for (; k > start && list[k-1] > owner; --k) {
+		list[k] = list[k-1];
+	    }
+	    list[k] = owner;
+	}
+	dfa_of_chars->dfa.sinks[i] =
+	    (gsStack_length(&accept_list) != start ? true : false);
+    }
+    self->accept_offsets[num_of_states] = gsStack_length(&accept_list);
+    /* a sentinel, so that the list is allocated even if no state accepts */
+    GS_APPEND(&accept_list, length, unsigned);
+    self->accept_list = gsStack_0(&accept_list);
+    FREE(sink_owner);
+
+    ssSubset* const s0 = gsStack_0(&subsets);
+    for (ssSubset* s = gsStack_end(&subsets); s > s0;) {
+	ssSubset_destroy_(--s);
+    }
+    gsStack_destroy_(&subsets);
+
+    return self;
+}
+
+unsigned rexCompiledRegexSet_length(const rexCompiledRegexSet* self) {
+    return self->length;
+}
+
+unsigned rexCompiledRegexSet_matches(const rexCompiledRegexSet* self,
+				     const char* str,
+				     const unsigned** out_patterns) {
+    const unsigned state =
+	faDfaOfChars_state_after(&self->self_as_faDfaOfChars, str);
+    *out_patterns = self->accept_list + self->accept_offsets[state];
+    return self->accept_offsets[state+1] - self->accept_offsets[state];
+}
+
+#define REX_CACHE_INITIAL_NUM_OF_BUCKETS 64
+
+static size_t _rex_hash_regex(const char* regex, const char* regex_end) {
+    /* FNV-1a */
+    size_t hash = 2166136261u;
+    for (; *regex != 0 && regex != regex_end; ++regex) {
+	hash = (hash ^ (unsigned char) *regex) * 16777619u;
+    }
+    return hash;
+}
+
+static boolean _rex_regex_equal_to(const char* regex, const char* regex_end,
+				   const char* comparand) {
+    for (; *regex != 0 && regex != regex_end; ++regex, ++comparand) {
+	if (*regex != *comparand) {
+	    return false;
+	}
+    }
+    return (*comparand == 0 ? true : false);
+}
+
+static size_t _rex_hash_pointer(const void* pointer) {
+    return (size_t) ((uintptr_t) pointer / sizeof(void*));
+}
+
+static void _rexCompiledRegexCache_lock(const rexCompiledRegexCache* self) {
+    if (self->lock_fn != NULL) {
+	self->lock_fn(self->lock);
+    }
+    return;
+}
+
+static void _rexCompiledRegexCache_unlock(const rexCompiledRegexCache* self) {
+    if (self->unlock_fn != NULL) {
+	self->unlock_fn(self->lock);
+    }
+    return;
+}
+
+static void _rexCompiledRegexCache_lru_remove(rexCompiledRegexCache* self,
+					      _rexCacheEntry* entry) {
+    if (entry->lru_previous != NULL) {
+	entry->lru_previous->lru_next = entry->lru_next;
+    } else {
+	self->lru_first = entry->lru_next;
+    }
+    if (entry->lru_next != NULL) {
+	entry->lru_next->lru_previous = entry->lru_previous;
+    } else {
+	self->lru_last = entry->lru_previous;
+    }
+    entry->lru_previous = NULL;
+    entry->lru_next = NULL;
+    return;
+}
+
+static void _rexCompiledRegexCache_lru_push_first(rexCompiledRegexCache* self,
+						  _rexCacheEntry* entry) {
+    entry->lru_previous = NULL;
+    entry->lru_next = self->lru_first;
+    if (self->lru_first != NULL) {
+	self->lru_first->lru_previous = entry;
+    } else {
+	self->lru_last = entry;
+    }
+    self->lru_first = entry;
+    return;
+}
+
+static void _rexCompiledRegexCache_link(rexCompiledRegexCache* self,
+					_rexCacheEntry* entry) {
+    _rexCacheEntry** const by_regex =
+	self->buckets_by_regex + entry->hash % self->num_of_buckets;
+    entry->next_by_regex = *by_regex;
+    *by_regex = entry;
+    _rexCacheEntry** const by_compiled_regex =
+	self->buckets_by_compiled_regex
+	+ _rex_hash_pointer(entry->compiled_regex) % self->num_of_buckets;
+    entry->next_by_compiled_regex = *by_compiled_regex;
+    *by_compiled_regex = entry;
+    return;
+}
+
+static void _rexCompiledRegexCache_unlink(rexCompiledRegexCache* self,
+					  _rexCacheEntry* entry) {
+    _rexCacheEntry** e =
+	self->buckets_by_regex + entry->hash % self->num_of_buckets;
+    while (*e != entry) {
+	e = &(*e)->next_by_regex;
+    }
+    *e = entry->next_by_regex;
+    e = self->buckets_by_compiled_regex
+	+ _rex_hash_pointer(entry->compiled_regex) % self->num_of_buckets;
+    while (*e != entry) {
+	e = &(*e)->next_by_compiled_regex;
+    }
+    *e = entry->next_by_compiled_regex;
+    return;
+}
+
+static void _rexCompiledRegexCache_rehash(rexCompiledRegexCache* self,
+					  unsigned num_of_buckets) {
+    _rexCacheEntry** const old_buckets = self->buckets_by_regex;
+    const unsigned old_num_of_buckets = self->num_of_buckets;
+    FREE(self->buckets_by_compiled_regex);
+    self->num_of_buckets = num_of_buckets;
+    self->buckets_by_regex =
+	CALLOC(num_of_buckets, sizeof(*self->buckets_by_regex));
+    self->buckets_by_compiled_regex =
+	CALLOC(num_of_buckets, sizeof(*self->buckets_by_compiled_regex));
+    for (unsigned i = 0; i < old_num_of_buckets; ++i) {
+	_rexCacheEntry* entry = old_buckets[i];
+	while (entry != NULL) {
+	    _rexCacheEntry* const next = entry->next_by_regex;
+	    _rexCompiledRegexCache_link(self, entry);
+	    entry = next;
+	}
+    }
+    FREE(old_buckets);
+    return;
+}
+
+static void _rexCompiledRegexCache_evict(rexCompiledRegexCache* self,
+					 _rexCacheEntry* entry) {
+    _rexCompiledRegexCache_lru_remove(self, entry);
+    _rexCompiledRegexCache_unlink(self, entry);
+    self->memory_size -= entry->memory_size;
+    --self->num_of_entries;
+    rexCompiledRegex_destroy(entry->compiled_regex);
+    FREE(entry->regex);
+    FREE(entry);
+    return;
+}
+
+/* evicts the least recently released entries with no references,
+   until the memory size is small enough or there are no such entries */
+static void _rexCompiledRegexCache_shrink(rexCompiledRegexCache* self) {
+    while (self->memory_size > self->max_memory_size
+	   && self->lru_last != NULL) {
+	_rexCompiledRegexCache_evict(self, self->lru_last);
+    }
+    return;
+}
+
+void rexCompiledRegexCache_destroy(rexCompiledRegexCache* self) {
+    if (self == NULL) {
+	return;
+    }
+    for (unsigned i = 0; i < self->num_of_buckets; ++i) {
+	_rexCacheEntry* entry = self->buckets_by_regex[i];
+	while (entry != NULL) {
+	    _rexCacheEntry* const next = entry->next_by_regex;
+	    rexCompiledRegex_destroy(entry->compiled_regex);
+	    FREE(entry->regex);
+	    FREE(entry);
+	    entry = next;
+	}
+    }
+    FREE(self->buckets_by_regex);
+    FREE(self->buckets_by_compiled_regex);
+    FREE(self);
+    return;
+}
+
+rexCompiledRegexCache* rexCompiledRegexCache_create(
+    const rexRegexSLRParser* regex_slr_parser,
+    size_t max_memory_size,
+    rexLockFn lock_fn,
+    rexLockFn unlock_fn,
+    void* lock) {
+    rexCompiledRegexCache* const self = MALLOC(sizeof(*self));
+    self->regex_slr_parser = regex_slr_parser;
+    self->max_memory_size = max_memory_size;
+    self->memory_size = 0;
+    self->lock_fn = lock_fn;
+    self->unlock_fn = unlock_fn;
+    self->lock = lock;
+    self->num_of_entries = 0;
+    self->num_of_buckets = REX_CACHE_INITIAL_NUM_OF_BUCKETS;
+    self->buckets_by_regex =
+	CALLOC(self->num_of_buckets, sizeof(*self->buckets_by_regex));
+    self->buckets_by_compiled_regex =
+	CALLOC(self->num_of_buckets, sizeof(*self->buckets_by_compiled_regex));
+    self->lru_first = NULL;
+    self->lru_last = NULL;
+    return self;
+}
+
+static _rexCacheEntry* _rexCompiledRegexCache_find(const rexCompiledRegexCache* self,
+						   const char* regex,
+						   const char* regex_end,
+						   size_t hash) {
+    _rexCacheEntry* entry =
+	self->buckets_by_regex[hash % self->num_of_buckets];
+    for (; entry != NULL; entry = entry->next_by_regex) {
+	if (entry->hash == hash
+	    && _rex_regex_equal_to(regex, regex_end, entry->regex) == true) {
+	    return entry;
+	}
+    }
+    return NULL;
+}
+
+static void _rexCompiledRegexCache_reference(rexCompiledRegexCache* self,
+					     _rexCacheEntry* entry) {
+    if (entry->num_of_references == 0) {
+	_rexCompiledRegexCache_lru_remove(self, entry);
+    }
+    ++entry->num_of_references;
+    return;
+}
+
+const rexCompiledRegex* rexCompiledRegexCache_acquire(rexCompiledRegexCache* self,
+						      const char* regex,
+						      const char* regex_end) {
+    const size_t hash = _rex_hash_regex(regex, regex_end);
+
+    _rexCompiledRegexCache_lock(self);
+    _rexCacheEntry* entry =
+	_rexCompiledRegexCache_find(self, regex, regex_end, hash);
+    if (entry != NULL) {
+	_rexCompiledRegexCache_reference(self, entry);
+	_rexCompiledRegexCache_unlock(self);
+	return entry->compiled_regex;
+    }
+    _rexCompiledRegexCache_unlock(self);
+
+    /* compile without holding the lock */
+    rexCompiledRegex* const compiled_regex =
+	rexCompiledRegex_create_from_regex(self->regex_slr_parser,
+					   regex, regex_end);
+    if (compiled_regex == NULL) {
+	return NULL;
+    }
+
+    _rexCompiledRegexCache_lock(self);
+    /* someone may have compiled the same regex meanwhile */
+    entry = _rexCompiledRegexCache_find(self, regex, regex_end, hash);
+    if (entry != NULL) {
+	_rexCompiledRegexCache_reference(self, entry);
+	_rexCompiledRegexCache_unlock(self);
+	rexCompiledRegex_destroy(compiled_regex);
+	return entry->compiled_regex;
+    }
+    entry = MALLOC(sizeof(*entry));
+    entry->regex =
+	(regex_end == NULL ? str_create_copy(regex)
+	 : str_create_copy_from_to(regex, regex_end));
+    entry->hash = hash;
+    entry->compiled_regex = compiled_regex;
+    entry->memory_size = rexCompiledRegex_memory_size(compiled_regex);
+    entry->num_of_references = 1;
+    entry->lru_previous = NULL;
+    entry->lru_next = NULL;
+    if (self->num_of_entries >= 2 * self->num_of_buckets) {
+	_rexCompiledRegexCache_rehash(self, 2 * self->num_of_buckets);
+    }
+    _rexCompiledRegexCache_link(self, entry);
+    ++self->num_of_entries;
+    self->memory_size += entry->memory_size;
+    _rexCompiledRegexCache_shrink(self);
+    _rexCompiledRegexCache_unlock(self);
+    return compiled_regex;
+}
+
+void rexCompiledRegexCache_release(rexCompiledRegexCache* self,
+				   const rexCompiledRegex* compiled_regex) {
+    if (compiled_regex == NULL) {
+	return;
+    }
+    _rexCompiledRegexCache_lock(self);
+    _rexCacheEntry* entry =
+	self->buckets_by_compiled_regex[_rex_hash_pointer(compiled_regex)
+					% self->num_of_buckets];
+    while (entry->compiled_regex != compiled_regex) {
+	entry = entry->next_by_compiled_regex;
+    }
+    --entry->num_of_references;
+    if (entry->num_of_references == 0) {
+	_rexCompiledRegexCache_lru_push_first(self, entry);
+	_rexCompiledRegexCache_shrink(self);
+    }
+    _rexCompiledRegexCache_unlock(self);
+    return;
+}
+
+size_t rexCompiledRegexCache_memory_size(const rexCompiledRegexCache* self) {
+    _rexCompiledRegexCache_lock(self);
+    const size_t memory_size = self->memory_size;
+    _rexCompiledRegexCache_unlock(self);
+    return memory_size;
 }
@@ -0,0 +1,193 @@
+/* generated by tools/prgen from the regex meta-grammar; do not edit */
+
+static const boolean rex_tables_sinks[] = {
+    false, false, true, false, false, false, false, false,
+    false, false, false, false, false, false, false, false,
+    false, false, false, false, false, false, false, false,
+    false, false, false, false, false, false, false, false,
+    false, false, false, false, false, false, false, false,
+    false, false, false, false, false, false, false, false,
+    false, false, false,
+};
+
+static const unsigned rex_tables_transition_table[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 24, 25, 26, 27,
+    28, 6, 0, 0, 0, 0, 0, 0, 29, 3, 22, 23,
+    2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 13, 0, 0, 0,
+    0, 0, 0, 0, 0, 30, 31, 32, 33, 34, 6, 0,
+    0, 0, 0, 0, 0, 35, 0, 0, 14, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 15, 16, 17, 0, 18,
+    0, 0, 0, 0, 0, 0, 0, 38, 39, 40, 41, 42,
+    6, 0, 0, 0, 0, 0, 0, 43, 19, 36, 37, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 45, 46, 47, 48,
+    49, 6, 0, 0, 0, 0, 0, 0, 50, 0, 20, 44,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 16,
+    17, 0, 18, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 21, 0, 0, 0,
+    13, 0, 0, 0, 0, 0, 0, 0, 0, 30, 31, 32,
+    33, 34, 6, 0, 0, 0, 0, 0, 0, 35, 0, 0,
+    14, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 30,
+    31, 32, 33, 34, 6, 0, 0, 0, 0, 13, 0, 35,
+    0, 0, 14, 0, 0, 0, 30, 31, 32, 33, 34, 6,
+    0, 15, 16, 17, 13, 18, 35, 0, 0, 14, 0, 0,
+    0, 30, 31, 32, 33, 34, 6, 0, 15, 16, 17, 13,
+    18, 35, 0, 0, 14, 0, 0, 0, 30, 31, 32, 33,
+    34, 6, 0, 15, 16, 17, 13, 18, 35, 0, 0, 14,
+    0, 0, 0, 30, 31, 32, 33, 34, 6, 0, 15, 16,
+    17, 13, 18, 35, 0, 0, 14, 0, 0, 0, 30, 31,
+    32, 33, 34, 6, 0, 15, 16, 17, 13, 18, 35, 0,
+    0, 14, 0, 0, 0, 30, 31, 32, 33, 34, 6, 0,
+    15, 16, 17, 13, 18, 35, 0, 0, 14, 0, 0, 0,
+    30, 31, 32, 33, 34, 6, 0, 15, 16, 17, 13, 18,
+    35, 0, 0, 14, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 15, 16, 17, 0, 18, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 16, 17,
+    0, 18, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 15, 16, 17, 0, 18, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 15,
+    16, 17, 0, 18, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 15, 16, 17, 0, 18, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 15, 16, 17, 0, 18, 0, 0, 0, 0, 0, 0,
+    0, 30, 31, 32, 33, 34, 6, 21, 0, 0, 0, 13,
+    0, 35, 0, 0, 14, 0, 0, 0, 30, 31, 32, 33,
+    34, 6, 21, 15, 16, 17, 13, 18, 35, 0, 0, 14,
+    0, 0, 0, 30, 31, 32, 33, 34, 6, 21, 15, 16,
+    17, 13, 18, 35, 0, 0, 14, 0, 0, 0, 30, 31,
+    32, 33, 34, 6, 21, 15, 16, 17, 13, 18, 35, 0,
+    0, 14, 0, 0, 0, 30, 31, 32, 33, 34, 6, 21,
+    15, 16, 17, 13, 18, 35, 0, 0, 14, 0, 0, 0,
+    30, 31, 32, 33, 34, 6, 21, 15, 16, 17, 13, 18,
+    35, 0, 0, 14, 0, 0, 0, 30, 31, 32, 33, 34,
+    6, 21, 15, 16, 17, 13, 18, 35, 0, 0, 14, 0,
+    0, 0, 30, 31, 32, 33, 34, 6, 21, 15, 16, 17,
+    13, 18, 35, 0, 0, 14, 0, 0, 0, 30, 31, 32,
+    33, 34, 6, 0, 15, 16, 17, 0, 18, 35, 0, 0,
+    14, 0, 0, 0, 30, 31, 32, 33, 34, 6, 0, 15,
+    16, 17, 0, 18, 35, 0, 0, 14, 0, 0, 0, 30,
+    31, 32, 33, 34, 6, 0, 15, 16, 17, 0, 18, 35,
+    0, 0, 14, 0, 0, 0, 30, 31, 32, 33, 34, 6,
+    0, 15, 16, 17, 0, 18, 35, 0, 0, 14, 0, 0,
+    0, 30, 31, 32, 33, 34, 6, 0, 15, 16, 17, 0,
+    18, 35, 0, 0, 14, 0, 0, 0, 30, 31, 32, 33,
+    34, 6, 0, 15, 16, 17, 0, 18, 35, 0, 0, 14,
+    0, 0, 0, 30, 31, 32, 33, 34, 6, 0, 15, 16,
+    17, 0, 18, 35, 0, 0, 14, 0, 0,
+};
+
+static const unsigned rex_tables_bt_table[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 3,
+    0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 4,
+    4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 4, 0,
+    4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 0, 0, 0, 0, 0, 12, 12, 12, 12,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 0, 0,
+    0, 0, 0, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+    13, 13, 13, 13, 13, 0, 0, 0, 0, 0, 14, 14,
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+    0, 0, 0, 0, 0, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 0, 0, 0, 0, 0,
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+    17, 17, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0,
+    0, 7, 0, 7, 0, 0, 0, 0, 0, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 0,
+    0, 0, 0, 0, 9, 9, 9, 9, 9, 9, 9, 9,
+    9, 9, 9, 9, 9, 9, 0, 0, 0, 0, 0, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 0, 0, 0, 0, 0, 16, 16, 16, 16, 16, 16,
+    16, 16, 16, 16, 16, 16, 16, 16, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0,
+    0, 0, 0, 6, 0, 0, 0, 6, 0, 0, 0, 0,
+    0, 0, 0, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 0, 0, 0, 0, 0, 2, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 7, 7, 7, 7, 7, 7,
+    7, 7, 0, 0, 0, 7, 0, 7, 0, 0, 0, 0,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0,
+    7, 0, 7, 0, 0, 0, 0, 0, 7, 7, 7, 7,
+    7, 7, 7, 7, 0, 0, 0, 7, 0, 7, 0, 0,
+    0, 0, 0, 7, 7, 7, 7, 7, 7, 7, 7, 0,
+    0, 0, 7, 0, 7, 0, 0, 0, 0, 0, 7, 7,
+    7, 7, 7, 7, 7, 7, 0, 0, 0, 7, 0, 7,
+    0, 0, 0, 0, 0, 7, 7, 7, 7, 7, 7, 7,
+    7, 0, 0, 0, 7, 0, 7, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0,
+    0, 0, 0, 6, 0, 0, 0, 6, 0, 0, 0, 0,
+    0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 6, 0,
+    0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 6, 0,
+    0, 0, 0, 0, 0, 6, 0, 0, 0, 6, 0, 0,
+    0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0,
+    6, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0,
+    6, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 6,
+    0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0,
+    0, 0, 6, 0, 0, 0, 6, 0, 0, 0, 0, 0,
+    0, 0, 6, 0, 0, 0, 0, 0, 0, 6, 0, 0,
+    0, 6, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const unsigned rex_tables_bt_list[] = {
+    1, 18, 1, 17, 1, 14, 1, 15, 3, 16, 3, 14,
+    2, 15, 2, 16, 2, 16, 2, 16, 1, 16, 1, 16,
+    1, 16, 1, 16, 1, 16, 2, 16, 1, 16,
+};
+
+static const prSLRParserTables rex_tables = {
+    51, 19, 1, 0, 17,
+    rex_tables_sinks,
+    rex_tables_transition_table,
+    rex_tables_bt_table,
+    rex_tables_bt_list
+};
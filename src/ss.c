@@ -2,12 +2,42 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <limits.h> /* for CHAR_BIT */
+#include <stdint.h>
 
 #include "standard.h"
 #include "ma.h"
 #include "gs.h"
 
+#define SS_WORD_BITS 64
+
+static unsigned _ss_num_of_words(unsigned containing_set_length) {
+    return containing_set_length / SS_WORD_BITS + 1;
+}
+
+static uint64_t _ss_bit(unsigned element) {
+    return (uint64_t) 1 << (element % SS_WORD_BITS);
+}
+
+/* the index of the lowest set bit of word, which should be nonzero,
+   by the de Bruijn sequence trick */
+static unsigned _ss_lowest_bit_index(uint64_t word) {
+    static const unsigned char table[64] = {
+	0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28,
+	62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+	63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+	51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12
+    };
+    return table[((word & (~word + 1)) * UINT64_C(0x022fdd63cc95386d)) >> 58];
+}
+
+static unsigned _ss_popcount(uint64_t word) {
+    word = word - ((word >> 1) & UINT64_C(0x5555555555555555));
+    word = (word & UINT64_C(0x3333333333333333))
+	+ ((word >> 2) & UINT64_C(0x3333333333333333));
+    word = (word + (word >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+    return (unsigned) ((word * UINT64_C(0x0101010101010101)) >> 56);
+}
+
 unsigned ssSubset_length(const ssSubset* self) {
     return gsStack_length(&self->elements_list);
 }
@@ -21,8 +51,13 @@ boolean ssSubset_is_nonempty(const ssSubset* self) {
 }
 
 boolean ssSubset_is_in(const ssSubset* self, unsigned element) {
-    return (self->elements_bitmask[element / CHAR_BIT]
-	    & (1<<(element % CHAR_BIT)) ? true : false);
+    if (self->elements_positions != NULL) {
+	const unsigned position = self->elements_positions[element];
+	return (position < ssSubset_length(self)
+		&& ssSubset_element(self, position) == element ? true : false);
+    }
+    return (self->elements_bitmask[element / SS_WORD_BITS] & _ss_bit(element)
+	    ? true : false);
 }
 
 void ssSubset_destroy_(ssSubset *self) {
@@ -31,6 +66,7 @@ void ssSubset_destroy_(ssSubset *self) {
     }
     gsStack_destroy_(&self->elements_list);
     FREE(self->elements_bitmask);
+    FREE(self->elements_positions);
     return;
 }
 
@@ -46,10 +82,10 @@ void ssSubset_destroy(ssSubset* self) {
 void ssSubset_create_(ssSubset* self, unsigned containing_set_length) {
     self->containing_set_length = containing_set_length;
     gsStack_create_(&self->elements_list, sizeof(unsigned));
-    const unsigned bitmask_size_to_allocate =
-	containing_set_length / CHAR_BIT + 1;
     self->elements_bitmask =
-	CALLOC(bitmask_size_to_allocate, sizeof(*self->elements_bitmask));
+	CALLOC(_ss_num_of_words(containing_set_length),
+	       sizeof(*self->elements_bitmask));
+    self->elements_positions = NULL;
     return;
 }
 
@@ -59,20 +95,85 @@ ssSubset* ssSubset_create(unsigned containing_set_length) {
     return self;
 }
 
+void ssSubset_create_sparse_(ssSubset* self, unsigned containing_set_length) {
+    self->containing_set_length = containing_set_length;
+    gsStack_create_(&self->elements_list, sizeof(unsigned));
+    self->elements_bitmask = NULL;
+    /* the positions need no initialization really, but reading
+       uninitialized memory is undefined behaviour... */
+    self->elements_positions =
+	CALLOC(containing_set_length + 1, sizeof(*self->elements_positions));
+    return;
+}
+
 boolean ssSubset_are_equal(const ssSubset *s1, const ssSubset *s2) {
     if (s1->containing_set_length != s2->containing_set_length) {
 	return false;
     }
-    const unsigned bitmask_size = s1->containing_set_length / CHAR_BIT + 1;
-    return (memcmp(s1->elements_bitmask, s2->elements_bitmask, bitmask_size)
-	    == 0 ? true : false);
+    if (s1->elements_bitmask != NULL && s2->elements_bitmask != NULL) {
+	return (memcmp(s1->elements_bitmask, s2->elements_bitmask,
+		       _ss_num_of_words(s1->containing_set_length)
+		       * sizeof(*s1->elements_bitmask))
+		== 0 ? true : false);
+    }
+    const unsigned length = ssSubset_length(s1);
+    if (length != ssSubset_length(s2)) {
+	return false;
+    }
+    for (unsigned i = 0; i < length; ++i) {
+	if (ssSubset_is_in(s2, ssSubset_element(s1, i)) == false) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+size_t ssSubset_hash(const ssSubset* self) {
+    const unsigned num_of_words = _ss_num_of_words(self->containing_set_length);
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (unsigned i = 0; i < num_of_words; ++i) {
+	hash = (hash ^ self->elements_bitmask[i]) * UINT64_C(0x100000001b3);
+	hash ^= hash >> 29;
+    }
+    return (size_t) hash;
+}
+
+unsigned ssSubset_intersection_length(const ssSubset* s1, const ssSubset* s2) {
+    unsigned result = 0;
+    if (s1->elements_bitmask != NULL && s2->elements_bitmask != NULL) {
+	const unsigned num_of_words =
+	    _ss_num_of_words(s1->containing_set_length);
+	for (unsigned i = 0; i < num_of_words; ++i) {
+	    result +=
+		_ss_popcount(s1->elements_bitmask[i] & s2->elements_bitmask[i]);
+	}
+	return result;
+    }
+    const unsigned length = ssSubset_length(s1);
+    for (unsigned i = 0; i < length; ++i) {
+	if (ssSubset_is_in(s2, ssSubset_element(s1, i)) == true) {
+	    ++result;
+	}
+    }
+    return result;
 }
 
 void ssSubset_make_empty_(ssSubset* self) {
-    gsStack_make_empty_(&self->elements_list);
-    for (unsigned i = 0; i < self->containing_set_length / CHAR_BIT + 1; ++i) {
-	self->elements_bitmask[i] = 0;
+    if (self->elements_bitmask != NULL) {
+	const unsigned num_of_words =
+	    _ss_num_of_words(self->containing_set_length);
+	const unsigned length = ssSubset_length(self);
+	if (length < num_of_words) {
+	    for (unsigned i = 0; i < length; ++i) {
+		self->elements_bitmask[ssSubset_element(self, i)
+				       / SS_WORD_BITS] = 0;
+	    }
+	} else {
+	    memset(self->elements_bitmask, 0,
+		   num_of_words * sizeof(*self->elements_bitmask));
+	}
     }
+    gsStack_make_empty_(&self->elements_list);
     return;
 }
 
@@ -80,8 +181,99 @@ boolean ssSubset_add_(ssSubset* self, unsigned element) {
     if (ssSubset_is_in(self, element) == true) {
 	return true;
     }
+    if (self->elements_positions != NULL) {
+	self->elements_positions[element] = ssSubset_length(self);
+    } else {
+	self->elements_bitmask[element / SS_WORD_BITS] |= _ss_bit(element);
+    }
     GS_APPEND(&(self->elements_list), element, unsigned);
-    self->elements_bitmask[element / CHAR_BIT] =
-	self->elements_bitmask[element / CHAR_BIT] | (1<<(element % CHAR_BIT));
     return false;
 }
+
+boolean ssSubset_add_subset_(ssSubset* self, const ssSubset* subset) {
+    boolean got_something_new = false;
+    if (self->elements_bitmask != NULL && subset->elements_bitmask != NULL) {
+	const unsigned num_of_words =
+	    _ss_num_of_words(self->containing_set_length);
+	for (unsigned i = 0; i < num_of_words; ++i) {
+	    uint64_t new_bits =
+		subset->elements_bitmask[i] & ~self->elements_bitmask[i];
+	    if (new_bits == 0) {
+		continue;
+	    }
+	    got_something_new = true;
+	    self->elements_bitmask[i] |= new_bits;
+	    while (new_bits != 0) {
+		GS_APPEND(&self->elements_list,
+			  i * SS_WORD_BITS + _ss_lowest_bit_index(new_bits),
+			  unsigned);
+		new_bits &= new_bits - 1;
+	    }
+	}
+	return got_something_new;
+    }
+    const unsigned length = ssSubset_length(subset);
+    for (unsigned i = 0; i < length; ++i) {
+	if (ssSubset_add_(self, ssSubset_element(subset, i)) == false) {
+	    got_something_new = true;
+	}
+    }
+    return got_something_new;
+}
+
+/* keeps in self the elements for which being in subset is as given;
+   if both are dense, the bitmask is filtered a word at a time, and the
+   list of elements only if a bit was cleared, by the filtered bitmask */
+static void _ssSubset_filter_(ssSubset* self, const ssSubset* subset,
+			      boolean in_subset) {
+    unsigned* const elements = gsStack_0(&self->elements_list);
+    const unsigned length = ssSubset_length(self);
+    unsigned new_length = 0;
+    if (self->elements_bitmask != NULL && subset->elements_bitmask != NULL) {
+	const unsigned num_of_words =
+	    _ss_num_of_words(self->containing_set_length);
+	boolean is_cleared = false;
+	for (unsigned i = 0; i < num_of_words; ++i) {
+	    const uint64_t word = self->elements_bitmask[i]
+		& (in_subset == true ? subset->elements_bitmask[i]
+		   : ~subset->elements_bitmask[i]);
+	    is_cleared = is_cleared || word != self->elements_bitmask[i];
+	    self->elements_bitmask[i] = word;
+	}
+	if (is_cleared == false) {
+	    return;
+	}
+	for (unsigned i = 0; i < length; ++i) {
+	    const unsigned element = elements[i];
+	    if (self->elements_bitmask[element / SS_WORD_BITS]
+		& _ss_bit(element)) {
+		elements[new_length++] = element;
+	    }
+	}
+	gsStack_post_pop_several_(&self->elements_list, length - new_length);
+	return;
+    }
+    for (unsigned i = 0; i < length; ++i) {
+	const unsigned element = elements[i];
+	if (ssSubset_is_in(subset, element) == in_subset) {
+	    if (self->elements_positions != NULL) {
+		self->elements_positions[element] = new_length;
+	    }
+	    elements[new_length++] = element;
+	} else if (self->elements_bitmask != NULL) {
+	    self->elements_bitmask[element / SS_WORD_BITS] &= ~_ss_bit(element);
+	}
+    }
+    gsStack_post_pop_several_(&self->elements_list, length - new_length);
+    return;
+}
+
+void ssSubset_intersect_(ssSubset* self, const ssSubset* subset) {
+    _ssSubset_filter_(self, subset, true);
+    return;
+}
+
+void ssSubset_subtract_(ssSubset* self, const ssSubset* subset) {
+    _ssSubset_filter_(self, subset, false);
+    return;
+}
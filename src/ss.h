@@ -1,6 +1,9 @@
 #ifndef SS_HEADER
 #define SS_HEADER
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "standard.h"
 #include "gs.h"
 
@@ -11,6 +14,11 @@
  * Finding whether an element lies in the subset is O(1)
  * (but the storage cost of the subset is O(containing_set_length)
  * rather than O(the length of the subset)).
+ * A subset is either dense, kept as a bitmask of 64-bit words (so that
+ * the operations between two subsets go a word at a time), or sparse,
+ * kept as in Briggs & Torczon, "An efficient representation for sparse
+ * sets" (so that emptying it is O(1), handy for scratch subsets).
+ * In both cases the elements are also listed, in the order they were added.
  */
 
 /*-------------------------*/
@@ -25,7 +33,12 @@ typedef struct ssSubset {
         /* the subset is of the set [0, ..., containing_set_length-1] */
         unsigned containing_set_length;
         gsStack elements_list;
-        unsigned char* elements_bitmask;
+        /* NULL if sparse */
+        uint64_t* elements_bitmask;
+        /* NULL if dense; otherwise element is in the subset
+           iff it lies in elements_list at the position
+           elements_positions[element] */
+        unsigned* elements_positions;
 }                       ssSubset;
 
 /*-------------------------*/
@@ -42,12 +55,38 @@ extern  void            ssSubset_destroy(ssSubset *self);
 extern  void            ssSubset_create_(ssSubset *self,
 					 unsigned containing_set_length);
 extern  ssSubset*       ssSubset_create(unsigned containing_set_length);
+extern  void            ssSubset_create_sparse_(ssSubset *self,
+						unsigned containing_set_length);
 
 /* considered not equal if containing_set_length differ */
 extern  boolean         ssSubset_are_equal(const ssSubset* s1,
 					   const ssSubset* s2);
+/* only for dense subsets; equal subsets have equal hashes */
+extern  size_t          ssSubset_hash(const ssSubset* self);
+/* the number of elements in both, of the same containing set;
+   a popcount a word at a time if both are dense */
+extern  unsigned        ssSubset_intersection_length(const ssSubset* s1,
+						     const ssSubset* s2);
 
+/* O(length) if dense (at worst O(containing_set_length/64)),
+   O(1) if sparse */
 extern  void            ssSubset_make_empty_(ssSubset* self);
+/* returns whether element was already in */
 extern  boolean         ssSubset_add_(ssSubset *self, unsigned element);
 
+/* the functions in this group take subsets of the same containing set,
+   and go a word at a time if both are dense (the elements left keep
+   their order) */
+
+/* adds the elements of subset to self;
+   returns whether anything new was added */
+extern  boolean         ssSubset_add_subset_(ssSubset* self,
+					     const ssSubset* subset);
+/* keeps in self only the elements of subset */
+extern  void            ssSubset_intersect_(ssSubset* self,
+					    const ssSubset* subset);
+/* removes from self the elements of subset */
+extern  void            ssSubset_subtract_(ssSubset* self,
+					   const ssSubset* subset);
+
 #endif /* SS_HEADER */
@@ -0,0 +1,157 @@
+#include <stdio.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "../src/ss.h"
+
+/* checks the operations between two subsets, dense or sparse, against
+   arrays of booleans, on random subsets */
+
+#define MAX_CONTAINING_SET_LENGTH 200
+#define NUM_OF_ROUNDS 50
+
+/* a linear congruential generator, so that the subsets are the same
+   from run to run */
+unsigned next_random(unsigned* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+void create_subset_(ssSubset* self, boolean is_sparse,
+                    unsigned containing_set_length) {
+    if (is_sparse == true) {
+        ssSubset_create_sparse_(self, containing_set_length);
+    } else {
+        ssSubset_create_(self, containing_set_length);
+    }
+    return;
+}
+
+/* adds about one in every density elements, in a random order */
+void add_random_elements_(ssSubset* self, unsigned density, unsigned* seed) {
+    const unsigned containing_set_length = self->containing_set_length;
+    for (unsigned i = 0; i < containing_set_length / density + 1; ++i) {
+        ssSubset_add_(self, next_random(seed) % containing_set_length);
+    }
+    return;
+}
+
+/* adds the elements of subset to self one at a time, so that they are
+   listed in the same order */
+void add_elements_(ssSubset* self, const ssSubset* subset) {
+    for (unsigned i = 0; i < ssSubset_length(subset); ++i) {
+        ssSubset_add_(self, ssSubset_element(subset, i));
+    }
+    return;
+}
+
+/* whether self holds just the elements of expected, listing them in
+   the order in which original does */
+boolean is_subset_as_expected(const ssSubset* self, const boolean* expected,
+                              const ssSubset* original) {
+    unsigned length = 0;
+    for (unsigned i = 0; i < ssSubset_length(original); ++i) {
+        const unsigned element = ssSubset_element(original, i);
+        if (expected[element] == true) {
+            if (length >= ssSubset_length(self)
+                || ssSubset_element(self, length) != element) {
+                return false;
+            }
+            ++length;
+        }
+    }
+    if (length != ssSubset_length(self)) {
+        return false;
+    }
+    for (unsigned element = 0; element < self->containing_set_length;
+         ++element) {
+        if (ssSubset_is_in(self, element) != expected[element]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* returns the number of failures */
+unsigned test_operations(boolean is_sparse, boolean is_other_sparse,
+                         unsigned containing_set_length, unsigned* seed) {
+    unsigned num_of_failures = 0;
+    ssSubset subset;
+    ssSubset other;
+    ssSubset result;
+    create_subset_(&subset, is_sparse, containing_set_length);
+    create_subset_(&other, is_other_sparse, containing_set_length);
+    create_subset_(&result, is_sparse, containing_set_length);
+    add_random_elements_(&subset, 1 + next_random(seed) % 4, seed);
+    add_random_elements_(&other, 1 + next_random(seed) % 4, seed);
+
+    boolean is_in_both[MAX_CONTAINING_SET_LENGTH];
+    boolean is_in_first_only[MAX_CONTAINING_SET_LENGTH];
+    unsigned intersection_length = 0;
+    for (unsigned element = 0; element < containing_set_length; ++element) {
+        is_in_both[element] = ssSubset_is_in(&subset, element) == true
+            && ssSubset_is_in(&other, element) == true;
+        is_in_first_only[element] = ssSubset_is_in(&subset, element) == true
+            && ssSubset_is_in(&other, element) == false;
+        if (is_in_both[element] == true) {
+            ++intersection_length;
+        }
+    }
+    if (ssSubset_intersection_length(&subset, &other) != intersection_length
+        || ssSubset_intersection_length(&other, &subset)
+        != intersection_length) {
+        printf("The intersection length of subsets of %u was wrong.\n",
+               containing_set_length);
+        ++num_of_failures;
+    }
+
+    add_elements_(&result, &subset);
+    ssSubset_intersect_(&result, &other);
+    if (is_subset_as_expected(&result, is_in_both, &subset) == false) {
+        printf("The intersection of subsets of %u was wrong.\n",
+               containing_set_length);
+        ++num_of_failures;
+    }
+    ssSubset_make_empty_(&result);
+    add_elements_(&result, &subset);
+    ssSubset_subtract_(&result, &other);
+    if (is_subset_as_expected(&result, is_in_first_only, &subset) == false) {
+        printf("The difference of subsets of %u was wrong.\n",
+               containing_set_length);
+        ++num_of_failures;
+    }
+    ssSubset_subtract_(&result, &result);
+    if (ssSubset_is_nonempty(&result) == true) {
+        printf("A subset of %u minus itself was not empty.\n",
+               containing_set_length);
+        ++num_of_failures;
+    }
+
+    ssSubset_destroy_(&result);
+    ssSubset_destroy_(&other);
+    ssSubset_destroy_(&subset);
+    return num_of_failures;
+}
+
+int main(void) {
+    ma_initialize();
+
+    /* around the word boundaries, and past a few words */
+    const unsigned containing_set_lengths[] = {1, 63, 64, 65, 128, 200};
+    unsigned seed = 1;
+    unsigned num_of_failures = 0;
+    for (unsigned round = 0; round < NUM_OF_ROUNDS; ++round) {
+        for (unsigned i = 0; i < 6; ++i) {
+            for (unsigned kinds = 0; kinds < 4; ++kinds) {
+                num_of_failures +=
+                    test_operations(kinds & 1 ? true : false,
+                                    kinds & 2 ? true : false,
+                                    containing_set_lengths[i], &seed);
+            }
+        }
+    }
+    printf("%u of the checks failed.\n", num_of_failures);
+
+    ma_finalize();
+    return 0;
+}
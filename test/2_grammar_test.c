@@ -11,7 +11,10 @@ int main(void) {
     char file_name[1024];
     const char* example_file_name = "example.grm";
     printf("Enter a grammar specification file name "
-	   "(or something starting with @ for %s):\n", example_file_name);
+	   "(or something starting with @ for %s;\n"
+	   "example_lalr.grm is LALR but not SLR, example_prec.grm\n"
+	   "has its conflicts resolved by precedences, and example_ebnf.grm\n"
+	   "has lists, options and groups):\n", example_file_name);
     fgets(file_name, 1024, stdin);
     str_remove_trailing_newline_(file_name);
     if (file_name[0] == '@') {
@@ -38,14 +41,26 @@ int main(void) {
 
     prGrammar_print(grammar);
 
+    prSLRParserReport report;
     prSLRParser* parser =
-	prSLRParser_create_from_grammar(grammar, diagnostic);
+	prSLRParser_create_with_report(grammar, false, &report, diagnostic);
+    prSLRParserReport_print(&report, grammar);
+    prSLRParserReport_destroy_(&report);
     if (parser == NULL) {
 	printf("%s", diagnostic);
+	parser = prSLRParser_create_with_report(grammar, true, &report,
+						diagnostic);
+	prSLRParserReport_print(&report, grammar);
+	prSLRParserReport_destroy_(&report);
+	if (parser == NULL) {
+	    printf("%s", diagnostic);
+	} else {
+	    printf("The grammar is LALR.\n");
+	}
     } else {
 	printf("The grammar is SLR.\n");
     }
-    
+
     prSLRParser_destroy(parser);
     prGrammar_destroy(grammar);
     end_label:;
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "str.h"
+#include "regex.h"
+
+int main(void) {
+    ma_initialize();
+
+    const char* const regexes[] = {
+	"\\d+",
+	"\\d+(.\\d+)?",
+	"\\a\\w*",
+	"(\\a|\\d)+",
+	"\\c*.\\c*",
+	"ab*c"
+    };
+    const unsigned length = sizeof(regexes) / sizeof(*regexes);
+
+    printf("Creating the regex SLR parser.\n");
+
+    rexRegexSLRParser* regex_parser = rexRegexSLRParser_create();
+
+    if (regex_parser == NULL) {
+	printf("The regex SLR parser creation failed.\n");
+	goto end_label_0;
+    }
+
+    printf("Compiling the following regexes into a single DFA:\n");
+    for (unsigned i = 0; i < length; ++i) {
+	printf("  (%u) %s\n", i, regexes[i]);
+    }
+
+    rexCompiledRegexSet* regex_set =
+	rexCompiledRegexSet_create_from_regexes(regex_parser, length, regexes);
+
+    if (regex_set == NULL) {
+	printf("Failed to compile the regexes.\n");
+	goto end_label_1;
+    }
+
+    char string[1024];
+    printf("Enter a string (for example, 12.5):\n");
+    fgets(string, 1024, stdin);
+    str_remove_trailing_newline_(string);
+
+    const unsigned* patterns;
+    const unsigned num_of_patterns =
+	rexCompiledRegexSet_matches(regex_set, string, &patterns);
+
+    printf("The string was accepted by %u of the regexes:", num_of_patterns);
+    for (unsigned i = 0; i < num_of_patterns; ++i) {
+	printf(" (%u)", patterns[i]);
+    }
+    printf("\n");
+
+    /* the regexes one by one, racing for the longest prefix of the string */
+    rexCompiledRegex** const compiled_regexes =
+	MALLOC(length * sizeof(rexCompiledRegex*));
+    for (unsigned i = 0; i < length; ++i) {
+	compiled_regexes[i] =
+	    rexCompiledRegex_create_from_regex(regex_parser, regexes[i], NULL);
+    }
+    rexCompiledRegexList* const regex_list =
+	rexCompiledRegexList_create_from_compiled_regex_list__(length,
+							       compiled_regexes);
+    rexRaceState* const race_state =
+	rexRaceState_create(rexCompiledRegexList_length(regex_list));
+    rexRaceState* const short_race_state = rexRaceState_create(length - 1);
+
+    const char* end_pos;
+    const unsigned winner =
+	rexCompiledRegexList_race(regex_list, race_state, string, &end_pos);
+    if (winner == length) {
+	printf("None of the regexes accepted a prefix of the string.\n");
+    } else {
+	printf("The race for the longest prefix was won by (%u), "
+	       "with %u characters.\n", winner, (unsigned) (end_pos - string));
+    }
+    if (rexCompiledRegexList_race(regex_list, short_race_state, string,
+				  &end_pos) != length) {
+	printf("A race state too short for the regexes was not refused.\n");
+    }
+
+    rexRaceState_destroy(short_race_state);
+    rexRaceState_destroy(race_state);
+    rexCompiledRegexList_destroy(regex_list);
+    rexCompiledRegexSet_destroy(regex_set);
+    end_label_1:;
+    rexRegexSLRParser_destroy(regex_parser);
+    end_label_0:;
+    ma_finalize();
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "gs.h"
+#include "parser.h"
+#include "regex.h"
+#include "lexer.h"
+#include "batch.h"
+
+const char* lexer_spec =
+    "num \\d+\n"
+    "@@ ( ) + - *\n"
+    "@! \\w";
+const char* grammar_spec =
+    "num ( ) + - *\n"
+    "@@nonterminals\n"
+    "E F G S\n"
+    "@@productions\n"
+    "S -> E\n"
+    "E -> F\n"
+    "F -> G\n"
+    "@paranthesis G -> ( E )\n"
+    "@plus E -> E + F\n"
+    "@minus E -> E - F\n"
+    "@mul F -> F * G\n"
+    "G -> num";
+
+typedef long attribute_t;
+
+/* the productions which do not just pass the attribute through */
+typedef struct productions_t {
+    unsigned paranthesis;
+    unsigned plus;
+    unsigned minus;
+    unsigned mul;
+} productions_t;
+
+unsigned str_to_val_func(unsigned token, const char* string_start,
+                         const char* string_end, void* extra) {
+    unsigned val = 0;
+    for (const char* c = string_start; c < string_end; ++c) {
+        val = 10 * val + (*c - '0');
+    }
+    return val;
+}
+
+void terminal_synth_fn(unsigned token, unsigned val, void* attribute,
+                       void* extra) {
+    * (attribute_t*) attribute = val;
+    return;
+}
+
+void production_synth_fn(unsigned production, void* attributes, void* extra) {
+    attribute_t* const results = (attribute_t*) attributes;
+    const productions_t* const productions = extra;
+    if (production == productions->paranthesis) {
+        results[0] = results[-2];
+    } else if (production == productions->plus) {
+        results[0] = results[-3] + results[-1];
+    } else if (production == productions->minus) {
+        results[0] = results[-3] - results[-1];
+    } else if (production == productions->mul) {
+        results[0] = results[-3] * results[-1];
+    } else {
+        results[0] = results[-1];
+    }
+    return;
+}
+
+/* the expression (1 + i) * (i - 2) + i, broken for every 7th i */
+void write_expression(char* string, unsigned i) {
+    sprintf(string, i % 7 == 6 ? "(1 + %u) * (%u - 2 +" : "(1 + %u) * (%u - 2) + %u",
+            i, i, i);
+    return;
+}
+
+int main(void) {
+    lexLexer* lexer = NULL;
+    prGrammar* grammar = NULL;
+    prSLRParser* parser = NULL;
+    char* strings = NULL;
+    const char** inputs = NULL;
+    attribute_t* results = NULL;
+    boolean* successes = NULL;
+
+    ma_initialize();
+
+    lexer = lexLexer_create_from_spec(lexer_spec, NULL);
+    grammar = prGrammar_create_from_spec(grammar_spec, NULL);
+    if (lexer == NULL || grammar == NULL) {
+        printf("There was an error forming the lexer or the grammar.\n");
+        goto end_label;
+    }
+    parser = prSLRParser_create_from_grammar(grammar, NULL);
+    if (parser == NULL) {
+        printf("There was an error forming the SLR parser for the grammar.\n");
+        goto end_label;
+    }
+
+    unsigned num_of_inputs;
+    printf("Enter the number of expressions (for example, 1000):\n");
+    if (scanf("%u", &num_of_inputs) != 1) {
+        goto end_label;
+    }
+    strings = MALLOC(num_of_inputs * 64);
+    inputs = MALLOC(num_of_inputs * sizeof(*inputs));
+    for (unsigned i = 0; i < num_of_inputs; ++i) {
+        write_expression(strings + i * 64, i);
+        inputs[i] = strings + i * 64;
+    }
+
+    productions_t productions[4];
+    for (unsigned w = 0; w < 4; ++w) {
+        productions[w].paranthesis =
+            prGrammar_production_by_name(grammar, "paranthesis");
+        productions[w].plus = prGrammar_production_by_name(grammar, "plus");
+        productions[w].minus = prGrammar_production_by_name(grammar, "minus");
+        productions[w].mul = prGrammar_production_by_name(grammar, "mul");
+    }
+
+    batPipeline pipeline;
+    pipeline.lexer = lexer;
+    pipeline.parser = parser;
+    pipeline.str_to_val_fn = str_to_val_func;
+    pipeline.terminal_synth_fn = terminal_synth_fn;
+    pipeline.production_synth_fn = production_synth_fn;
+    pipeline.element_size = sizeof(attribute_t);
+    results = MALLOC(num_of_inputs * sizeof(attribute_t));
+    successes = MALLOC(num_of_inputs * sizeof(boolean));
+    const unsigned num_of_successes =
+        batPipeline_run(&pipeline, num_of_inputs, inputs, 4, productions,
+                        sizeof(productions_t), results, successes);
+
+    unsigned num_of_wrong_results = 0;
+    for (unsigned i = 0; i < num_of_inputs; ++i) {
+        const attribute_t n = i;
+        if (successes[i] != (i % 7 != 6)
+            || (successes[i] == true && results[i] != (1 + n) * (n - 2) + n)) {
+            ++num_of_wrong_results;
+        }
+    }
+    printf("%u of the %u expressions were calculated, "
+           "%u of them wrongly or not as expected.\n",
+           num_of_successes, num_of_inputs, num_of_wrong_results);
+
+    end_label:;
+    FREE(successes);
+    FREE(results);
+    FREE(inputs);
+    FREE(strings);
+    prSLRParser_destroy(parser);
+    prGrammar_destroy(grammar);
+    lexLexer_destroy(lexer);
+    ma_finalize();
+    return 0;
+}
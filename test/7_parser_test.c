@@ -0,0 +1,944 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "parser.h"
+#include "regex.h"
+#include "lexer.h"
+
+/* checks the ways of parsing against prSLRParser_parse, on the inputs */
+
+const char* lexer_spec =
+    "num \\d+\n"
+    "@@ ( ) + - *\n"
+    "@! \\w";
+const char* grammar_spec =
+    "num ( ) + - *\n"
+    "@@nonterminals\n"
+    "E F G S\n"
+    "@@productions\n"
+    "S -> E\n"
+    "E -> F\n"
+    "F -> G\n"
+    "@paranthesis G -> ( E )\n"
+    "@plus E -> E + F\n"
+    "@minus E -> E - F\n"
+    "@mul F -> F * G\n"
+    "G -> num";
+
+/* a list of statements, the errors in which are recovered from on the
+   semicolons ending them */
+const char* recovery_grammar_spec =
+    "num ( ) + - * ;\n"
+    "@@nonterminals\n"
+    "E F G L S\n"
+    "@@synchronizing\n"
+    ";\n"
+    "@@productions\n"
+    "S -> L\n"
+    "L -> L E ;\n"
+    "L -> E ;\n"
+    "E -> E + F\n"
+    "E -> E - F\n"
+    "E -> F\n"
+    "F -> F * G\n"
+    "F -> G\n"
+    "G -> ( E )\n"
+    "G -> num";
+
+/* a character per token, n standing for num */
+const char token_chars[] = " n()+-*;";
+
+const char* const inputs[] = {
+    "n", "n+n*n", "(n-n)*(n+n)-n", "((((n))))", "n*n*n+n*n", "n+", "(n",
+    "n)", "nn", "", "*n", "(n+(n*n)-n)*n+(n)"
+};
+
+#define NUM_OF_INPUTS (sizeof(inputs) / sizeof(inputs[0]))
+
+/* 0-terminated; chars has a character per token */
+unsigned* create_tokens_from_chars(const char* input, const char* chars) {
+    const unsigned length = strlen(input);
+    unsigned* const tokens = MALLOC((length + 1) * sizeof(unsigned));
+    for (unsigned i = 0; i < length; ++i) {
+        tokens[i] = strchr(chars, input[i]) - chars;
+    }
+    tokens[length] = 0;
+    return tokens;
+}
+
+unsigned* create_tokens(const char* input) {
+    return create_tokens_from_chars(input, token_chars);
+}
+
+/* whether the 0-terminated items are the same, or both NULL */
+boolean are_items_equal(const unsigned* items, const unsigned* other_items) {
+    if (items == NULL || other_items == NULL) {
+        return items == other_items;
+    }
+    for (; *items == *other_items; ++items, ++other_items) {
+        if (*items == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* how many inputs parser parses other than expected does */
+unsigned count_different_parses(const prSLRParser* parser,
+                                const prSLRParser* expected) {
+    unsigned num_of_differences = 0;
+    for (unsigned i = 0; i < NUM_OF_INPUTS; ++i) {
+        unsigned* const tokens = create_tokens(inputs[i]);
+        const unsigned* end_pos;
+        const unsigned* expected_end_pos;
+        unsigned* const items = prSLRParser_parse(parser, tokens, &end_pos);
+        unsigned* const expected_items =
+            prSLRParser_parse(expected, tokens, &expected_end_pos);
+        if (are_items_equal(items, expected_items) == false
+            || end_pos != expected_end_pos) {
+            ++num_of_differences;
+        }
+        FREE(expected_items);
+        FREE(items);
+        FREE(tokens);
+    }
+    return num_of_differences;
+}
+
+/* feeds the inputs to a push parser a token at a time, checking that
+   the tokens are consumed as long as it continues, and that it stops,
+   consumes and yields as prSLRParser_parse does; returns the number of
+   failures */
+unsigned test_push_parse(const prSLRParser* parser) {
+    unsigned num_of_failures = 0;
+    for (unsigned i = 0; i < NUM_OF_INPUTS; ++i) {
+        unsigned* const tokens = create_tokens(inputs[i]);
+        const unsigned* end_pos;
+        unsigned* const items = prSLRParser_parse(parser, tokens, &end_pos);
+        prSLRPushParser* const push_parser = prSLRPushParser_create(parser);
+        prParseStatus status = PR_PARSE_CONTINUE;
+        boolean is_consistent = true;
+        for (unsigned j = 0; tokens[j] != 0; ++j) {
+            const prParseStatus previous_status = status;
+            status = prSLRPushParser_feed(push_parser, tokens[j]);
+            const unsigned num_of_consumed_tokens =
+                prSLRPushParser_num_of_consumed_tokens(push_parser);
+            if (previous_status != PR_PARSE_CONTINUE) {
+                /* feeding a stopped parse does nothing */
+                is_consistent = is_consistent && status == previous_status;
+            } else if (status == PR_PARSE_CONTINUE) {
+                is_consistent = is_consistent
+                    && num_of_consumed_tokens == j + 1;
+            } else {
+                is_consistent = is_consistent
+                    && num_of_consumed_tokens == j;
+            }
+        }
+        if (status == PR_PARSE_CONTINUE) {
+            status = prSLRPushParser_finish(push_parser);
+        }
+        unsigned* const push_items =
+            prSLRPushParser_release_items(push_parser);
+        if (is_consistent == false
+            || status == PR_PARSE_CONTINUE
+            || (status == PR_PARSE_ACCEPT) != (items != NULL)
+            || prSLRPushParser_num_of_consumed_tokens(push_parser)
+            != (unsigned) (end_pos - tokens)
+            || are_items_equal(push_items, items) == false) {
+            ++num_of_failures;
+        }
+        FREE(push_items);
+        prSLRPushParser_destroy(push_parser);
+        FREE(items);
+        FREE(tokens);
+    }
+    return num_of_failures;
+}
+
+/* the parser read back from its binary form parses as it does, and the
+   truncated binary forms, and those with a word (but for the flags of the
+   sinks) set to UINT_MAX, which would be out of the tables, or with
+   dimensions too large for the buffer, are rejected; returns the number
+   of failures */
+unsigned test_binary_form(const prSLRParser* parser) {
+    unsigned num_of_failures = 0;
+    const size_t size = prSLRParser_serialize(parser, NULL);
+    unsigned* const buffer = MALLOC(size);
+    unsigned* const corrupted = MALLOC(size);
+    prSLRParser_serialize(parser, buffer);
+
+    prSLRParser* const read_parser =
+        prSLRParser_create_from_binary(buffer, size, NULL);
+    if (read_parser == NULL
+        || count_different_parses(read_parser, parser) != 0) {
+        ++num_of_failures;
+    }
+    prSLRParser_destroy(read_parser);
+
+    for (size_t truncated_size = 0; truncated_size < size; ++truncated_size) {
+        prSLRParser* const truncated =
+            prSLRParser_create_from_binary(buffer, truncated_size, NULL);
+        if (truncated != NULL) {
+            ++num_of_failures;
+            prSLRParser_destroy(truncated);
+        }
+    }
+
+    /* the header is 10 words, words 5 and 6 (from 0) being the numbers
+       of states and of tokens, and the flags of the sinks follow it */
+    const size_t first_table_word = 10
+        + (buffer[5] * sizeof(boolean) + sizeof(unsigned) - 1)
+        / sizeof(unsigned);
+    for (size_t word = 0; word < size / sizeof(unsigned); ++word) {
+        if (word >= 10 && word < first_table_word) {
+            continue;
+        }
+        memcpy(corrupted, buffer, size);
+        corrupted[word] = 0xffffffffu;
+        prSLRParser* const corrupted_parser =
+            prSLRParser_create_from_binary(corrupted, size, NULL);
+        if (corrupted_parser != NULL) {
+            ++num_of_failures;
+            prSLRParser_destroy(corrupted_parser);
+        }
+    }
+    memcpy(corrupted, buffer, size);
+    /* whose tables would take 2^34 bytes, more than a 32-bit size_t holds */
+    corrupted[5] = 0x10000;
+    corrupted[6] = 0x10000;
+    prSLRParser* const oversized_parser =
+        prSLRParser_create_from_binary(corrupted, size, NULL);
+    if (oversized_parser != NULL) {
+        ++num_of_failures;
+        prSLRParser_destroy(oversized_parser);
+    }
+
+    FREE(corrupted);
+    FREE(buffer);
+    return num_of_failures;
+}
+
+/* the erroneous inputs of the statements, and where their errors are */
+typedef struct {
+    const char* input;
+    unsigned num_of_errors;
+    unsigned error_positions[4];
+} RecoveryCase;
+
+const RecoveryCase recovery_cases[] = {
+    {"n;n+n*(n-n);", 0, {0}},
+    {"n+;n;", 1, {2}},
+    {"nn;n;", 1, {1}},
+    {"n+;n*;(n;n;", 3, {2, 5, 8}},
+    {"n;)n;n;", 1, {2}},
+    {"n;n+n", 1, {5}},
+    {";n;", 1, {0}},
+    {"(n+n));n*n;*n;", 2, {5, 11}}
+};
+
+#define NUM_OF_RECOVERY_CASES \
+    (sizeof(recovery_cases) / sizeof(recovery_cases[0]))
+
+/* parses the recovery cases, checking the number and the positions of
+   the errors found; returns the number of failures */
+unsigned test_recovery(const prSLRParser* parser, const prGrammar* grammar) {
+    unsigned num_of_failures = 0;
+    for (unsigned i = 0; i < NUM_OF_RECOVERY_CASES; ++i) {
+        const RecoveryCase* const recovery_case = &recovery_cases[i];
+        unsigned* const tokens = create_tokens(recovery_case->input);
+        unsigned* error_positions;
+        const unsigned num_of_errors =
+            prSLRParser_parse_with_recovery(parser, grammar, tokens,
+                                            &error_positions);
+        boolean is_expected =
+            num_of_errors == recovery_case->num_of_errors;
+        for (unsigned j = 0; is_expected == true && j < num_of_errors; ++j) {
+            is_expected =
+                error_positions[j] == recovery_case->error_positions[j];
+        }
+        if (is_expected == false) {
+            printf("The errors of %s were found at:", recovery_case->input);
+            for (unsigned j = 0; j < num_of_errors; ++j) {
+                printf(" %u", error_positions[j]);
+            }
+            printf("\n");
+            ++num_of_failures;
+        }
+        FREE(error_positions);
+        FREE(tokens);
+    }
+    return num_of_failures;
+}
+
+/* a grammar declaring the name its repetition would be given */
+const char* colliding_grammar_spec =
+    "num\n"
+    "@@nonterminals\n"
+    "<num*> S\n"
+    "@@productions\n"
+    "S -> num@*\n"
+    "<num*> -> num";
+
+/* the conflicts of the group * E with + are resolved only if the group
+   takes the precedence of * */
+const char* group_precedence_grammar_spec =
+    "num + *\n"
+    "@@nonterminals\n"
+    "E S\n"
+    "@@precedence\n"
+    "@left +\n"
+    "@left *\n"
+    "@@productions\n"
+    "S -> E\n"
+    "@plus E -> E + E\n"
+    "@mul E -> E @( * E @)@+ @prec *\n"
+    "E -> num";
+
+/* checks that an added non-terminal may not be named as a declared one,
+   and that an added production takes the precedence of its body;
+   returns the number of failures */
+unsigned test_ebnf_specs(void) {
+    unsigned num_of_failures = 0;
+    char diagnostic[2048] = "";
+    prGrammar* grammar =
+        prGrammar_create_from_spec(colliding_grammar_spec, diagnostic);
+    if (grammar != NULL || strstr(diagnostic, "<num*>") == NULL) {
+        printf("The grammar declaring <num*> was not rejected.\n");
+        ++num_of_failures;
+    }
+    prGrammar_destroy(grammar);
+
+    grammar = prGrammar_create_from_spec(group_precedence_grammar_spec,
+                                         diagnostic);
+    prSLRParser* const parser = grammar == NULL ?
+        NULL : prSLRParser_create_from_grammar(grammar, diagnostic);
+    if (parser == NULL) {
+        printf("The grammar grouping * E was not formed.\n%s",
+               diagnostic);
+        prGrammar_destroy(grammar);
+        return num_of_failures + 1;
+    }
+    /* num * num + num, the multiplication to be reduced first */
+    const unsigned tokens[] = {1, 3, 1, 2, 1, 0};
+    const unsigned* end_pos;
+    unsigned* const items = prSLRParser_parse(parser, tokens, &end_pos);
+    const unsigned num_of_tokens = prGrammar_num_of_tokens(grammar);
+    const unsigned plus =
+        num_of_tokens + prGrammar_production_by_name(grammar, "plus");
+    const unsigned mul =
+        num_of_tokens + prGrammar_production_by_name(grammar, "mul");
+    unsigned i = 0;
+    while (items != NULL && items[i] != 0 && items[i] != mul
+           && items[i] != plus) {
+        ++i;
+    }
+    if (items == NULL || items[i] != mul) {
+        printf("The group * E bound less tightly than + did.\n");
+        ++num_of_failures;
+    }
+    FREE(items);
+    prSLRParser_destroy(parser);
+    prGrammar_destroy(grammar);
+    return num_of_failures;
+}
+
+/* after b, reducing by y loses to shifting +, while reducing by x wins
+   over it, so that x and y conflict however the shift is resolved */
+const char* hidden_conflict_grammar_spec =
+    "b +\n"
+    "@@nonterminals\n"
+    "X Y Z S\n"
+    "@@precedence\n"
+    "@left b\n"
+    "@left +\n"
+    "@left TOP\n"
+    "@@productions\n"
+    "S -> X +\n"
+    "S -> Y +\n"
+    "S -> Z\n"
+    "Z -> b + b\n"
+    "@x X -> b @prec TOP\n"
+    "@y Y -> b";
+
+/* checks that two productions reducible on a lookahead are reported as
+   conflicting, even if the shift is resolved against the first one;
+   returns the number of failures */
+unsigned test_hidden_conflict(void) {
+    char diagnostic[2048] = "";
+    prGrammar* const grammar =
+        prGrammar_create_from_spec(hidden_conflict_grammar_spec, diagnostic);
+    if (grammar == NULL) {
+        printf("The grammar hiding a conflict was not formed.\n%s",
+               diagnostic);
+        return 1;
+    }
+    const unsigned x = prGrammar_production_by_name(grammar, "x");
+    const unsigned y = prGrammar_production_by_name(grammar, "y");
+    prSLRParserReport report;
+    prSLRParser* const parser =
+        prSLRParser_create_with_report(grammar, false, &report, diagnostic);
+    boolean is_reported = false;
+    for (unsigned i = 0; i < report.num_of_conflicts; ++i) {
+        const prConflict* const conflict = &report.conflicts[i];
+        is_reported = is_reported
+            || (conflict->production == x && conflict->other_production == y)
+            || (conflict->production == y && conflict->other_production == x);
+    }
+    unsigned num_of_failures = 0;
+    if (parser != NULL || is_reported == false) {
+        printf("The conflict between reducing by x and by y was hidden.\n");
+        ++num_of_failures;
+    }
+    prSLRParserReport_destroy_(&report);
+    prSLRParser_destroy(parser);
+    prGrammar_destroy(grammar);
+    return num_of_failures;
+}
+
+/* a grammar to parse with and without bypassing its unit productions,
+   which are named so that they can be looked up, and the inputs to parse,
+   a character per token */
+typedef struct BypassCase {
+    const char* name;
+    const char* grammar_spec;
+    const char* token_chars;
+    const char* const* unit_production_names;
+    unsigned num_of_unit_productions;
+    const char* const* inputs;
+    unsigned num_of_inputs;
+} BypassCase;
+
+/* ./example.grm */
+const char* example_grammar_spec =
+    "char letter digit whitespace specific_char ( ) * + ? |\n"
+    "@@nonterminals\n"
+    "E F G S\n"
+    "@@productions\n"
+    "@start S -> E\n"
+    "@e_f E -> F\n"
+    "@f_g F -> G\n"
+    "@paranthesis G -> ( E )\n"
+    "@or E -> E | F\n"
+    "@and F -> F G\n"
+    "@star G -> G *\n"
+    "@plus G -> G +\n"
+    "@question G -> G ?\n"
+    "@char G -> char\n"
+    "@letter G -> letter\n"
+    "@digit G -> digit\n"
+    "@whitespace G -> whitespace\n"
+    "@specific_char G -> specific_char";
+const char* const example_unit_production_names[] = {
+    "start", "e_f", "f_g", "char", "letter", "digit", "whitespace",
+    "specific_char"
+};
+const char* const example_inputs[] = {
+    "c", "l|d*", "(cl)+|s?", "((c))", "c|", "(c", "c)", "", "*c",
+    "w(l|d)*?s", "||"
+};
+
+/* ./calculator.c */
+const char* calculator_grammar_spec =
+    "num ( ) + - * / max ,\n"
+    "@@nonterminals\n"
+    "E S\n"
+    "@@precedence\n"
+    "@left + -\n"
+    "@left * /\n"
+    "@right UMINUS\n"
+    "@@productions\n"
+    "@start S -> E\n"
+    "@paranthesis E -> ( E )\n"
+    "@plus E -> E + E\n"
+    "@minus E -> E - E\n"
+    "@mul E -> E * E\n"
+    "@div E -> E / E\n"
+    "@unary_minus E -> - E @prec UMINUS\n"
+    "@max E -> max ( E @( , E @)@* )\n"
+    "@num E -> num";
+const char* const calculator_unit_production_names[] = {"start", "num"};
+const char* const calculator_inputs[] = {
+    "n", "-n*(n+n)/n", "m(n,n,-n)+n", "m(n)", "m(n,)", "n--n", "(n", "mn",
+    "", "n+m(n*n,m(n,n))", "n,n"
+};
+
+/* ./example_ebnf.grm */
+const char* ebnf_grammar_spec =
+    "id num ( ) , ; let =\n"
+    "@@nonterminals\n"
+    "Call Arg Statement S\n"
+    "@@productions\n"
+    "@call Call -> id ( @( Arg @( , Arg @)@* @)@? )\n"
+    "@id Arg -> id\n"
+    "@num Arg -> num\n"
+    "@nested_call Arg -> Call\n"
+    "@statement Statement -> @( let id = @)@? Call\n"
+    "S -> Statement @( ; Statement @)@*";
+const char* const ebnf_unit_production_names[] = {"id", "num", "nested_call"};
+const char* const ebnf_inputs[] = {
+    "i()", "i(i,n,i(n))", "li=i(n);i()", "i(", "li=i(i);;i()", "i(,n)",
+    "", "li=i(i(i(i)))", "n()", "i(n);li=i(i,i)"
+};
+
+#define BYPASS_CASE(NAME, SPEC, CHARS, PREFIX) \
+    {NAME, SPEC, CHARS, PREFIX##_unit_production_names, \
+     sizeof(PREFIX##_unit_production_names) / sizeof(const char*), \
+     PREFIX##_inputs, sizeof(PREFIX##_inputs) / sizeof(const char*)}
+
+/* the number of the 0-terminated items */
+unsigned count_items(const unsigned* items) {
+    unsigned num_of_items = 0;
+    while (items[num_of_items] != 0) {
+        ++num_of_items;
+    }
+    return num_of_items;
+}
+
+/* drops the items of the given productions from the 0-terminated items,
+   in place */
+void filter_out_productions_(unsigned* items, unsigned num_of_tokens,
+                             const unsigned* productions,
+                             unsigned num_of_productions) {
+    unsigned* kept_item = items;
+    for (; *items != 0; ++items) {
+        boolean is_kept = true;
+        for (unsigned i = 0; i < num_of_productions; ++i) {
+            is_kept = is_kept && *items != num_of_tokens + productions[i];
+        }
+        if (is_kept == true) {
+            *kept_item = *items;
+            ++kept_item;
+        }
+    }
+    *kept_item = 0;
+    return;
+}
+
+/* checks that bypassing the unit productions of each of the grammars
+   accepts and rejects its inputs as without, stopping at the same
+   positions, that the items are the same but for the unit productions
+   (some of which may still be reduced by, see
+   prSLRParser_bypass_unit_productions), and that fewer are reduced by;
+   returns the number of failures */
+unsigned test_bypass(void) {
+    const BypassCase bypass_cases[] = {
+        BYPASS_CASE("example", example_grammar_spec, " cldws()*+?|",
+                    example),
+        BYPASS_CASE("calculator", calculator_grammar_spec, " n()+-*/m,",
+                    calculator),
+        BYPASS_CASE("EBNF", ebnf_grammar_spec, " in(),;l=", ebnf)
+    };
+    unsigned num_of_failures = 0;
+    for (unsigned i = 0; i < sizeof(bypass_cases) / sizeof(bypass_cases[0]);
+         ++i) {
+        const BypassCase* const bypass_case = &bypass_cases[i];
+        char diagnostic[2048] = "";
+        prGrammar* const grammar =
+            prGrammar_create_from_spec(bypass_case->grammar_spec, diagnostic);
+        prSLRParser* const parser = grammar == NULL
+            ? NULL : prSLRParser_create_from_grammar(grammar, diagnostic);
+        prSLRParser* const bypassing_parser = grammar == NULL
+            ? NULL : prSLRParser_create_from_grammar(grammar, diagnostic);
+        unsigned unit_productions[16];
+        if (parser == NULL || bypassing_parser == NULL
+            || prGrammar_productions_by_names(
+                   grammar, bypass_case->num_of_unit_productions,
+                   bypass_case->unit_production_names,
+                   unit_productions) == false) {
+            printf("The %s grammar or its parsers were not formed.\n%s",
+                   bypass_case->name, diagnostic);
+            ++num_of_failures;
+            goto next_label;
+        }
+        prSLRParser_bypass_unit_productions(bypassing_parser, grammar, NULL);
+        const unsigned num_of_tokens = prGrammar_num_of_tokens(grammar);
+        unsigned num_of_differences = 0;
+        unsigned num_of_items = 0;
+        unsigned num_of_bypassing_items = 0;
+        for (unsigned j = 0; j < bypass_case->num_of_inputs; ++j) {
+            unsigned* const tokens =
+                create_tokens_from_chars(bypass_case->inputs[j],
+                                         bypass_case->token_chars);
+            const unsigned* end_pos;
+            const unsigned* bypassing_end_pos;
+            unsigned* const items = prSLRParser_parse(parser, tokens,
+                                                      &end_pos);
+            unsigned* const bypassing_items =
+                prSLRParser_parse(bypassing_parser, tokens,
+                                  &bypassing_end_pos);
+            if (items != NULL && bypassing_items != NULL) {
+                num_of_items += count_items(items);
+                num_of_bypassing_items += count_items(bypassing_items);
+                filter_out_productions_(items, num_of_tokens,
+                                        unit_productions,
+                                        bypass_case->num_of_unit_productions);
+                filter_out_productions_(bypassing_items, num_of_tokens,
+                                        unit_productions,
+                                        bypass_case->num_of_unit_productions);
+            }
+            if (are_items_equal(items, bypassing_items) == false
+                || end_pos != bypassing_end_pos) {
+                ++num_of_differences;
+            }
+            FREE(bypassing_items);
+            FREE(items);
+            FREE(tokens);
+        }
+        if (num_of_differences != 0) {
+            printf("Bypassing the unit productions of the %s grammar parsed "
+                   "%u of its inputs differently.\n", bypass_case->name,
+                   num_of_differences);
+            ++num_of_failures;
+        }
+        if (num_of_bypassing_items >= num_of_items) {
+            printf("Bypassing the unit productions of the %s grammar "
+                   "skipped none of their reductions.\n", bypass_case->name);
+            ++num_of_failures;
+        }
+        next_label:;
+        prSLRParser_destroy(bypassing_parser);
+        prSLRParser_destroy(parser);
+        prGrammar_destroy(grammar);
+    }
+    return num_of_failures;
+}
+
+/* whether the tree is laid out as prCst describes: its kinds are the
+   items, the leaves have the spans given (or their indices, if spans is
+   NULL), an inner node spans its children and its subtree is the nodes
+   up to it */
+boolean is_cst_consistent(const prCst* cst, const unsigned* items,
+                          unsigned num_of_tokens,
+                          const lexTokenSpan* spans) {
+    unsigned num_of_leaves = 0;
+    for (unsigned i = 0; i < cst->num_of_nodes; ++i) {
+        if (items[i] == 0 || cst->kinds[i] != items[i]) {
+            return false;
+        }
+        if (cst->kinds[i] < num_of_tokens) {
+            const unsigned start =
+                spans != NULL ? spans[num_of_leaves].start : num_of_leaves;
+            const unsigned end =
+                spans != NULL ? spans[num_of_leaves].end : num_of_leaves + 1;
+            if (cst->first_children[i] != PR_CST_NONE
+                || cst->starts[i] != start || cst->ends[i] != end
+                || cst->subtree_sizes[i] != 1) {
+                return false;
+            }
+            ++num_of_leaves;
+            continue;
+        }
+        unsigned subtree_size = 1;
+        unsigned last_child = PR_CST_NONE;
+        for (unsigned child = cst->first_children[i]; child != PR_CST_NONE;
+             child = cst->next_siblings[child]) {
+            /* the subtrees of the children come one after the other */
+            if (child >= i || child + 1 < cst->subtree_sizes[child]
+                || (last_child != PR_CST_NONE
+                    && child - cst->subtree_sizes[child] != last_child)) {
+                return false;
+            }
+            subtree_size += cst->subtree_sizes[child];
+            last_child = child;
+        }
+        if (cst->subtree_sizes[i] != subtree_size
+            || (last_child != PR_CST_NONE
+                && (last_child != i - 1
+                    || cst->starts[i]
+                    != cst->starts[cst->first_children[i]]
+                    || cst->ends[i] != cst->ends[last_child]))) {
+            return false;
+        }
+    }
+    return items[cst->num_of_nodes] == 0
+        && cst->next_siblings[cst->num_of_nodes - 1] == PR_CST_NONE
+        && cst->subtree_sizes[cst->num_of_nodes - 1] == cst->num_of_nodes;
+}
+
+/* the span of the node of production, the first one if there are more,
+   or [0, 0) if there is none */
+void find_production_span(const prCst* cst, unsigned num_of_tokens,
+                          unsigned production, unsigned* out_span) {
+    out_span[0] = out_span[1] = 0;
+    for (unsigned i = 0; i < cst->num_of_nodes; ++i) {
+        if (cst->kinds[i] == num_of_tokens + production) {
+            out_span[0] = cst->starts[i];
+            out_span[1] = cst->ends[i];
+            return;
+        }
+    }
+    return;
+}
+
+/* builds the trees of a string, with the spans of its characters and
+   with those of its tokens, checking their layout and the spans of some
+   productions in them; returns the number of failures */
+unsigned test_cst(const lexLexer* lexer, const prSLRParser* parser,
+                  const prGrammar* grammar) {
+    const char* const string = "(12+3)*4 - 5";
+    const unsigned num_of_tokens = prGrammar_num_of_tokens(grammar);
+    unsigned num_of_failures = 0;
+    lexLexing lexing;
+    lexLexing_create_(&lexing, lexer, string, NULL, NULL);
+    const unsigned* end_pos;
+    unsigned* const items = prSLRParser_parse(parser, lexing.tokens, &end_pos);
+
+    prCst* const cst = prSLRParser_parse_to_cst(parser, lexing.tokens,
+                                                lexing.spans,
+                                                sizeof(lexTokenSpan),
+                                                &end_pos);
+    const unsigned root = cst->num_of_nodes - 1;
+    unsigned paranthesis_span[2], mul_span[2], minus_span[2];
+    find_production_span(cst, num_of_tokens,
+                         prGrammar_production_by_name(grammar, "paranthesis"),
+                         paranthesis_span);
+    find_production_span(cst, num_of_tokens,
+                         prGrammar_production_by_name(grammar, "mul"),
+                         mul_span);
+    find_production_span(cst, num_of_tokens,
+                         prGrammar_production_by_name(grammar, "minus"),
+                         minus_span);
+    if (is_cst_consistent(cst, items, num_of_tokens, lexing.spans) == false
+        || *end_pos != 0
+        || cst->starts[root] != 0 || cst->ends[root] != strlen(string)
+        || paranthesis_span[0] != 0 || paranthesis_span[1] != 6
+        || mul_span[0] != 0 || mul_span[1] != 8
+        || minus_span[0] != 0 || minus_span[1] != strlen(string)) {
+        ++num_of_failures;
+    }
+    prCst_destroy(cst);
+
+    prCst* const indexed_cst =
+        prSLRParser_parse_to_cst(parser, lexing.tokens, NULL, 0, &end_pos);
+    if (is_cst_consistent(indexed_cst, items, num_of_tokens, NULL) == false
+        || indexed_cst->ends[indexed_cst->num_of_nodes - 1]
+        != lexing.num_of_tokens) {
+        ++num_of_failures;
+    }
+    prCst_destroy(indexed_cst);
+
+    unsigned* const tokens = create_tokens("(n+n");
+    prCst* const rejected_cst =
+        prSLRParser_parse_to_cst(parser, tokens, NULL, 0, &end_pos);
+    if (rejected_cst != NULL) {
+        ++num_of_failures;
+        prCst_destroy(rejected_cst);
+    }
+    FREE(tokens);
+
+    FREE(items);
+    lexLexing_destroy_(&lexing);
+    return num_of_failures;
+}
+
+/* the characters edits of the string take theirs from */
+const char* const snippets[] = {
+    "", "7", "+", "(", ")", "*5", " ", "-(8)", "12", "(3+4)"
+};
+
+#define NUM_OF_SNIPPETS (sizeof(snippets) / sizeof(snippets[0]))
+
+/* a linear congruential generator, so that the edits are the same
+   from run to run */
+unsigned next_random(unsigned* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+/* whether the lexing of a string is the same as lexing it anew */
+boolean is_lexing_fresh(const lexLexing* lexing, const lexLexer* lexer,
+                        const char* string) {
+    lexLexing fresh_lexing;
+    lexLexing_create_(&fresh_lexing, lexer, string, NULL, NULL);
+    boolean is_fresh = lexing->num_of_tokens == fresh_lexing.num_of_tokens
+        && lexing->end_pos == fresh_lexing.end_pos;
+    for (unsigned i = 0; is_fresh == true && i < lexing->num_of_tokens; ++i) {
+        is_fresh = lexing->tokens[i] == fresh_lexing.tokens[i]
+            && lexing->spans[i].start == fresh_lexing.spans[i].start
+            && lexing->spans[i].end == fresh_lexing.spans[i].end;
+    }
+    lexLexing_destroy_(&fresh_lexing);
+    return is_fresh;
+}
+
+/* a token which looks far ahead before giving up: lexing the a of "abbbd"
+   looks as far as the d, though the b's after it look no further than
+   themselves, so changing the d to a c should relex from the a */
+const char* lookahead_lexer_spec =
+    "long ab*c\n"
+    "@@ a b c d";
+
+/* returns the number of failures */
+unsigned test_relex_lookahead(void) {
+    lexLexer* const lexer = lexLexer_create_from_spec(lookahead_lexer_spec,
+                                                      NULL);
+    if (lexer == NULL) {
+        printf("There was an error forming the lookahead lexer.\n");
+        return 1;
+    }
+    char string[] = "dabbbd";
+    lexLexing lexing;
+    lexLexing_create_(&lexing, lexer, string, NULL, NULL);
+    string[5] = 'c';
+    unsigned first, old_end, new_length;
+    lexLexing_relex_(&lexing, lexer, string, 5, 6, 1, NULL, NULL, &first,
+                     &old_end, &new_length);
+    unsigned num_of_failures = 0;
+    if (is_lexing_fresh(&lexing, lexer, string) == false || first != 1) {
+        printf("Relexing dabbbd as dabbbc went wrong.\n");
+        ++num_of_failures;
+    }
+    lexLexing_destroy_(&lexing);
+    lexLexer_destroy(lexer);
+    return num_of_failures;
+}
+
+/* edits the string (and undoes each edit), relexing it and reparsing its
+   tokens incrementally, which should each time come to what lexing and
+   parsing it anew does; returns the number of failures */
+unsigned test_incremental_parse(const lexLexer* lexer,
+                                const prSLRParser* parser) {
+    unsigned num_of_failures = 0;
+    char string[4096] = "";
+    for (unsigned i = 0; i < 40; ++i) {
+        strcat(string, "(12+3)*");
+    }
+    strcat(string, "4");
+    lexLexing lexing;
+    lexLexing_create_(&lexing, lexer, string, NULL, NULL);
+    prSLRIncrementalParser* const incremental_parser =
+        prSLRIncrementalParser_create(parser, lexing.tokens);
+    unsigned seed = 1;
+    unsigned num_of_edits = 0;
+    unsigned num_of_reparsed_tokens = 0;
+    unsigned num_of_tokens = 0;
+    for (unsigned e = 0; e < 400; ++e) {
+        /* an edit, then its undoing */
+        const unsigned length = strlen(string);
+        const unsigned start = next_random(&seed) % (length + 1);
+        const unsigned max_removed = length - start < 4 ? length - start : 4;
+        const unsigned old_end =
+            start + next_random(&seed) % (max_removed + 1);
+        const char* const snippet =
+            snippets[next_random(&seed) % NUM_OF_SNIPPETS];
+        char removed[8];
+        memcpy(removed, string + start, old_end - start);
+        removed[old_end - start] = 0;
+        for (unsigned undo = 0; undo < 2; ++undo) {
+            const char* const inserted = undo == 0 ? snippet : removed;
+            const unsigned replaced_length =
+                undo == 0 ? old_end - start : strlen(snippet);
+            memmove(string + start + strlen(inserted),
+                    string + start + replaced_length,
+                    strlen(string + start + replaced_length) + 1);
+            memcpy(string + start, inserted, strlen(inserted));
+
+            unsigned first, old_token_end, new_num_of_tokens;
+            lexLexing_relex_(&lexing, lexer, string, start,
+                             start + replaced_length, strlen(inserted),
+                             NULL, NULL, &first, &old_token_end,
+                             &new_num_of_tokens);
+            prSLRIncrementalParser_edit(incremental_parser, first,
+                                        old_token_end, lexing.tokens + first,
+                                        new_num_of_tokens);
+            ++num_of_edits;
+            num_of_reparsed_tokens +=
+                prSLRIncrementalParser_num_of_reparsed_tokens(incremental_parser);
+            num_of_tokens += lexing.num_of_tokens;
+
+            const unsigned* end_pos;
+            unsigned* const items =
+                prSLRParser_parse(parser, lexing.tokens, &end_pos);
+            const unsigned* const incremental_items =
+                prSLRIncrementalParser_items(incremental_parser);
+            const unsigned num_of_consumed_tokens =
+                prSLRIncrementalParser_num_of_consumed_tokens(incremental_parser);
+            const boolean is_accepted =
+                prSLRIncrementalParser_status(incremental_parser)
+                == PR_PARSE_ACCEPT;
+            if (is_lexing_fresh(&lexing, lexer, string) == false
+                || are_items_equal(incremental_items, items) == false
+                || num_of_consumed_tokens
+                != (unsigned) (end_pos - lexing.tokens)
+                || is_accepted != (items != NULL)) {
+                ++num_of_failures;
+            }
+            FREE(items);
+        }
+    }
+    printf("The incremental parse: %u edits reparsed %u tokens in all, "
+           "of the %u the strings had.\n", num_of_edits,
+           num_of_reparsed_tokens, num_of_tokens);
+    prSLRIncrementalParser_destroy(incremental_parser);
+    lexLexing_destroy_(&lexing);
+    return num_of_failures;
+}
+
+int main(void) {
+    lexLexer* lexer = NULL;
+    prGrammar* grammar = NULL;
+    prSLRParser* parser = NULL;
+    prSLRParser* bypassing_parser = NULL;
+    prGrammar* recovery_grammar = NULL;
+    prSLRParser* recovery_parser = NULL;
+
+    ma_initialize();
+
+    char diagnostic[2048];
+    lexer = lexLexer_create_from_spec(lexer_spec, NULL);
+    if (lexer == NULL) {
+        printf("There was an error forming the lexer.\n");
+        goto end_label;
+    }
+    grammar = prGrammar_create_from_spec(grammar_spec, diagnostic);
+    if (grammar == NULL) {
+        printf("There was an error forming the grammar.\n%s", diagnostic);
+        goto end_label;
+    }
+    parser = prSLRParser_create_from_grammar(grammar, diagnostic);
+    bypassing_parser = prSLRParser_create_from_grammar(grammar, diagnostic);
+    if (parser == NULL || bypassing_parser == NULL) {
+        printf("There was an error forming the SLR parser.\n%s", diagnostic);
+        goto end_label;
+    }
+    prSLRParser_bypass_unit_productions(bypassing_parser, grammar, NULL);
+    recovery_grammar =
+        prGrammar_create_from_spec(recovery_grammar_spec, diagnostic);
+    if (recovery_grammar == NULL) {
+        printf("There was an error forming the grammar.\n%s", diagnostic);
+        goto end_label;
+    }
+    recovery_parser =
+        prSLRParser_create_from_grammar(recovery_grammar, diagnostic);
+    if (recovery_parser == NULL) {
+        printf("There was an error forming the SLR parser.\n%s", diagnostic);
+        goto end_label;
+    }
+
+    unsigned num_of_failures = 0;
+    num_of_failures += test_push_parse(parser);
+    num_of_failures += test_push_parse(bypassing_parser);
+    num_of_failures += test_binary_form(parser);
+    num_of_failures += test_binary_form(bypassing_parser);
+    num_of_failures += test_bypass();
+    num_of_failures += test_incremental_parse(lexer, parser);
+    num_of_failures += test_relex_lookahead();
+    num_of_failures += test_cst(lexer, parser, grammar);
+    num_of_failures += test_cst(lexer, bypassing_parser, grammar);
+    num_of_failures += test_recovery(recovery_parser, recovery_grammar);
+    num_of_failures += test_ebnf_specs();
+    num_of_failures += test_hidden_conflict();
+    printf("%u of the checks failed.\n", num_of_failures);
+
+    end_label:;
+    prSLRParser_destroy(recovery_parser);
+    prGrammar_destroy(recovery_grammar);
+    prSLRParser_destroy(bypassing_parser);
+    prSLRParser_destroy(parser);
+    prGrammar_destroy(grammar);
+    lexLexer_destroy(lexer);
+    ma_finalize();
+    return 0;
+}
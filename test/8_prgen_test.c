@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "str.h"
+#include "parser.h"
+#include "regex.h"
+
+/* written by tools/prgen -r, as 8_prgen_test.sh has it */
+#include "example_ra.h"
+#include "example_bypassing_ra.h"
+#include "regex_ra.h"
+
+/* checks the recursive-ascent parsers prgen writes against the parse
+   tables they were written from, on random token sequences */
+
+typedef boolean (*RecursiveAscentParseFn)(const unsigned* tokens,
+                                          void (*item_fn)(unsigned item,
+                                                          void* extra),
+                                          void* extra,
+                                          const unsigned** out_end_pos);
+
+#define NUM_OF_SEQUENCES 20000
+#define MAX_SEQUENCE_LENGTH 24
+
+/* the items the recursive-ascent parser has given so far */
+typedef struct {
+    unsigned num_of_items;
+    unsigned items[8 * MAX_SEQUENCE_LENGTH + 8];
+} ItemList;
+
+void add_item(unsigned item, void* extra) {
+    ItemList* const item_list = extra;
+    item_list->items[item_list->num_of_items++] = item;
+    return;
+}
+
+/* the tokens which are no production's head */
+unsigned get_terminals(const prSLRParser* parser, unsigned* out_terminals) {
+    prSLRParserTables tables;
+    prSLRParser_get_tables(parser, &tables);
+    unsigned num_of_terminals = 0;
+    for (unsigned token = 1; token < tables.num_of_tokens; ++token) {
+        boolean is_head = false;
+        for (unsigned i = 0; i < tables.num_of_productions; ++i) {
+            if (tables.bt_list[2 * i + 1] == token) {
+                is_head = true;
+            }
+        }
+        if (is_head == false) {
+            out_terminals[num_of_terminals++] = token;
+        }
+    }
+    return num_of_terminals;
+}
+
+/* parses random sequences of terminals both ways, printing how many
+   were accepted; returns the number of sequences parsed differently */
+unsigned count_different_parses(const char* name, const prSLRParser* parser,
+                                RecursiveAscentParseFn parse_fn) {
+    unsigned terminals[64];
+    const unsigned num_of_terminals = get_terminals(parser, terminals);
+    unsigned num_of_differences = 0;
+    unsigned num_of_accepted = 0;
+    ItemList* const item_list = MALLOC(sizeof(*item_list));
+    for (unsigned i = 0; i < NUM_OF_SEQUENCES; ++i) {
+        unsigned tokens[MAX_SEQUENCE_LENGTH + 1];
+        const unsigned length = rand() % (MAX_SEQUENCE_LENGTH + 1);
+        for (unsigned j = 0; j < length; ++j) {
+            tokens[j] = terminals[rand() % num_of_terminals];
+        }
+        tokens[length] = 0;
+        const unsigned* end_pos;
+        const unsigned* ra_end_pos;
+        unsigned* const items = prSLRParser_parse(parser, tokens, &end_pos);
+        item_list->num_of_items = 0;
+        const boolean is_accepted =
+            parse_fn(tokens, add_item, item_list, &ra_end_pos);
+        boolean is_same = is_accepted == (items != NULL)
+            && ra_end_pos == end_pos;
+        if (is_same == true && items != NULL) {
+            unsigned num_of_items = 0;
+            while (items[num_of_items] != 0) {
+                ++num_of_items;
+            }
+            is_same = num_of_items == item_list->num_of_items
+                && memcmp(items, item_list->items,
+                          num_of_items * sizeof(unsigned)) == 0;
+            ++num_of_accepted;
+        }
+        if (is_same == false) {
+            ++num_of_differences;
+        }
+        FREE(items);
+    }
+    FREE(item_list);
+    printf("%s: %u of the %u sequences were accepted.\n", name,
+           num_of_accepted, NUM_OF_SEQUENCES);
+    return num_of_differences;
+}
+
+int main(void) {
+    prGrammar* grammar = NULL;
+    prSLRParser* parser = NULL;
+    prSLRParser* bypassing_parser = NULL;
+    rexRegexSLRParser* regex_parser = NULL;
+
+    ma_initialize();
+    srand(1);
+
+    char diagnostic[2048];
+    char* const grammar_spec = str_read_file("example.grm");
+    if (grammar_spec == NULL) {
+        printf("There was an error reading example.grm.\n");
+        goto end_label;
+    }
+    grammar = prGrammar_create_from_spec(grammar_spec, diagnostic);
+    FREE(grammar_spec);
+    if (grammar == NULL) {
+        printf("There was an error forming the grammar.\n%s", diagnostic);
+        goto end_label;
+    }
+    parser = prSLRParser_create_from_grammar(grammar, diagnostic);
+    bypassing_parser = prSLRParser_create_from_grammar(grammar, diagnostic);
+    if (parser == NULL || bypassing_parser == NULL) {
+        printf("There was an error forming the SLR parser.\n%s", diagnostic);
+        goto end_label;
+    }
+    prSLRParser_bypass_unit_productions(bypassing_parser, grammar, NULL);
+    regex_parser = rexRegexSLRParser_create();
+
+    unsigned num_of_differences = 0;
+    num_of_differences +=
+        count_different_parses("example.grm", parser, example_ra_parse);
+    num_of_differences +=
+        count_different_parses("example.grm, bypassing", bypassing_parser,
+                               example_bypassing_ra_parse);
+    num_of_differences +=
+        count_different_parses("the regex meta-grammar",
+                               (const prSLRParser*) regex_parser,
+                               regex_ra_parse);
+    printf("%u of the sequences were parsed differently.\n",
+           num_of_differences);
+
+    end_label:;
+    rexRegexSLRParser_destroy(regex_parser);
+    prSLRParser_destroy(bypassing_parser);
+    prSLRParser_destroy(parser);
+    prGrammar_destroy(grammar);
+    ma_finalize();
+    return 0;
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+
+clear
+
+gcc -std=c99 -Wall -Wextra -pedantic -I../include -o prgen ../src/standard.c ../src/err.c ../src/ma.c ../src/str.c ../src/gs.c ../src/ss.c ../src/fa.c ../src/parser.c ../src/regex.c ../tools/prgen.c &&
+./prgen -r example.grm example_ra > example_ra.h &&
+./prgen -r -u example.grm example_bypassing_ra > example_bypassing_ra.h &&
+./prgen -r @regex regex_ra > regex_ra.h &&
+gcc -std=c99 -Wall -Wextra -pedantic -Wno-unused-parameter -D TESTING_PRINTS -D MA_TRACK -D MA_DEBUG -I../include -o test ../src/standard.c ../src/err.c ../src/ma.c ../src/str.c ../src/gs.c ../src/ss.c ../src/fa.c ../src/parser.c ../src/regex.c 8_prgen_test.c &&
+./test &&
+rm ./test
+rm -f ./prgen example_ra.h example_bypassing_ra.h regex_ra.h
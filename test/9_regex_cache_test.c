@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "regex.h"
+
+/* checks the sharing and the eviction of rexCompiledRegexCache, and the
+   statistics and the diagnostics of
+   rexCompiledRegex_create_from_regex_with_stats */
+
+/* counts the locks held, standing in for a mutex */
+typedef struct CountingLock {
+    unsigned num_of_held;
+    unsigned num_of_locks;
+}                       CountingLock;
+
+void lock_counting_lock(void* lock) {
+    ++((CountingLock*) lock)->num_of_held;
+    ++((CountingLock*) lock)->num_of_locks;
+    return;
+}
+
+void unlock_counting_lock(void* lock) {
+    --((CountingLock*) lock)->num_of_held;
+    return;
+}
+
+size_t compiled_memory_size(const rexRegexSLRParser* regex_parser,
+                            const char* regex) {
+    rexCompiledRegex* const compiled_regex =
+        rexCompiledRegex_create_from_regex(regex_parser, regex, NULL);
+    const size_t memory_size = rexCompiledRegex_memory_size(compiled_regex);
+    rexCompiledRegex_destroy(compiled_regex);
+    return memory_size;
+}
+
+/* returns the number of failures */
+unsigned test_sharing(const rexRegexSLRParser* regex_parser) {
+    unsigned num_of_failures = 0;
+    CountingLock lock = {0, 0};
+    rexCompiledRegexCache* const cache =
+        rexCompiledRegexCache_create(regex_parser, 1 << 20,
+                                     lock_counting_lock,
+                                     unlock_counting_lock, &lock);
+    const char* const digits_and_more = "\\d+xyz";
+    const rexCompiledRegex* const digits =
+        rexCompiledRegexCache_acquire(cache, "\\d+", NULL);
+    const rexCompiledRegex* const digits_again =
+        rexCompiledRegexCache_acquire(cache, digits_and_more,
+                                      digits_and_more + 3);
+    const rexCompiledRegex* const letters =
+        rexCompiledRegexCache_acquire(cache, "\\a+", NULL);
+    if (digits == NULL || digits != digits_again || letters == digits) {
+        printf("The cache did not share the regexes by their text.\n");
+        ++num_of_failures;
+    } else if (rexCompiledRegex_accepts(digits, "123") == false
+               || rexCompiledRegex_accepts(letters, "123") == true) {
+        printf("The regexes of the cache accepted wrongly.\n");
+        ++num_of_failures;
+    }
+    if (rexCompiledRegexCache_acquire(cache, "(", NULL) != NULL) {
+        printf("The cache acquired a regex failing to compile.\n");
+        ++num_of_failures;
+    }
+    if (rexCompiledRegexCache_memory_size(cache)
+        != compiled_memory_size(regex_parser, "\\d+")
+        + compiled_memory_size(regex_parser, "\\a+")) {
+        printf("The cache did not count the memory of its regexes.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegexCache_release(cache, letters);
+    rexCompiledRegexCache_release(cache, digits_again);
+    rexCompiledRegexCache_release(cache, digits);
+    rexCompiledRegexCache_destroy(cache);
+    if (lock.num_of_locks == 0 || lock.num_of_held != 0) {
+        printf("The cache did not lock and unlock in pairs.\n");
+        ++num_of_failures;
+    }
+    return num_of_failures;
+}
+
+/* returns the number of failures */
+unsigned test_eviction(const rexRegexSLRParser* regex_parser) {
+    unsigned num_of_failures = 0;
+    const char* const regexes[] = {"a{5}", "b{6}", "c{7}"};
+    size_t memory_sizes[3];
+    for (unsigned i = 0; i < 3; ++i) {
+        memory_sizes[i] = compiled_memory_size(regex_parser, regexes[i]);
+    }
+    /* room for all of them but a byte */
+    rexCompiledRegexCache* const cache =
+        rexCompiledRegexCache_create(regex_parser,
+                                     memory_sizes[0] + memory_sizes[1]
+                                     + memory_sizes[2] - 1,
+                                     NULL, NULL, NULL);
+    rexCompiledRegexCache_release(cache,
+        rexCompiledRegexCache_acquire(cache, regexes[0], NULL));
+    rexCompiledRegexCache_release(cache,
+        rexCompiledRegexCache_acquire(cache, regexes[1], NULL));
+    if (rexCompiledRegexCache_memory_size(cache)
+        != memory_sizes[0] + memory_sizes[1]) {
+        printf("The cache did not keep the released regexes.\n");
+        ++num_of_failures;
+    }
+    /* the least recently released, regexes[0], goes */
+    const rexCompiledRegex* const third =
+        rexCompiledRegexCache_acquire(cache, regexes[2], NULL);
+    if (rexCompiledRegexCache_memory_size(cache)
+        != memory_sizes[1] + memory_sizes[2]) {
+        printf("The cache did not evict the least recently released "
+               "regex.\n");
+        ++num_of_failures;
+    }
+    const rexCompiledRegex* const second =
+        rexCompiledRegexCache_acquire(cache, regexes[1], NULL);
+    /* the acquired regexes are never evicted, even over the maximum */
+    const rexCompiledRegex* const first =
+        rexCompiledRegexCache_acquire(cache, regexes[0], NULL);
+    if (rexCompiledRegexCache_memory_size(cache)
+        != memory_sizes[0] + memory_sizes[1] + memory_sizes[2]) {
+        printf("The cache evicted an acquired regex.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegexCache_release(cache, first);
+    rexCompiledRegexCache_release(cache, second);
+    rexCompiledRegexCache_release(cache, third);
+    if (rexCompiledRegexCache_memory_size(cache)
+        != memory_sizes[1] + memory_sizes[2]) {
+        printf("The cache did not shrink back once the regexes were "
+               "released.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegexCache_destroy(cache);
+    return num_of_failures;
+}
+
+/* returns the number of failures */
+unsigned test_stats(const rexRegexSLRParser* regex_parser) {
+    unsigned num_of_failures = 0;
+    rexCompileStats stats;
+    rexCompiledRegex* const compiled_regex =
+        rexCompiledRegex_create_from_regex_with_stats(regex_parser,
+                                                      "\\d+(.\\d+)?", NULL,
+                                                      &stats, NULL);
+    if (compiled_regex == NULL) {
+        printf("The regex with stats failed to compile.\n");
+        return 1;
+    }
+    if (stats.num_of_parse_items == 0 || stats.num_of_nfa_states == 0
+        || stats.num_of_dfa_states == 0 || stats.alphabet_size == 0
+        || stats.num_of_nfa_epsilon_edges > stats.num_of_nfa_edges
+        || stats.table_bytes != rexCompiledRegex_memory_size(compiled_regex)) {
+        printf("The stats of the regex do not add up.\n");
+        ++num_of_failures;
+    }
+    if (stats.preprocess_time > stats.total_time
+        || stats.parse_time > stats.total_time
+        || stats.synthesize_time > stats.total_time
+        || stats.determinize_time > stats.total_time) {
+        printf("A phase of the compilation took longer than it did.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegex_destroy(compiled_regex);
+
+    /* a longer repetition of the same takes more states */
+    rexCompileStats longer_stats;
+    rexCompiledRegex_destroy(
+        rexCompiledRegex_create_from_regex_with_stats(regex_parser, "a{3}",
+                                                      NULL, &stats, NULL));
+    rexCompiledRegex_destroy(
+        rexCompiledRegex_create_from_regex_with_stats(regex_parser, "a{6}",
+                                                      NULL, &longer_stats,
+                                                      NULL));
+    if (longer_stats.num_of_nfa_states <= stats.num_of_nfa_states
+        || longer_stats.num_of_dfa_states <= stats.num_of_dfa_states) {
+        printf("The stats of a{6} are not above those of a{3}.\n");
+        ++num_of_failures;
+    }
+
+    if (rexCompiledRegex_create_from_regex_with_stats(regex_parser, "(", NULL,
+                                                      &stats, NULL) != NULL
+        || stats.num_of_dfa_states != 0 || stats.table_bytes != 0) {
+        printf("The stats of a regex failing to compile were filled "
+               "past the failure.\n");
+        ++num_of_failures;
+    }
+    return num_of_failures;
+}
+
+/* returns the number of failures */
+unsigned test_repeat_limits(const rexRegexSLRParser* regex_parser) {
+    unsigned num_of_failures = 0;
+    char string[REX_MAX_REPEAT_BOUND + 1];
+    memset(string, 'a', REX_MAX_REPEAT_BOUND);
+    string[REX_MAX_REPEAT_BOUND] = 0;
+    rexCompiledRegex* compiled_regex =
+        rexCompiledRegex_create_from_regex(regex_parser, "a{1024}", NULL);
+    if (compiled_regex == NULL
+        || rexCompiledRegex_accepts(compiled_regex, string) == false
+        || rexCompiledRegex_accepts(compiled_regex, string + 1) == true) {
+        printf("a{1024} did not accept just 1024 a's.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegex_destroy(compiled_regex);
+    compiled_regex =
+        rexCompiledRegex_create_from_regex(regex_parser, "(ab|c){2,}x", NULL);
+    if (compiled_regex == NULL
+        || rexCompiledRegex_accepts(compiled_regex, "abcabx") == false
+        || rexCompiledRegex_accepts(compiled_regex, "abx") == true) {
+        printf("(ab|c){2,}x did not accept as it should.\n");
+        ++num_of_failures;
+    }
+    rexCompiledRegex_destroy(compiled_regex);
+
+    /* a bound too large, and bounds too large together */
+    const char* const rejected_regexes[] = {"a{1025}", "(a{1000}){1000}"};
+    const char* const reasons[] = {"bound above", "NFA states"};
+    for (unsigned i = 0; i < 2; ++i) {
+        char diagnostic[REX_MAX_DIAGNOSTIC_LENGTH] = "";
+        rexCompileStats stats;
+        /* the whole diagnostic fits, ending with its newline */
+        if (rexCompiledRegex_create_from_regex_with_stats(regex_parser,
+                                                          rejected_regexes[i],
+                                                          NULL, &stats,
+                                                          diagnostic) != NULL
+            || strstr(diagnostic, reasons[i]) == NULL
+            || strchr(diagnostic, '\n') == NULL) {
+            printf("%s was not rejected as it should be.\n%s",
+                   rejected_regexes[i], diagnostic);
+            ++num_of_failures;
+        }
+    }
+    return num_of_failures;
+}
+
+int main(void) {
+    ma_initialize();
+
+    rexRegexSLRParser* const regex_parser = rexRegexSLRParser_create();
+    if (regex_parser == NULL) {
+        printf("The regex SLR parser creation failed.\n");
+        goto end_label;
+    }
+
+    unsigned num_of_failures = 0;
+    num_of_failures += test_sharing(regex_parser);
+    num_of_failures += test_eviction(regex_parser);
+    num_of_failures += test_stats(regex_parser);
+    num_of_failures += test_repeat_limits(regex_parser);
+    printf("%u of the checks failed.\n", num_of_failures);
+
+    rexRegexSLRParser_destroy(regex_parser);
+    end_label:;
+    ma_finalize();
+    return 0;
+}
@@ -1,6 +1,6 @@
 #include <stdio.h>
 #include <string.h>
-#include <math.h> /* for pow */
+#include <math.h> /* for pow, fmax and INFINITY */
 
 #include "standard.h"
 #include "ma.h"
@@ -12,29 +12,53 @@
 
 const char* lexer_spec =
     "num \\d+(.\\d+)?\n"
-    "@@ ( ) + - * /\n"
+    "@@ ( ) + - * / max ,\n"
     "@! \\w";
+/* a flat grammar, the precedences resolving its conflicts; the arguments
+   of max after the first are a list, synthesized at once */
 const char* grammar_spec =
-    "num ( ) + - * /\n"
+    "num ( ) + - * / max ,\n"
     "@@nonterminals\n"
-    "E F G S\n"
+    "E S\n"
+    "@@precedence\n"
+    "@left + -\n"
+    "@left * /\n"
+    "@right UMINUS\n"
     "@@productions\n"
     "S -> E\n"
-    "E -> F\n"
-    "F -> G\n"
-    "@paranthesis G -> ( E )\n"
-    "@plus E -> E + F\n"
-    "@minus E -> E - F\n"
-    "@mul F -> F * G\n"
-    "@div F -> F / G\n"
-    "@unary_minus G -> - G\n"
-    "G -> num";
+    "@paranthesis E -> ( E )\n"
+    "@plus E -> E + E\n"
+    "@minus E -> E - E\n"
+    "@mul E -> E * E\n"
+    "@div E -> E / E\n"
+    "@unary_minus E -> - E @prec UMINUS\n"
+    "@max E -> max ( E @( , E @)@* )\n"
+    "E -> num";
 
 typedef double attribute_t;
 
+/* what production_synth_fn does for each production, in the order of
+   operation_names, and then for the ones passing the attribute through */
+typedef enum operation_t {
+    PARANTHESIS,
+    PLUS,
+    MINUS,
+    MUL,
+    DIV,
+    UNARY_MINUS,
+    MAX,
+    PASS_THROUGH
+} operation_t;
+
+const char* const operation_names[] = {
+    "paranthesis", "plus", "minus", "mul", "div", "unary_minus", "max"
+};
+
 typedef struct extra_t {
     gsStack* val_table;
-    prGrammar* grammar;
+    /* looked up once, so that the synthesis does not look up names */
+    unsigned num_token;
+    operation_t* operations;
 } extra_t;
 
 double _string_to_double(const char* string_start, const char* string_end) {
@@ -69,9 +93,8 @@ double _string_to_double(const char* string_start, const char* string_end) {
 unsigned str_to_val_func(unsigned token, const char* string_start,
                          const char* string_end, void* extra) {
     const extra_t* const extra_casted = (extra_t*) extra;
-    const prGrammar* const grammar = extra_casted->grammar;
     gsStack* const val_table = extra_casted->val_table;
-    if (token == prGrammar_token_by_name(grammar, (char*) "num")) {
+    if (token == extra_casted->num_token) {
         GS_APPEND(val_table, _string_to_double(string_start, string_end),
                   attribute_t);
         return gsStack_length(val_table) - 1;
@@ -83,9 +106,8 @@ void terminal_synth_fn(unsigned token, unsigned val, void* attribute,
 		       void* extra) {
     attribute_t* const result = (attribute_t*) attribute;
     const extra_t* const extra_casted = (extra_t*) extra;
-    const prGrammar* const grammar = extra_casted->grammar;
     const attribute_t* const val_table = gsStack_0(extra_casted->val_table);
-    if (token == prGrammar_token_by_name(grammar, (char*) "num")) {
+    if (token == extra_casted->num_token) {
         *result = val_table[val];
     }
     return;
@@ -93,21 +115,44 @@ void terminal_synth_fn(unsigned token, unsigned val, void* attribute,
 
 void production_synth_fn(unsigned production, void* attributes, void* extra) {
     attribute_t* const results = (attribute_t*) attributes;
-    const prGrammar* const grammar = ((extra_t*) extra)->grammar;
-    if (production == prGrammar_production_by_name(grammar, (char*) "paranthesis")) {
+    switch (((extra_t*) extra)->operations[production]) {
+    case PARANTHESIS:
         results[0] = results[-2];
-    } else if (production == prGrammar_production_by_name(grammar, (char*) "plus")) {
+        break;
+    case PLUS:
         results[0] = results[-3] + results[-1];
-    } else if (production == prGrammar_production_by_name(grammar, (char*) "minus")) {
+        break;
+    case MINUS:
         results[0] = results[-3] - results[-1];
-    } else if (production == prGrammar_production_by_name(grammar, (char*) "mul")) {
+        break;
+    case MUL:
         results[0] = results[-3] * results[-1];
-    } else if (production == prGrammar_production_by_name(grammar, (char*) "div")) {
+        break;
+    case DIV:
         results[0] = results[-3] / results[-1];
-    } else if (production == prGrammar_production_by_name(grammar, (char*) "unary_minus")) {
+        break;
+    case UNARY_MINUS:
         results[0] = - results[-1];
-    } else {
+        break;
+    case MAX:
+        results[0] = fmax(results[-3], results[-2]);
+        break;
+    case PASS_THROUGH:
         results[0] = results[-1];
+        break;
+    }
+    return;
+}
+
+/* the only list is that of the arguments of max after the first, each
+   of which is ", E", passed through; the attribute is their maximum */
+void list_synth_fn(unsigned list, unsigned count, const void* elements,
+                   void* attribute, void* extra) {
+    const attribute_t* const arguments = elements;
+    attribute_t* const result = attribute;
+    *result = -INFINITY;
+    for (unsigned i = 0; i < count; ++i) {
+        *result = fmax(*result, arguments[i]);
     }
     return;
 }
@@ -119,7 +164,7 @@ int main(void) {
     gsStack* val_table = NULL;
     unsigned* tokens = NULL;
     unsigned* vals = NULL;
-    unsigned* items = NULL;
+    operation_t* operations = NULL;
 
     ma_initialize();
 
@@ -140,18 +185,37 @@ int main(void) {
         printf("There was an error forming the SLR parser for the grammar.\n");
         goto end_label;
     }
+    /* S -> E and E -> num fall to the last case of production_synth_fn,
+       so they need not be reduced by at all */
+    prSLRParser_bypass_unit_productions(parser, grammar, NULL);
 
     char string[1024];
     printf("Enter an expression to calculate (using floating point numbers, "
-	   "+, -, *, / and brackets):\n");
+	   "+, -, *, /, max and brackets):\n");
     fgets(string, 1024, stdin);
     str_remove_trailing_newline_(string);
 
     val_table = gsStack_create(sizeof(attribute_t));
 
+    unsigned productions[PASS_THROUGH];
+    if (prGrammar_productions_by_names(grammar, PASS_THROUGH, operation_names,
+                                       productions) == false) {
+        printf("There was an error finding the productions of the grammar.\n");
+        goto end_label;
+    }
+    operations = MALLOC(prGrammar_num_of_productions(grammar)
+                        * sizeof(operation_t));
+    for (unsigned p = 0; p < prGrammar_num_of_productions(grammar); ++p) {
+        operations[p] = PASS_THROUGH;
+    }
+    for (unsigned o = 0; o < PASS_THROUGH; ++o) {
+        operations[productions[o]] = o;
+    }
+
     extra_t extra;
     extra.val_table = val_table;
-    extra.grammar = grammar;
+    extra.num_token = prGrammar_token_by_name(grammar, "num");
+    extra.operations = operations;
 
     const char* lex_end_pos;
     tokens = lexLexer_process(lexer, string, str_to_val_func, &extra, &vals,
@@ -162,24 +226,26 @@ int main(void) {
         goto end_label;
     }
 
+    /* the attributes are plain numbers, so parse and synthesize at once */
     const unsigned* prs_end_pos;
-    items = prSLRParser_parse(parser, tokens, &prs_end_pos);
+    attribute_t result;
+    const boolean parsed =
+        prSLRParser_parse_and_synthesize_lists(parser, grammar, tokens, vals,
+                                               sizeof(attribute_t),
+                                               terminal_synth_fn,
+                                               production_synth_fn,
+                                               list_synth_fn,
+                                               &extra, &result, &prs_end_pos);
 
-    if (items == NULL || *prs_end_pos != 0) {
+    if (parsed == false || *prs_end_pos != 0) {
         printf("There was an error parsing the expression.\n");
         goto end_label;
     }
 
-    attribute_t result;
-
-    prSLRParser_synthesize(parser, items, vals, sizeof(attribute_t),
-                           terminal_synth_fn, production_synth_fn, &extra,
-                           &result);
-
     printf("The result of the calculation is: %.20f\n", result);
 
     end_label:;
-    FREE(items);
+    FREE(operations);
     FREE(tokens);
     FREE(vals);
     gsStack_destroy(val_table);
@@ -0,0 +1,297 @@
+/*
+ * prgen writes the parse tables of a grammar out as static const C arrays,
+ * along with a prSLRParserTables named NAME pointing at them, so that
+ * prSLRParser_create_from_tables(&NAME) makes the parser at no cost.
+ *
+ * With -r, it writes a recursive-ascent parser instead: each LR state
+ * becomes a function switching on the lookahead to shift (calling the
+ * function of the next state) or reduce (returning through as many
+ * functions as the production has symbols), and then on the reduced
+ * non-terminal for the goto, so that the C call stack is the parse stack
+ * and no table is looked at; NAME_parse gives the same items as
+ * prSLRParser_parse, one at a time, to a callback.
+ *
+ * With -u, the unit productions of the grammar are bypassed first
+ * (see prSLRParser_bypass_unit_productions), so the synthesis should
+ * pass the attribute through for them; the regex meta-parser always
+ * bypasses them.
+ *
+ * usage:
+ *   prgen [-r] [-u] GRAMMAR_SPEC_FILE NAME > FILE   for a grammar specification
+ *   prgen [-r] @regex NAME > FILE                   for the regex meta-grammar
+ *
+ * it fails if the grammar is neither SLR nor LALR, so that a build
+ * running it stops on the conflicts.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "standard.h"
+#include "ma.h"
+#include "str.h"
+#include "parser.h"
+#include "regex.h"
+
+static void print_unsigneds(const char* name, const char* suffix,
+                            const unsigned* values, unsigned length) {
+    printf("static const unsigned %s_%s[] = {", name, suffix);
+    for (unsigned i = 0; i < length; ++i) {
+        printf(i % 12 == 0 ? "\n    %u," : " %u,", values[i]);
+    }
+    printf("\n};\n\n");
+    return;
+}
+
+static void print_tables(const prSLRParserTables* tables, const char* name,
+                         const char* source) {
+    const unsigned table_length = tables->num_of_states * tables->num_of_tokens;
+    printf("/* generated by tools/prgen from %s; do not edit */\n\n", source);
+    printf("static const boolean %s_sinks[] = {", name);
+    for (unsigned i = 0; i < tables->num_of_states; ++i) {
+        printf(i % 8 == 0 ? "\n    %s," : " %s,",
+               tables->sinks[i] == true ? "true" : "false");
+    }
+    printf("\n};\n\n");
+    print_unsigneds(name, "transition_table", tables->transition_table,
+                    table_length);
+    print_unsigneds(name, "bt_table", tables->bt_table, table_length);
+    print_unsigneds(name, "bt_list", tables->bt_list,
+                    2 * tables->num_of_productions);
+    printf("static const prSLRParserTables %s = {\n", name);
+    printf("    %u, %u, %u, %u, %u,\n", tables->num_of_states,
+           tables->num_of_tokens, tables->cosink, tables->reject,
+           tables->num_of_productions);
+    printf("    %s_sinks,\n    %s_transition_table,\n"
+           "    %s_bt_table,\n    %s_bt_list\n};\n", name, name, name, name);
+    return;
+}
+
+/* whether token is the head of some production */
+static boolean is_head(const prSLRParserTables* tables, unsigned token) {
+    for (unsigned i = 0; i < tables->num_of_productions; ++i) {
+        if (tables->bt_list[2 * i + 1] == token) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  marks the states the function of state calls, on a terminal lookahead
+  or on the head of a production, and the states those call, and so on;
+  is_reachable should be false for the states not marked yet
+*/
+static void mark_reachable(const prSLRParserTables* tables, unsigned state,
+                           boolean* is_reachable) {
+    is_reachable[state] = true;
+    if (tables->sinks[state] == true) {
+        return;
+    }
+    const unsigned* const transitions =
+        tables->transition_table + state * tables->num_of_tokens;
+    for (unsigned token = 1; token < tables->num_of_tokens; ++token) {
+        if (transitions[token] != tables->reject
+            && is_reachable[transitions[token]] == false) {
+            mark_reachable(tables, transitions[token], is_reachable);
+        }
+    }
+    return;
+}
+
+static void print_state_function(const prSLRParserTables* tables,
+                                 const char* name, unsigned state) {
+    const unsigned* const transitions =
+        tables->transition_table + state * tables->num_of_tokens;
+    const unsigned* const bts = tables->bt_table + state * tables->num_of_tokens;
+    printf("static unsigned %s_state_%u(%sParse* parse) {\n", name, state,
+           name);
+    if (tables->sinks[state] == true) {
+        printf("    parse->status = %s_ACCEPT;\n", name);
+        printf("    return %s_STOP;\n}\n\n", name);
+        return;
+    }
+    printf("    unsigned pops;\n");
+    printf("    switch (*parse->cursor) {\n");
+    /* the lookahead is a terminal, so the gotos on the non-terminals
+       are left to the switch on the head below */
+    for (unsigned token = 1; token < tables->num_of_tokens; ++token) {
+        if (transitions[token] != tables->reject
+            && is_head(tables, token) == false) {
+            printf("    case %u:\n", token);
+            printf("        parse->item_fn(%u, parse->extra);\n", token);
+            printf("        ++parse->cursor;\n");
+            printf("        pops = %s_state_%u(parse);\n", name,
+                   transitions[token]);
+            printf("        break;\n");
+        }
+    }
+    /* the reductions, with the lookaheads calling for each grouped */
+    for (unsigned bt = 1; bt <= tables->num_of_productions; ++bt) {
+        boolean any = false;
+        for (unsigned token = 0; token < tables->num_of_tokens; ++token) {
+            if (bts[token] == bt
+                && (token == 0 || transitions[token] == tables->reject)) {
+                printf("    case %u:\n", token);
+                any = true;
+            }
+        }
+        if (any == true) {
+            const unsigned body_length = tables->bt_list[2 * (bt - 1)];
+            printf("        parse->item_fn(%u, parse->extra);\n",
+                   tables->num_of_tokens + bt - 1);
+            printf("        parse->head = %u;\n",
+                   tables->bt_list[2 * (bt - 1) + 1]);
+            if (body_length == 0) {
+                printf("        pops = 0;\n");
+                printf("        break;\n");
+            } else {
+                printf("        return %u;\n", body_length - 1);
+            }
+        }
+    }
+    printf("    default:\n");
+    printf("        parse->status = %s_REJECT;\n", name);
+    printf("        return %s_STOP;\n", name);
+    printf("    }\n");
+    printf("    while (pops == 0) {\n");
+    printf("        switch (parse->head) {\n");
+    for (unsigned token = 1; token < tables->num_of_tokens; ++token) {
+        if (transitions[token] != tables->reject
+            && is_head(tables, token) == true) {
+            printf("        case %u:\n", token);
+            printf("            pops = %s_state_%u(parse);\n", name,
+                   transitions[token]);
+            printf("            break;\n");
+        }
+    }
+    printf("        default:\n");
+    printf("            parse->status = %s_REJECT;\n", name);
+    printf("            return %s_STOP;\n", name);
+    printf("        }\n");
+    printf("    }\n");
+    printf("    return pops == %s_STOP ? %s_STOP : pops - 1;\n", name, name);
+    printf("}\n\n");
+    return;
+}
+
+static void print_recursive_ascent(const prSLRParserTables* tables,
+                                   const char* name, const char* source) {
+    printf("/* generated by tools/prgen -r from %s; do not edit */\n\n",
+           source);
+    printf("typedef void (*%sItemFn)(unsigned item, void* extra);\n\n", name);
+    printf("typedef struct %sParse {\n", name);
+    printf("    const unsigned* cursor;\n");
+    printf("    %sItemFn item_fn;\n", name);
+    printf("    void* extra;\n");
+    printf("    /* the non-terminal just reduced to */\n");
+    printf("    unsigned head;\n");
+    printf("    unsigned status;\n");
+    printf("} %sParse;\n\n", name);
+    printf("enum {\n    %s_CONTINUE,\n    %s_ACCEPT,\n    %s_REJECT\n};\n\n",
+           name, name, name);
+    printf("/* returned all the way up once the parse stops */\n");
+    printf("#define %s_STOP ((unsigned) -1)\n\n", name);
+    /* only the states reachable from the cosink get a function, as those
+       left only by gotos on bypassed unit productions would be unused */
+    boolean* const is_reachable =
+        CALLOC(tables->num_of_states, sizeof(*is_reachable));
+    mark_reachable(tables, tables->cosink, is_reachable);
+    for (unsigned state = 0; state < tables->num_of_states; ++state) {
+        if (is_reachable[state] == true) {
+            printf("static unsigned %s_state_%u(%sParse* parse);\n", name,
+                   state, name);
+        }
+    }
+    printf("\n");
+    for (unsigned state = 0; state < tables->num_of_states; ++state) {
+        if (is_reachable[state] == true) {
+            print_state_function(tables, name, state);
+        }
+    }
+    FREE(is_reachable);
+    printf("/* parses tokens (0-terminated) as prSLRParser_parse would,\n"
+           "   passing the items to item_fn; returns whether it accepted */\n");
+    printf("static boolean %s_parse(const unsigned* tokens, %sItemFn item_fn,\n"
+           "                        void* extra, const unsigned** out_end_pos) {\n",
+           name, name);
+    printf("    %sParse parse;\n", name);
+    printf("    parse.cursor = tokens;\n");
+    printf("    parse.item_fn = item_fn;\n");
+    printf("    parse.extra = extra;\n");
+    printf("    parse.status = %s_CONTINUE;\n", name);
+    printf("    %s_state_%u(&parse);\n", name, tables->cosink);
+    printf("    *out_end_pos = parse.cursor;\n");
+    printf("    return parse.status == %s_ACCEPT;\n", name);
+    printf("}\n");
+    return;
+}
+
+int main(int argc, char** argv) {
+    const char* const program_name = argv[0];
+    boolean is_recursive_ascent = false;
+    boolean is_bypassing_unit_productions = false;
+    while (argc > 3) {
+        if (str_equal_to(argv[1], "-r") == true) {
+            is_recursive_ascent = true;
+        } else if (str_equal_to(argv[1], "-u") == true) {
+            is_bypassing_unit_productions = true;
+        } else {
+            break;
+        }
+        ++argv;
+        --argc;
+    }
+    if (argc != 3) {
+        fprintf(stderr,
+                "usage: %s [-r] [-u] GRAMMAR_SPEC_FILE|@regex NAME\n",
+                program_name);
+        return 1;
+    }
+    ma_initialize();
+    int status = 1;
+    prSLRParser* parser = NULL;
+    char diagnostic[2048] = "";
+    if (str_equal_to(argv[1], "@regex") == true) {
+        parser = (prSLRParser*) rexRegexSLRParser_create_from_spec();
+    } else {
+        char* const grammar_spec = str_read_file(argv[1]);
+        if (grammar_spec == NULL) {
+            fprintf(stderr, "There was an error reading %s.\n", argv[1]);
+            goto end_label;
+        }
+        prGrammar* const grammar =
+            prGrammar_create_from_spec(grammar_spec, diagnostic);
+        FREE(grammar_spec);
+        if (grammar == NULL) {
+            fprintf(stderr, "%s", diagnostic);
+            goto end_label;
+        }
+        parser = prSLRParser_create_from_grammar(grammar, diagnostic);
+        if (parser == NULL) {
+            parser = prSLRParser_create_lalr_from_grammar(grammar, diagnostic);
+        }
+        if (parser != NULL && is_bypassing_unit_productions == true) {
+            prSLRParser_bypass_unit_productions(parser, grammar, NULL);
+        }
+        prGrammar_destroy(grammar);
+    }
+    if (parser == NULL) {
+        fprintf(stderr, "%s", diagnostic);
+        goto end_label;
+    }
+    prSLRParserTables tables;
+    prSLRParser_get_tables(parser, &tables);
+    const char* const source =
+        argv[1][0] == '@' ? "the regex meta-grammar" : argv[1];
+    if (is_recursive_ascent == true) {
+        print_recursive_ascent(&tables, argv[2], source);
+    } else {
+        print_tables(&tables, argv[2], source);
+    }
+    prSLRParser_destroy(parser);
+    status = 0;
+    end_label:;
+    ma_finalize();
+    return status;
+}
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+# builds tools/prgen and regenerates the baked regex meta-parser tables
+
+gcc -std=c99 -Wall -Wextra -pedantic -I../include -o prgen ../src/standard.c ../src/err.c ../src/ma.c ../src/str.c ../src/gs.c ../src/ss.c ../src/fa.c ../src/parser.c ../src/regex.c prgen.c &&
+./prgen @regex rex_tables > ../src/regex_tables.h &&
+rm ./prgen